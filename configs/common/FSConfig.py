@@ -675,7 +675,9 @@ def makeDistRoot(testSystem,
                  sync_start,
                  linkspeed,
                  linkdelay,
-                 dumpfile):
+                 dumpfile,
+                 transport = 'tcp',
+                 sync_adaptive = False):
     self = Root(full_system = True)
     self.testsys = testSystem
 
@@ -685,8 +687,10 @@ def makeDistRoot(testSystem,
                                    dist_size = size,
                                    server_name = server_name,
                                    server_port = server_port,
+                                   transport = transport,
                                    sync_start = sync_start,
-                                   sync_repeat = sync_repeat)
+                                   sync_repeat = sync_repeat,
+                                   sync_adaptive = sync_adaptive)
 
     if hasattr(testSystem, 'realview'):
         self.etherlink.int0 = Parent.testsys.realview.ethernet.interface
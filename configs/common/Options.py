@@ -255,10 +255,17 @@ def addCommonOptions(parser):
                       default=2200,
                       action="store", type="int",
                       help="Message server listen port\nDEFAULT: 2200")
+    parser.add_option("--dist-transport", default="tcp",
+                      action="store", type="choice", choices=["tcp", "shm"],
+                      help="Transport among dist-gem5 processes, shm needs "\
+                      "all of them on the same host\nDEFAULT: tcp")
     parser.add_option("--dist-sync-repeat",
                       default="0us",
                       action="store", type="string",
                       help="Repeat interval for synchronisation barriers among dist-gem5 processes\nDEFAULT: --ethernet-linkdelay")
+    parser.add_option("--dist-sync-adaptive", action="store_true",
+                      help="Stretch the synchronisation barrier repeat "\
+                      "while no dist-gem5 process can send a packet")
     parser.add_option("--dist-sync-start",
                       default="5200000000000t",
                       action="store", type="string",
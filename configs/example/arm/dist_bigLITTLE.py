@@ -71,12 +71,19 @@ def addOptions(parser):
                       default=2200,
                       action="store", type=int,
                       help="Message server listen port\nDEFAULT: 2200")
+    parser.add_argument("--dist-transport", default="tcp",
+                      choices=["tcp", "shm"],
+                      help="Transport among dist-gem5 processes, shm needs"\
+                      " all of them on the same host\nDEFAULT: tcp")
     parser.add_argument("--dist-sync-repeat",
                       default="0us",
                       action="store", type=str,
                       help="Repeat interval for synchronisation barriers"\
                       " among dist-gem5 processes\nDEFAULT:"\
                       " --ethernet-linkdelay")
+    parser.add_argument("--dist-sync-adaptive", action="store_true",
+                      help="Stretch the synchronisation barrier repeat"\
+                      " while no dist-gem5 process can send a packet")
     parser.add_argument("--dist-sync-start",
                       default="1000000000000t",
                       action="store", type=str,
@@ -110,8 +117,11 @@ def addEthernet(system, options):
                                      dist_size = options.dist_size,
                                      server_name = options.dist_server_name,
                                      server_port = options.dist_server_port,
+                                     transport = options.dist_transport,
                                      sync_start = options.dist_sync_start,
-                                     sync_repeat = options.dist_sync_repeat)
+                                     sync_repeat = options.dist_sync_repeat,
+                                     sync_adaptive = \
+                                         options.dist_sync_adaptive)
     system.etherlink.int0 = Parent.system.ethernet.interface
     if options.etherdump:
         system.etherdump = EtherDump(file=options.etherdump)
@@ -0,0 +1,148 @@
+# Copyright (c) 2026 The gem-forge contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+# Microbenchmark of the SLICC generated controllers of the protocol gem5
+# was built with. The ruby random tester drives the caches, and the
+# number of transitions executed by all the controllers is reported
+# along with the host time spent simulating them.
+
+from __future__ import print_function
+from __future__ import absolute_import
+
+import m5
+from m5.objects import *
+from m5.defines import buildEnv
+from m5.util import addToPath, fatal
+import os, optparse, re, sys, time
+
+addToPath('../')
+
+from common import Options
+from ruby import Ruby
+
+parser = optparse.OptionParser()
+Options.addNoISAOptions(parser)
+
+parser.add_option("--maxloads", metavar="N", default=100000,
+                  help="Stop after N loads")
+parser.add_option("-f", "--wakeup_freq", metavar="N", default=10,
+                  help="Wakeup every N cycles")
+
+#
+# Add the ruby specific and protocol specific options
+#
+Ruby.define_options(parser)
+
+(options, args) = parser.parse_args()
+
+#
+# Use small caches so that most of the accesses miss and go through
+# the transient states of the protocol.
+#
+options.l1d_size="256B"
+options.l1i_size="256B"
+options.l2_size="512B"
+options.l3_size="1kB"
+options.l1d_assoc=2
+options.l1i_assoc=2
+options.l2_assoc=2
+options.l3_assoc=2
+
+if args:
+     print("Error: script doesn't take any positional arguments")
+     sys.exit(1)
+
+tester = RubyTester(check_flush = buildEnv['PROTOCOL'] == 'MOESI_hammer',
+                    checks_to_complete = options.maxloads,
+                    wakeup_frequency = options.wakeup_freq)
+
+system = System(cpu = tester, mem_ranges = [AddrRange(options.mem_size)])
+
+system.voltage_domain = VoltageDomain(voltage = options.sys_voltage)
+system.clk_domain = SrcClockDomain(clock = options.sys_clock,
+                                   voltage_domain = system.voltage_domain)
+
+Ruby.create_system(options, False, system)
+
+system.ruby.clk_domain = SrcClockDomain(clock = options.ruby_clock,
+                                        voltage_domain = system.voltage_domain)
+
+tester.num_cpus = len(system.ruby._cpu_ports)
+
+for ruby_port in system.ruby._cpu_ports:
+    if ruby_port.support_data_reqs and ruby_port.support_inst_reqs:
+        tester.cpuInstDataPort = ruby_port.slave
+    elif ruby_port.support_data_reqs:
+        tester.cpuDataPort = ruby_port.slave
+    elif ruby_port.support_inst_reqs:
+        tester.cpuInstPort = ruby_port.slave
+
+    ruby_port.no_retry_on_stall = True
+    ruby_port.using_ruby_tester = True
+
+root = Root( full_system = False, system = system )
+root.system.mem_mode = 'timing'
+
+m5.ticks.setGlobalFrequency('1ns')
+
+m5.instantiate()
+
+start = time.time()
+exit_event = m5.simulate(options.abs_max_tick)
+host_seconds = time.time() - start
+
+print('Exiting @ tick', m5.curTick(), 'because', exit_event.getCause())
+
+#
+# The controllers count their transitions per state and event, in
+# vectors with one element per controller of each type.
+#
+m5.stats.dump()
+
+stat_re = re.compile(r'^%s\.(\w+)_Controller\.(\w+)\.(\w+)(::total)?\s+(\d+)' %
+                     re.escape(system.ruby.path()))
+transitions = {}
+totals = set()
+with open(os.path.join(m5.options.outdir, m5.options.stats_file)) as stats:
+    for line in stats:
+        match = stat_re.match(line)
+        if not match:
+            continue
+        key = match.group(1, 2, 3)
+        if match.group(4):
+            transitions[key] = int(match.group(5))
+            totals.add(key)
+        elif key not in totals:
+            transitions[key] = int(match.group(5))
+
+if not transitions:
+    fatal("No transitions found in the stats")
+
+num_transitions = sum(transitions.values())
+print("Protocol:", buildEnv['PROTOCOL'])
+print("Transitions:", num_transitions)
+print("Host seconds: %.3f" % host_seconds)
+print("Transitions per host second: %.0f" % (num_transitions / host_seconds))
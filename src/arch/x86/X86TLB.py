@@ -52,7 +52,11 @@ class X86TLB(BaseTLB):
     type = 'X86TLB'
     cxx_class = 'X86ISA::TLB'
     cxx_header = 'arch/x86/tlb.hh'
-    size = Param.Unsigned(64, "TLB size")
+    size = Param.Unsigned(64, "TLB size (entries for 4KiB pages)")
+    assoc = Param.Unsigned(4, "TLB associativity")
+    large_size = Param.Unsigned(32, "Number of entries for 2MiB, 4MiB and "
+            "1GiB pages, 0 to keep them with the 4KiB ones")
+    large_assoc = Param.Unsigned(4, "Associativity of the large page entries")
     system = Param.System(Parent.any, "system object")
     walker = Param.X86PagetableWalker(\
             X86PagetableWalker(), "page table walker")
@@ -89,6 +89,13 @@ Decoder::process()
         instBytes->chunks.push_back(fetchChunk);
     }
 
+    // Most instructions fit in the chunk they start in, so try to take
+    // those in one step before falling back to going byte by byte.
+    if (state == PrefixState && instBytes->chunks.size() == 1 &&
+            basePC + offset == origPC) {
+        state = decodeInChunk();
+    }
+
     // While there's still something to do...
     while (!instDone && !outOfBytes) {
         uint8_t nextByte = getNextByte();
@@ -172,27 +179,132 @@ Decoder::doFromCacheState()
     }
 }
 
-// Either get a prefix and record it in the ExtMachInst, or send the
-// state machine on to get the opcode(s).
+// Decode an instruction which starts and ends within fetchChunk without
+// stepping through the state machine. This works on a copy of emi and only
+// commits it once the whole instruction has been found, so anything it
+// doesn't handle, like VEX encodings or instructions which run into the next
+// chunk, is left untouched for the state machine to decode from the start.
 Decoder::State
-Decoder::doPrefixState(uint8_t nextByte)
+Decoder::decodeInChunk()
+{
+    const int end = sizeof(MachInst);
+    const uint8_t *bytes = (const uint8_t *)&fetchChunk;
+    ExtMachInst inst = emi;
+    int pos = offset;
+
+    // Legacy and REX prefixes.
+    for (; pos < end; pos++) {
+        uint8_t prefix = lookupPrefix(inst, bytes[pos]);
+        if (!prefix)
+            break;
+        if (!processPrefix(inst, prefix, bytes[pos]))
+            return PrefixState;
+    }
+
+    // The opcode, including any escape bytes.
+    ByteTable *immTable = &ImmediateTypeOneByte;
+    ByteTable *modrmTable = &UsesModRMOneByte;
+    bool addrSizedImm = false;
+    if (pos == end)
+        return PrefixState;
+    uint8_t opcode = bytes[pos++];
+    if (opcode != 0x0f) {
+        inst.opcode.type = OneByteOpcode;
+        addrSizedImm = opcode >= 0xA0 && opcode <= 0xA3;
+    } else {
+        if (pos == end)
+            return PrefixState;
+        opcode = bytes[pos++];
+        if (opcode == 0x38 || opcode == 0x3a) {
+            if (opcode == 0x38) {
+                inst.opcode.type = ThreeByte0F38Opcode;
+                immTable = &ImmediateTypeThreeByte0F38;
+                modrmTable = &UsesModRMThreeByte0F38;
+            } else {
+                inst.opcode.type = ThreeByte0F3AOpcode;
+                immTable = &ImmediateTypeThreeByte0F3A;
+                modrmTable = &UsesModRMThreeByte0F3A;
+            }
+            if (pos == end)
+                return PrefixState;
+            opcode = bytes[pos++];
+        } else {
+            inst.opcode.type = TwoByteOpcode;
+            immTable = &ImmediateTypeTwoByte;
+            modrmTable = &UsesModRMTwoByte;
+        }
+    }
+    inst.opcode.op = opcode;
+
+    int immSize = processSizes(inst, *immTable, addrSizedImm);
+    int dispSize = 0;
+
+    // The ModRM and SIB bytes.
+    if ((*modrmTable)[opcode]) {
+        if (pos == end)
+            return PrefixState;
+        ModRM modRM = bytes[pos++];
+        processModRM(inst, modRM, dispSize, immSize);
+        inst.modRM = modRM;
+        if (modRM.rm == 4 && modRM.mod != 3) {
+            if (pos == end)
+                return PrefixState;
+            inst.sib = bytes[pos++];
+            if (modRM.mod == 0 && inst.sib.base == 5)
+                dispSize = 4;
+        }
+    }
+
+    // The displacement and immediate, sign extended the same way the state
+    // machine does it.
+    if (pos + dispSize + immSize > end)
+        return PrefixState;
+    if (dispSize) {
+        uint64_t disp = (fetchChunk >> (pos * 8)) & mask(dispSize * 8);
+        inst.displacement = sextDisplacement(disp, dispSize);
+        inst.dispSize = dispSize;
+        pos += dispSize;
+    }
+    if (immSize) {
+        uint64_t imm = (fetchChunk >> (pos * 8)) & mask(immSize * 8);
+        inst.immediate = sextImmediate(imm, immSize);
+        pos += immSize;
+    }
+
+    DPRINTF(Decoder, "Decoded %d byte instruction within the chunk.\n",
+            pos - offset);
+
+    emi = inst;
+    displacementSize = dispSize;
+    immediateSize = immSize;
+    immediateCollected = 0;
+    instDone = true;
+    consumeBytes(pos - offset);
+    return ResetState;
+}
+
+// Look up what kind of prefix a byte is, if any.
+uint8_t
+Decoder::lookupPrefix(const ExtMachInst &inst, uint8_t nextByte)
 {
     uint8_t prefix = Prefixes[nextByte];
-    State nextState = PrefixState;
     // REX prefixes are only recognized in 64 bit mode.
-    if (prefix == RexPrefix && emi.mode.submode != SixtyFourBitMode)
+    if (prefix == RexPrefix && inst.mode.submode != SixtyFourBitMode)
         prefix = 0;
-    if (prefix)
-        consumeByte();
+    return prefix;
+}
+
+// Record a legacy or REX prefix in an ExtMachInst.
+bool
+Decoder::processPrefix(ExtMachInst &inst, uint8_t prefix, uint8_t nextByte)
+{
     switch(prefix) {
         // Operand size override prefixes
       case OperandSizeOverride:
-        DPRINTF(Decoder, "Found operand size override prefix.\n");
-        emi.legacy.op = true;
+        inst.legacy.op = true;
         break;
       case AddressSizeOverride:
-        DPRINTF(Decoder, "Found address size override prefix.\n");
-        emi.legacy.addr = true;
+        inst.legacy.addr = true;
         break;
         // Segment override prefixes
       case CSOverride:
@@ -201,25 +313,40 @@ Decoder::doPrefixState(uint8_t nextByte)
       case FSOverride:
       case GSOverride:
       case SSOverride:
-        DPRINTF(Decoder, "Found segment override.\n");
-        emi.legacy.seg = prefix;
+        inst.legacy.seg = prefix;
         break;
       case Lock:
-        DPRINTF(Decoder, "Found lock prefix.\n");
-        emi.legacy.lock = true;
+        inst.legacy.lock = true;
         break;
       case Rep:
-        DPRINTF(Decoder, "Found rep prefix.\n");
-        emi.legacy.rep = true;
+        inst.legacy.rep = true;
         break;
       case Repne:
-        DPRINTF(Decoder, "Found repne prefix.\n");
-        emi.legacy.repne = true;
+        inst.legacy.repne = true;
         break;
       case RexPrefix:
-        DPRINTF(Decoder, "Found Rex prefix %#x.\n", nextByte);
-        emi.rex = nextByte;
+        inst.rex = nextByte;
         break;
+      default:
+        return false;
+    }
+    return true;
+}
+
+// Either get a prefix and record it in the ExtMachInst, or send the
+// state machine on to get the opcode(s).
+Decoder::State
+Decoder::doPrefixState(uint8_t nextByte)
+{
+    uint8_t prefix = lookupPrefix(emi, nextByte);
+    State nextState = PrefixState;
+    if (prefix)
+        consumeByte();
+    if (processPrefix(emi, prefix, nextByte)) {
+        DPRINTF(Decoder, "Found prefix %#x.\n", nextByte);
+        return nextState;
+    }
+    switch(prefix) {
       case Vex2Prefix:
         DPRINTF(Decoder, "Found VEX two-byte prefix %#x.\n", nextByte);
         emi.vex.present = 1;
@@ -452,91 +579,108 @@ Decoder::processOpcode(ByteTable &immTable, ByteTable &modrmTable,
     State nextState = ErrorState;
     const uint8_t opcode = emi.opcode.op;
 
+    immediateSize = processSizes(emi, immTable, addrSizedImm);
+
+    // Determine what to expect next.
+    if (modrmTable[opcode]) {
+        nextState = ModRMState;
+    } else {
+        if (immediateSize) {
+            nextState = ImmediateState;
+        } else {
+            instDone = true;
+            nextState = ResetState;
+        }
+    }
+    return nextState;
+}
+
+// Set the operand, address and stack sizes of an instruction, and work out
+// how big its immediate is from its opcode.
+int
+Decoder::processSizes(ExtMachInst &inst, ByteTable &immTable,
+                      bool addrSizedImm)
+{
     // Figure out the effective operand size. This can be overriden to
     // a fixed value at the decoder level.
     int logOpSize;
-    if (emi.rex.w)
+    if (inst.rex.w)
         logOpSize = 3; // 64 bit operand size
-    else if (emi.legacy.op)
+    else if (inst.legacy.op)
         logOpSize = altOp;
     else
         logOpSize = defOp;
 
     // Set the actual op size.
-    emi.opSize = 1 << logOpSize;
+    inst.opSize = 1 << logOpSize;
 
     // Figure out the effective address size. This can be overriden to
     // a fixed value at the decoder level.
     int logAddrSize;
-    if (emi.legacy.addr)
+    if (inst.legacy.addr)
         logAddrSize = altAddr;
     else
         logAddrSize = defAddr;
 
     // Set the actual address size.
-    emi.addrSize = 1 << logAddrSize;
+    inst.addrSize = 1 << logAddrSize;
 
     // Figure out the effective stack width. This can be overriden to
     // a fixed value at the decoder level.
-    emi.stackSize = 1 << stack;
+    inst.stackSize = 1 << stack;
 
     // Figure out how big of an immediate we'll retreive based
     // on the opcode.
-    int immType = immTable[opcode];
+    int immType = immTable[inst.opcode.op];
     if (addrSizedImm)
-        immediateSize = SizeTypeToSize[logAddrSize - 1][immType];
+        return SizeTypeToSize[logAddrSize - 1][immType];
     else
-        immediateSize = SizeTypeToSize[logOpSize - 1][immType];
-
-    // Determine what to expect next.
-    if (modrmTable[opcode]) {
-        nextState = ModRMState;
-    } else {
-        if (immediateSize) {
-            nextState = ImmediateState;
-        } else {
-            instDone = true;
-            nextState = ResetState;
-        }
-    }
-    return nextState;
+        return SizeTypeToSize[logOpSize - 1][immType];
 }
 
-// Get the ModRM byte and determine what displacement, if any, there is.
-// Also determine whether or not to get the SIB byte, displacement, or
-// immediate next.
-Decoder::State
-Decoder::doModRMState(uint8_t nextByte)
+// Work out what displacement, if any, a ModRM byte implies.
+void
+Decoder::processModRM(const ExtMachInst &inst, ModRM modRM,
+                      int &dispSize, int &immSize)
 {
-    State nextState = ErrorState;
-    ModRM modRM = nextByte;
-    DPRINTF(Decoder, "Found modrm byte %#x.\n", nextByte);
     if (defOp == 1) {
         // Figure out 16 bit displacement size.
         if ((modRM.mod == 0 && modRM.rm == 6) || modRM.mod == 2)
-            displacementSize = 2;
+            dispSize = 2;
         else if (modRM.mod == 1)
-            displacementSize = 1;
+            dispSize = 1;
         else
-            displacementSize = 0;
+            dispSize = 0;
     } else {
         // Figure out 32/64 bit displacement size.
         if ((modRM.mod == 0 && modRM.rm == 5) || modRM.mod == 2)
-            displacementSize = 4;
+            dispSize = 4;
         else if (modRM.mod == 1)
-            displacementSize = 1;
+            dispSize = 1;
         else
-            displacementSize = 0;
+            dispSize = 0;
     }
 
     // The "test" instruction in group 3 needs an immediate, even though
     // the other instructions with the same actual opcode don't.
-    if (emi.opcode.type == OneByteOpcode && (modRM.reg & 0x6) == 0) {
-       if (emi.opcode.op == 0xF6)
-           immediateSize = 1;
-       else if (emi.opcode.op == 0xF7)
-           immediateSize = (emi.opSize == 8) ? 4 : emi.opSize;
+    if (inst.opcode.type == OneByteOpcode && (modRM.reg & 0x6) == 0) {
+       if (inst.opcode.op == 0xF6)
+           immSize = 1;
+       else if (inst.opcode.op == 0xF7)
+           immSize = (inst.opSize == 8) ? 4 : inst.opSize;
     }
+}
+
+// Get the ModRM byte and determine what displacement, if any, there is.
+// Also determine whether or not to get the SIB byte, displacement, or
+// immediate next.
+Decoder::State
+Decoder::doModRMState(uint8_t nextByte)
+{
+    State nextState = ErrorState;
+    ModRM modRM = nextByte;
+    DPRINTF(Decoder, "Found modrm byte %#x.\n", nextByte);
+    processModRM(emi, modRM, displacementSize, immediateSize);
 
     // If there's an SIB, get that next.
     // There is no SIB in 16 bit mode.
@@ -580,6 +724,45 @@ Decoder::doSIBState(uint8_t nextByte)
     return nextState;
 }
 
+// Sign extend a displacement once all of it has been collected.
+uint64_t
+Decoder::sextDisplacement(uint64_t disp, int size)
+{
+    switch(size)
+    {
+      case 1:
+        return sext<8>(disp);
+      case 2:
+        return sext<16>(disp);
+      case 4:
+        return sext<32>(disp);
+      default:
+        panic("Undefined displacement size!\n");
+    }
+}
+
+// Sign extend an immediate once all of it has been collected.
+uint64_t
+Decoder::sextImmediate(uint64_t imm, int size)
+{
+    //XXX Warning! The following is an observed pattern and might
+    // not always be true!
+
+    // Instructions which use 64 bit operands but 32 bit immediates
+    // need to have the immediate sign extended to 64 bits.
+    // Instructions which use true 64 bit immediates won't be
+    // affected, and instructions that use true 32 bit immediates
+    // won't notice.
+    switch(size) {
+      case 4:
+        return sext<32>(imm);
+      case 1:
+        return sext<8>(imm);
+      default:
+        return imm;
+    }
+}
+
 // Gather up the displacement, or at least as much of it as we can get.
 Decoder::State
 Decoder::doDisplacementState()
@@ -596,21 +779,8 @@ Decoder::doDisplacementState()
     if (displacementSize == immediateCollected) {
         // Reset this for other immediates.
         immediateCollected = 0;
-        // Sign extend the displacement.
-        switch(displacementSize)
-        {
-          case 1:
-            emi.displacement = sext<8>(emi.displacement);
-            break;
-          case 2:
-            emi.displacement = sext<16>(emi.displacement);
-            break;
-          case 4:
-            emi.displacement = sext<32>(emi.displacement);
-            break;
-          default:
-            panic("Undefined displacement size!\n");
-        }
+        emi.displacement = sextDisplacement(emi.displacement,
+                                            displacementSize);
         DPRINTF(Decoder, "Collected displacement %#x.\n",
                 emi.displacement);
         if (immediateSize) {
@@ -642,21 +812,7 @@ Decoder::doImmediateState()
         // Reset this for other immediates.
         immediateCollected = 0;
 
-        //XXX Warning! The following is an observed pattern and might
-        // not always be true!
-
-        // Instructions which use 64 bit operands but 32 bit immediates
-        // need to have the immediate sign extended to 64 bits.
-        // Instructions which use true 64 bit immediates won't be
-        // affected, and instructions that use true 32 bit immediates
-        // won't notice.
-        switch(immediateSize) {
-          case 4:
-            emi.immediate = sext<32>(emi.immediate);
-            break;
-          case 1:
-            emi.immediate = sext<8>(emi.immediate);
-        }
+        emi.immediate = sextImmediate(emi.immediate, immediateSize);
 
         DPRINTF(Decoder, "Collected immediate %#x.\n",
                 emi.immediate);
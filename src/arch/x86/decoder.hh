@@ -31,6 +31,7 @@
 
 #include <cassert>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "arch/generic/decoder.hh"
@@ -223,6 +224,27 @@ class Decoder : public InstDecoder
     // Process the actual opcode found earlier, using the supplied tables.
     State processOpcode(ByteTable &immTable, ByteTable &modrmTable,
                         bool addrSizedImm = false);
+    // Work out the operand, address and stack sizes of an instruction, and
+    // return the size of its immediate.
+    int processSizes(ExtMachInst &inst, ByteTable &immTable,
+                     bool addrSizedImm);
+    // Work out the displacement size implied by a ModRM byte, and fix up
+    // the immediate size of the instructions which depend on it.
+    void processModRM(const ExtMachInst &inst, ModRM modRM,
+                      int &dispSize, int &immSize);
+    // Work out what kind of prefix a byte is in the current mode, if any.
+    static uint8_t lookupPrefix(const ExtMachInst &inst, uint8_t nextByte);
+    // Record a legacy or REX prefix in an ExtMachInst. Returns false for
+    // anything else, which the caller has to deal with itself.
+    static bool processPrefix(ExtMachInst &inst, uint8_t prefix,
+                              uint8_t nextByte);
+    // Sign extend a fully collected displacement or immediate.
+    static uint64_t sextDisplacement(uint64_t disp, int size);
+    static uint64_t sextImmediate(uint64_t imm, int size);
+    // Decode a whole instruction which lies within the current chunk in
+    // one go. If it doesn't (or is too unusual), nothing is consumed and
+    // the state machine has to take it from the start.
+    State decodeInChunk();
     // Process the opcode found with VEX / XOP prefix.
     State processExtendedOpcode(ByteTable &immTable);
 
@@ -282,6 +304,16 @@ class Decoder : public InstDecoder
     void
     takeOverFrom(Decoder *old)
     {
+        // The old CPU is switched out, so give its decode caches to the new
+        // one rather than starting from a cold cache. They are handed back
+        // when the old CPU takes over again.
+        std::swap(addrCacheMap, old->addrCacheMap);
+        std::swap(decodePages, old->decodePages);
+        instMap = old->instMap;
+        instBytes = &dummy;
+        old->instBytes = &dummy;
+        state = ResetState;
+
         mode = old->mode;
         submode = old->submode;
         emi.mode.mode = mode;
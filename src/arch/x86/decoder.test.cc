@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+
+#include "arch/x86/decoder.hh"
+#include "arch/x86/regs/misc.hh"
+
+using namespace X86ISA;
+
+namespace
+{
+
+// A decoder which hands back the ExtMachInst it found, without going on to
+// build a StaticInst for it.
+class TestDecoder : public Decoder
+{
+  public:
+    // Decode the instruction at pc out of mem, which holds the bytes
+    // starting at memBase. Returns the instruction and its size.
+    ExtMachInst
+    decodeAt(const std::vector<uint8_t> &mem, Addr memBase, Addr pc,
+             int &size)
+    {
+        PCState pcState(pc);
+        Addr fetchPC = pc & ~(Addr)(sizeof(MachInst) - 1);
+        moreBytes(pcState, fetchPC, chunkAt(mem, memBase, fetchPC));
+        while (needMoreBytes() && !instReady()) {
+            fetchPC += sizeof(MachInst);
+            moreBytes(pcState, fetchPC, chunkAt(mem, memBase, fetchPC));
+        }
+        EXPECT_TRUE(instReady());
+        size = basePC + offset - origPC;
+        instDone = false;
+        return emi;
+    }
+
+  private:
+    static MachInst
+    chunkAt(const std::vector<uint8_t> &mem, Addr memBase, Addr fetchPC)
+    {
+        MachInst chunk;
+        std::memcpy(&chunk, &mem[fetchPC - memBase], sizeof(chunk));
+        return chunk;
+    }
+};
+
+// A random byte, biased towards prefixes and escape bytes so that they
+// show up in useful numbers. XOP (0x8F) and EVEX (0x62) are left out as
+// this decoder doesn't handle them.
+uint8_t
+randomByte(std::mt19937_64 &rng)
+{
+    static const uint8_t prefixes[] = {
+        0x66, 0x67, 0xf0, 0xf2, 0xf3, 0x2e, 0x26, 0x64, 0x65, 0x3e, 0x36,
+        0x48, 0x41, 0x4c, 0xc4, 0xc5
+    };
+    switch (rng() % 10) {
+      case 0:
+        return prefixes[rng() % sizeof(prefixes)];
+      case 1:
+        return 0x0f;
+      default: {
+        uint8_t byte = rng();
+        return (byte == 0x8f || byte == 0x62) ? 0x90 : byte;
+      }
+    }
+}
+
+// Decode random instructions once where they start a chunk, which lets the
+// decoder find most of them within that chunk in one go, and once where
+// they start at the last byte of a chunk, which sends everything but one
+// byte instructions through the byte by byte state machine. Both have to
+// come up with the same instruction.
+void
+checkChunkDecode(int mode, int submode, int defOp, int altOp,
+                 int defAddr, int altAddr, int stack)
+{
+    HandyM5Reg m5Reg = 0;
+    m5Reg.mode = mode;
+    m5Reg.submode = submode;
+    m5Reg.defOp = defOp;
+    m5Reg.altOp = altOp;
+    m5Reg.defAddr = defAddr;
+    m5Reg.altAddr = altAddr;
+    m5Reg.stack = stack;
+
+    TestDecoder decoder;
+    decoder.setM5Reg(m5Reg);
+
+    std::mt19937_64 rng(m5Reg);
+    const Addr inChunkBase = 0x1000;
+    const Addr straddleBase = 0x2000;
+    const Addr straddlePC = straddleBase + sizeof(MachInst) - 1;
+    std::vector<uint8_t> inChunk(8 * sizeof(MachInst));
+    std::vector<uint8_t> straddle(8 * sizeof(MachInst));
+
+    for (int i = 0; i < 100000; i++) {
+        for (auto &byte : straddle)
+            byte = randomByte(rng);
+        std::copy(straddle.begin() + sizeof(MachInst) - 1, straddle.end(),
+                  inChunk.begin());
+
+        int inChunkSize, straddleSize;
+        ExtMachInst inChunkInst = decoder.decodeAt(
+                inChunk, inChunkBase, inChunkBase, inChunkSize);
+        ExtMachInst straddleInst = decoder.decodeAt(
+                straddle, straddleBase, straddlePC, straddleSize);
+
+        ASSERT_EQ(inChunkSize, straddleSize);
+        ASSERT_EQ(inChunkInst, straddleInst);
+    }
+}
+
+} // anonymous namespace
+
+TEST(X86DecoderTest, ChunkDecodeMatchesLongMode)
+{
+    checkChunkDecode(LongMode, SixtyFourBitMode, 2, 1, 3, 2, 3);
+}
+
+TEST(X86DecoderTest, ChunkDecodeMatchesProtectedMode)
+{
+    checkChunkDecode(LegacyMode, ProtectedMode, 2, 1, 2, 1, 2);
+}
+
+TEST(X86DecoderTest, ChunkDecodeMatchesSixteenBitMode)
+{
+    checkChunkDecode(LegacyMode, ProtectedMode, 1, 2, 1, 2, 1);
+}
+
+TEST(X86DecoderTest, ChunkDecodeMatchesRealMode)
+{
+    checkChunkDecode(LegacyMode, RealMode, 1, 2, 1, 2, 1);
+}
@@ -46,20 +46,12 @@
 #include "arch/x86/isa_traits.hh"
 #include "base/bitunion.hh"
 #include "base/types.hh"
-#include "base/trie.hh"
 #include "debug/MMU.hh"
 #include "mem/port_proxy.hh"
 
 class Checkpoint;
 class ThreadContext;
 
-namespace X86ISA
-{
-    struct TlbEntry;
-}
-
-typedef Trie<Addr, X86ISA::TlbEntry> TlbEntryTrie;
-
 namespace X86ISA
 {
     struct TlbEntry : public Serializable
@@ -91,8 +83,6 @@ namespace X86ISA
         // A sequence number to keep track of LRU.
         uint64_t lruSeq;
 
-        TlbEntryTrie::Handle trieHandle;
-
         TlbEntry(Addr asn, Addr _vaddr, Addr _paddr,
                  bool uncacheable, bool read_only);
         TlbEntry();
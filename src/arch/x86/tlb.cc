@@ -59,70 +59,153 @@
 
 namespace X86ISA {
 
-TLB::TLB(const Params *p)
-    : BaseTLB(p), configAddress(0), size(p->size),
-      tlb(size), lruSeq(0), m5opRange(p->system->m5opRange()), stats(this)
+void
+TlbArray::init(unsigned size, unsigned _assoc)
 {
-    if (!size)
-        fatal("TLBs must have a non-zero size.\n");
+    fatal_if(!_assoc || _assoc > 64,
+             "TLB associativity must be between 1 and 64.\n");
+    fatal_if(size % _assoc,
+             "TLB size %d is not a multiple of its associativity %d.\n",
+             size, _assoc);
+    fatal_if(!isPowerOf2(size / _assoc),
+             "TLB number of sets (%d) must be a power of 2.\n",
+             size / _assoc);
+
+    assoc = _assoc;
+    numSets = size / assoc;
+    allWays = mask(assoc);
+    entries.resize(size);
+    valid.assign(numSets, 0);
+    mru.assign(numSets, 0);
+}
 
-    for (int x = 0; x < size; x++) {
-        tlb[x].trieHandle = NULL;
-        freeList.push_back(&tlb[x]);
+void
+TlbArray::remove(unsigned set, unsigned way)
+{
+    valid[set] &= ~(1ULL << way);
+    mru[set] &= ~(1ULL << way);
+    count--;
+}
+
+TlbEntry *
+TlbArray::lookup(Addr va, bool update_lru)
+{
+    for (uint64_t sizes = logSizes; sizes; sizes &= sizes - 1) {
+        const unsigned log_bytes = findLsbSet(sizes);
+        const unsigned set = setIndex(va, log_bytes);
+        for (uint64_t bits = valid[set]; bits; bits &= bits - 1) {
+            const unsigned way = findLsbSet(bits);
+            TlbEntry &entry = entries[set * assoc + way];
+            if (entry.logBytes == log_bytes &&
+                    ((entry.vaddr ^ va) >> log_bytes) == 0) {
+                if (update_lru)
+                    touch(set, way);
+                return &entry;
+            }
+        }
     }
+    return NULL;
+}
 
-    walker = p->walker;
-    walker->setTLB(this);
+TlbEntry *
+TlbArray::insert(Addr vpn, const TlbEntry &entry)
+{
+    const unsigned set = setIndex(vpn, entry.logBytes);
+
+    unsigned way;
+    if (valid[set] != allWays) {
+        way = findLsbSet(~valid[set] & allWays);
+        count++;
+    } else {
+        way = findLsbSet(~mru[set] & allWays);
+    }
+
+    TlbEntry *new_entry = &entries[set * assoc + way];
+    *new_entry = entry;
+    new_entry->vaddr = vpn;
+    valid[set] |= 1ULL << way;
+    touch(set, way);
+    logSizes |= 1ULL << entry.logBytes;
+    return new_entry;
 }
 
 void
-TLB::evictLRU()
+TlbArray::flush(bool keep_global)
 {
-    // Find the entry with the lowest (and hence least recently updated)
-    // sequence number.
+    for (unsigned set = 0; set < numSets; set++) {
+        for (uint64_t bits = valid[set]; bits; bits &= bits - 1) {
+            const unsigned way = findLsbSet(bits);
+            if (!keep_global || !entries[set * assoc + way].global)
+                remove(set, way);
+        }
+    }
+    if (!count)
+        logSizes = 0;
+}
 
-    unsigned lru = 0;
-    for (unsigned i = 1; i < size; i++) {
-        if (tlb[i].lruSeq < tlb[lru].lruSeq)
-            lru = i;
+void
+TlbArray::demap(Addr va)
+{
+    for (uint64_t sizes = logSizes; sizes; sizes &= sizes - 1) {
+        const unsigned log_bytes = findLsbSet(sizes);
+        const unsigned set = setIndex(va, log_bytes);
+        for (uint64_t bits = valid[set]; bits; bits &= bits - 1) {
+            const unsigned way = findLsbSet(bits);
+            const TlbEntry &entry = entries[set * assoc + way];
+            if (entry.logBytes == log_bytes &&
+                    ((entry.vaddr ^ va) >> log_bytes) == 0) {
+                remove(set, way);
+            }
+        }
     }
+}
+
+TLB::TLB(const Params *p)
+    : BaseTLB(p), configAddress(0), size(p->size), lastEntry(NULL),
+      lruSeq(0), m5opRange(p->system->m5opRange()), stats(this)
+{
+    if (!size)
+        fatal("TLBs must have a non-zero size.\n");
+
+    smallPages.init(size, std::min(p->assoc, size));
+    if (p->large_size)
+        largePages.init(p->large_size, std::min(p->large_assoc,
+                                                p->large_size));
 
-    assert(tlb[lru].trieHandle);
-    trie.remove(tlb[lru].trieHandle);
-    tlb[lru].trieHandle = NULL;
-    freeList.push_back(&tlb[lru]);
+    walker = p->walker;
+    walker->setTLB(this);
 }
 
 TlbEntry *
 TLB::insert(Addr vpn, const TlbEntry &entry)
 {
     // If somebody beat us to it, just use that existing entry.
-    TlbEntry *newEntry = trie.lookup(vpn);
+    TlbEntry *newEntry = lookup(vpn, false);
     if (newEntry) {
         assert(newEntry->vaddr == vpn);
         return newEntry;
     }
 
-    if (freeList.empty())
-        evictLRU();
-
-    newEntry = freeList.front();
-    freeList.pop_front();
-
-    *newEntry = entry;
+    newEntry = arrayFor(entry.logBytes).insert(vpn, entry);
     newEntry->lruSeq = nextSeq();
-    newEntry->vaddr = vpn;
-    newEntry->trieHandle =
-    trie.insert(vpn, TlbEntryTrie::MaxBits - entry.logBytes, newEntry);
     return newEntry;
 }
 
 TlbEntry *
 TLB::lookup(Addr va, bool update_lru)
 {
-    TlbEntry *entry = trie.lookup(va);
-    if (entry && update_lru)
-        entry->lruSeq = nextSeq();
+    if (lastEntry && ((lastEntry->vaddr ^ va) >> lastEntry->logBytes) == 0) {
+        // Keep the replacement state as if the arrays had been probed
+        if (update_lru)
+            arrayFor(lastEntry->logBytes).touch(lastEntry);
+        return lastEntry;
+    }
+
+    TlbEntry *entry = smallPages.lookup(va, update_lru);
+    if (!entry && largePages.capacity())
+        entry = largePages.lookup(va, update_lru);
+    if (entry)
+        lastEntry = entry;
     return entry;
 }
 
@@ -130,13 +213,9 @@ void
 TLB::flushAll()
 {
     DPRINTF(TLB, "Invalidating all entries.\n");
-    for (unsigned i = 0; i < size; i++) {
-        if (tlb[i].trieHandle) {
-            trie.remove(tlb[i].trieHandle);
-            tlb[i].trieHandle = NULL;
-            freeList.push_back(&tlb[i]);
-        }
-    }
+    smallPages.flush(false);
+    largePages.flush(false);
+    lastEntry = NULL;
 }
 
 void
@@ -149,24 +228,17 @@ void
 TLB::flushNonGlobal()
 {
     DPRINTF(TLB, "Invalidating all non global entries.\n");
-    for (unsigned i = 0; i < size; i++) {
-        if (tlb[i].trieHandle && !tlb[i].global) {
-            trie.remove(tlb[i].trieHandle);
-            tlb[i].trieHandle = NULL;
-            freeList.push_back(&tlb[i]);
-        }
-    }
+    smallPages.flush(true);
+    largePages.flush(true);
+    lastEntry = NULL;
 }
 
 void
 TLB::demapPage(Addr va, uint64_t asn)
 {
-    TlbEntry *entry = trie.lookup(va);
-    if (entry) {
-        trie.remove(entry->trieHandle);
-        entry->trieHandle = NULL;
-        freeList.push_back(entry);
-    }
+    smallPages.demap(va);
+    largePages.demap(va);
+    lastEntry = NULL;
 }
 
 namespace
@@ -531,15 +603,16 @@ void
 TLB::serialize(CheckpointOut &cp) const
 {
     // Only store the entries in use.
-    uint32_t _size = size - freeList.size();
+    uint32_t _size = smallPages.size() + largePages.size();
     SERIALIZE_SCALAR(_size);
     SERIALIZE_SCALAR(lruSeq);
 
     uint32_t _count = 0;
-    for (uint32_t x = 0; x < size; x++) {
-        if (tlb[x].trieHandle != NULL)
-            tlb[x].serializeSection(cp, csprintf("Entry%d", _count++));
-    }
+    auto serialize_entry = [&](const TlbEntry &entry) {
+        entry.serializeSection(cp, csprintf("Entry%d", _count++));
+    };
+    smallPages.forEach(serialize_entry);
+    largePages.forEach(serialize_entry);
 }
 
 void
@@ -548,19 +621,20 @@ TLB::unserialize(CheckpointIn &cp)
     // Do not allow to restore with a smaller tlb.
     uint32_t _size;
     UNSERIALIZE_SCALAR(_size);
-    if (_size > size) {
+    if (_size > smallPages.capacity() + largePages.capacity()) {
         fatal("TLB size less than the one in checkpoint!");
     }
 
     UNSERIALIZE_SCALAR(lruSeq);
 
+    // Entries go through the normal insertion path, so a checkpoint taken
+    // with a different geometry may lose a few of them to conflicts.
+    lastEntry = NULL;
     for (uint32_t x = 0; x < _size; x++) {
-        TlbEntry *newEntry = freeList.front();
-        freeList.pop_front();
-
-        newEntry->unserializeSection(cp, csprintf("Entry%d", x));
-        newEntry->trieHandle = trie.insert(newEntry->vaddr,
-            TlbEntryTrie::MaxBits - newEntry->logBytes, newEntry);
+        TlbEntry entry;
+        entry.unserializeSection(cp, csprintf("Entry%d", x));
+        uint64_t seq = entry.lruSeq;
+        arrayFor(entry.logBytes).insert(entry.vaddr, entry)->lruSeq = seq;
     }
 }
 
@@ -38,12 +38,12 @@
 #ifndef __ARCH_X86_TLB_HH__
 #define __ARCH_X86_TLB_HH__
 
-#include <list>
 #include <vector>
 
 #include "arch/generic/tlb.hh"
+#include "arch/x86/isa_traits.hh"
 #include "arch/x86/pagetable.hh"
-#include "base/trie.hh"
+#include "base/bitfield.hh"
 #include "mem/request.hh"
 #include "params/X86TLB.hh"
 #include "sim/stats.hh"
@@ -54,13 +54,98 @@ namespace X86ISA
 {
     class Walker;
 
+    /**
+     * A set associative array of TLB entries. Entries of different page
+     * sizes can share an array; each one is indexed by the page number
+     * at its own size, so a lookup probes one set per page size that is
+     * present. Replacement is bit-PLRU: every way has an MRU bit which is
+     * set when it is used, and all the other bits of the set are cleared
+     * once they would all be set. The victim is the first invalid way, or
+     * else the first way whose MRU bit is clear.
+     */
+    class TlbArray
+    {
+      protected:
+        std::vector<TlbEntry> entries;
+
+        /// Per set bitmaps of the valid and recently used ways
+        std::vector<uint64_t> valid;
+        std::vector<uint64_t> mru;
+
+        unsigned numSets;
+        unsigned assoc;
+        uint64_t allWays;
+
+        /// Bitmap of the page sizes (as log2 of bytes) in the array
+        uint64_t logSizes;
+
+        /// Number of valid entries
+        unsigned count;
+
+        unsigned
+        setIndex(Addr va, unsigned log_bytes) const
+        {
+            return (va >> log_bytes) & (numSets - 1);
+        }
+
+        void
+        touch(unsigned set, unsigned way)
+        {
+            uint64_t bits = mru[set] | (1ULL << way);
+            mru[set] = bits == allWays ? (1ULL << way) : bits;
+        }
+
+        void remove(unsigned set, unsigned way);
+
+      public:
+        TlbArray() : numSets(0), assoc(0), allWays(0), logSizes(0),
+                     count(0)
+        {}
+
+        void init(unsigned size, unsigned _assoc);
+
+        unsigned capacity() const { return entries.size(); }
+        unsigned size() const { return count; }
+
+        TlbEntry *lookup(Addr va, bool update_lru);
+
+        /// Mark an entry of this array as recently used
+        void
+        touch(const TlbEntry *entry)
+        {
+            const unsigned idx = entry - entries.data();
+            touch(idx / assoc, idx % assoc);
+        }
+
+        /**
+         * Insert an entry, evicting the PLRU way of its set if the set is
+         * full.
+         */
+        TlbEntry *insert(Addr vpn, const TlbEntry &entry);
+
+        /// Invalidate all the entries, or only the non global ones
+        void flush(bool keep_global);
+
+        /// Invalidate the entries translating an address
+        void demap(Addr va);
+
+        /// Call a function on each valid entry
+        template <typename F>
+        void
+        forEach(F f) const
+        {
+            for (unsigned set = 0; set < numSets; set++) {
+                for (uint64_t bits = valid[set]; bits; bits &= bits - 1)
+                    f(entries[set * assoc + findLsbSet(bits)]);
+            }
+        }
+    };
+
     class TLB : public BaseTLB
     {
       protected:
         friend class Walker;
 
-        typedef std::list<TlbEntry *> EntryList;
-
         uint32_t configAddress;
 
       public:
@@ -76,8 +161,6 @@ namespace X86ISA
 
       protected:
 
-        EntryList::iterator lookupIt(Addr va, bool update_lru = true);
-
         Walker * walker;
 
       public:
@@ -92,11 +175,31 @@ namespace X86ISA
       protected:
         uint32_t size;
 
-        std::vector<TlbEntry> tlb;
+        /// Entries for 4KiB pages
+        TlbArray smallPages;
+
+        /**
+         * Entries for larger pages. If there are none configured, all the
+         * entries go in smallPages.
+         */
+        TlbArray largePages;
+
+        TlbArray &
+        arrayFor(unsigned log_bytes)
+        {
+            return log_bytes > PageShift && largePages.capacity() ?
+                largePages : smallPages;
+        }
 
-        EntryList freeList;
+        /**
+         * The entry used by the last lookup. Consecutive accesses mostly
+         * hit the same page, and checking it first saves probing the
+         * arrays. It is cleared whenever an entry is invalidated; entries
+         * that are evicted are overwritten in place by valid ones, so the
+         * check against its contents stays correct.
+         */
+        TlbEntry *lastEntry;
 
-        TlbEntryTrie trie;
         uint64_t lruSeq;
 
         AddrRange m5opRange;
@@ -118,8 +221,6 @@ namespace X86ISA
 
       public:
 
-        void evictLRU();
-
         uint64_t
         nextSeq()
         {
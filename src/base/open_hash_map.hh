@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __BASE_OPEN_HASH_MAP_HH__
+#define __BASE_OPEN_HASH_MAP_HH__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * Hash map using open addressing with linear probing.
+ *
+ * The entries are stored inline in a single power-of-two sized
+ * vector, so inserting and erasing entries does not allocate memory
+ * unless the map has to grow. This makes the map suitable for
+ * bookkeeping that is updated on every packet, such as the routing
+ * tables of the crossbars, where the number of entries stays roughly
+ * constant while keys come and go. Erased entries are removed using
+ * backward shifting, so no tombstones are left behind.
+ *
+ * Unlike std::unordered_map, any insertion or erasure may move the
+ * other entries of the map, and therefore invalidates all iterators.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>>
+class OpenHashMap
+{
+  public:
+    typedef std::pair<Key, T> value_type;
+
+    /** Iterator to a single entry, only valid until the map changes. */
+    class iterator
+    {
+      public:
+        iterator() : entry(nullptr) {}
+
+        value_type &operator*() const { return *entry; }
+        value_type *operator->() const { return entry; }
+
+        bool operator==(const iterator &other) const
+        {
+            return entry == other.entry;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+            return entry != other.entry;
+        }
+
+      private:
+        friend class OpenHashMap;
+
+        explicit iterator(value_type *_entry) : entry(_entry) {}
+
+        value_type *entry;
+    };
+
+    /**
+     * @param capacity Initial number of entries that can be stored
+     *                 before the map grows.
+     */
+    explicit OpenHashMap(size_t capacity = 64)
+        : numEntries(0)
+    {
+        size_t slots = 4;
+        while (slots * 3 < capacity * 4)
+            slots *= 2;
+        resize(slots);
+    }
+
+    size_t size() const { return numEntries; }
+    bool empty() const { return numEntries == 0; }
+
+    iterator end() const { return iterator(); }
+
+    iterator
+    find(const Key &key)
+    {
+        const size_t idx = lookup(key);
+        return used[idx] ? iterator(&entries[idx]) : end();
+    }
+
+    size_t count(const Key &key) const { return used[lookup(key)]; }
+
+    /**
+     * Insert an entry if the key is not in the map yet.
+     *
+     * @return An iterator to the entry with the given key, and whether
+     *         it was inserted.
+     */
+    std::pair<iterator, bool>
+    emplace(const Key &key, const T &value)
+    {
+        size_t idx = lookup(key);
+        if (used[idx])
+            return std::make_pair(iterator(&entries[idx]), false);
+
+        if ((numEntries + 1) * 4 > entries.size() * 3) {
+            resize(entries.size() * 2);
+            idx = lookup(key);
+        }
+
+        entries[idx].first = key;
+        entries[idx].second = value;
+        used[idx] = true;
+        ++numEntries;
+        return std::make_pair(iterator(&entries[idx]), true);
+    }
+
+    T &operator[](const Key &key) { return emplace(key, T()).first->second; }
+
+    void
+    erase(iterator it)
+    {
+        assert(it != end());
+        const size_t idx = it.entry - entries.data();
+        assert(idx < entries.size() && used[idx]);
+
+        // Shift back the entries following the erased one that
+        // would not be found anymore because of the hole
+        size_t hole = idx;
+        for (size_t i = next(hole); used[i]; i = next(i)) {
+            const size_t home = homeSlot(entries[i].first);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                entries[hole] = std::move(entries[i]);
+                used[hole] = true;
+                hole = i;
+            }
+        }
+
+        // Release whatever the key and value may be holding on to
+        entries[hole] = value_type();
+        used[hole] = false;
+        --numEntries;
+    }
+
+    size_t
+    erase(const Key &key)
+    {
+        iterator it = find(key);
+        if (it == end())
+            return 0;
+        erase(it);
+        return 1;
+    }
+
+  private:
+    size_t next(size_t idx) const { return (idx + 1) & mask; }
+
+    size_t
+    homeSlot(const Key &key) const
+    {
+        // Mix the bits, as hashes of pointers have their low bits
+        // clear and would all collide otherwise
+        uint64_t h = Hash()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h & mask;
+    }
+
+    /**
+     * Find the slot of a key, or the free slot where it would be
+     * inserted if it is not in the map.
+     */
+    size_t
+    lookup(const Key &key) const
+    {
+        size_t idx = homeSlot(key);
+        while (used[idx] && !(entries[idx].first == key))
+            idx = next(idx);
+        return idx;
+    }
+
+    void
+    resize(size_t slots)
+    {
+        std::vector<value_type> old_entries(slots);
+        std::vector<uint8_t> old_used(slots, false);
+        entries.swap(old_entries);
+        used.swap(old_used);
+        mask = slots - 1;
+
+        for (size_t i = 0; i < old_entries.size(); ++i) {
+            if (old_used[i]) {
+                const size_t idx = lookup(old_entries[i].first);
+                entries[idx] = std::move(old_entries[i]);
+                used[idx] = true;
+            }
+        }
+    }
+
+    /** The entries, with a power-of-two size. */
+    std::vector<value_type> entries;
+
+    /** Whether each of the entries is in use. */
+    std::vector<uint8_t> used;
+
+    /** Mask to wrap around the entries. */
+    size_t mask;
+
+    /** Number of entries in use. */
+    size_t numEntries;
+};
+
+/**
+ * Hash set using open addressing with linear probing, with the same
+ * properties as OpenHashMap.
+ */
+template <typename Key, typename Hash = std::hash<Key>>
+class OpenHashSet
+{
+  private:
+    struct Empty {};
+
+    typedef OpenHashMap<Key, Empty, Hash> Map;
+
+    Map map;
+
+  public:
+    typedef typename Map::iterator iterator;
+
+    explicit OpenHashSet(size_t capacity = 64) : map(capacity) {}
+
+    size_t size() const { return map.size(); }
+    bool empty() const { return map.empty(); }
+
+    iterator end() const { return map.end(); }
+    iterator find(const Key &key) { return map.find(key); }
+    size_t count(const Key &key) const { return map.count(key); }
+
+    std::pair<iterator, bool>
+    insert(const Key &key)
+    {
+        return map.emplace(key, Empty());
+    }
+
+    void erase(iterator it) { map.erase(it); }
+    size_t erase(const Key &key) { return map.erase(key); }
+};
+
+#endif // __BASE_OPEN_HASH_MAP_HH__
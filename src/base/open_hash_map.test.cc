@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "base/open_hash_map.hh"
+
+namespace {
+
+/** Hash sending all the keys to the same few slots. */
+struct BadHash
+{
+    size_t operator()(int key) const { return key % 3; }
+};
+
+} // anonymous namespace
+
+TEST(OpenHashMapTest, Empty)
+{
+    OpenHashMap<int, int> map;
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(0u, map.size());
+    ASSERT_EQ(map.end(), map.find(0));
+    ASSERT_EQ(0u, map.count(0));
+    ASSERT_EQ(0u, map.erase(0));
+}
+
+TEST(OpenHashMapTest, InsertFindErase)
+{
+    OpenHashMap<int, int> map;
+    auto res = map.emplace(3, 30);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ(3, res.first->first);
+    ASSERT_EQ(30, res.first->second);
+
+    // Emplacing an existing key keeps the previous value
+    res = map.emplace(3, 40);
+    ASSERT_FALSE(res.second);
+    ASSERT_EQ(30, res.first->second);
+
+    map[5] = 50;
+    ASSERT_EQ(2u, map.size());
+    ASSERT_EQ(50, map.find(5)->second);
+    ASSERT_EQ(1u, map.count(3));
+
+    map.erase(map.find(3));
+    ASSERT_EQ(1u, map.size());
+    ASSERT_EQ(map.end(), map.find(3));
+    ASSERT_EQ(1u, map.erase(5));
+    ASSERT_TRUE(map.empty());
+}
+
+/** Grow the map well beyond its initial capacity. */
+TEST(OpenHashMapTest, Grow)
+{
+    OpenHashMap<int, int> map(4);
+    for (int i = 0; i < 1000; i++)
+        map[i] = -i;
+    ASSERT_EQ(1000u, map.size());
+    for (int i = 0; i < 1000; i++)
+        ASSERT_EQ(-i, map.find(i)->second);
+}
+
+/**
+ * With colliding keys, erasing an entry must shift the following
+ * ones back without losing any of them.
+ */
+TEST(OpenHashMapTest, Collisions)
+{
+    OpenHashMap<int, int, BadHash> map;
+    for (int i = 0; i < 30; i++)
+        map[i] = i;
+
+    for (int i = 0; i < 30; i += 2)
+        ASSERT_EQ(1u, map.erase(i));
+
+    ASSERT_EQ(15u, map.size());
+    for (int i = 0; i < 30; i++) {
+        if (i % 2)
+            ASSERT_EQ(i, map.find(i)->second);
+        else
+            ASSERT_EQ(map.end(), map.find(i));
+    }
+}
+
+/** Erasing an entry must release the resources held by its key. */
+TEST(OpenHashMapTest, ReleaseKey)
+{
+    OpenHashSet<std::shared_ptr<int>> set;
+    std::weak_ptr<int> weak;
+    {
+        auto ptr = std::make_shared<int>(1);
+        weak = ptr;
+        ASSERT_TRUE(set.insert(ptr).second);
+        ASSERT_FALSE(set.insert(ptr).second);
+        ASSERT_EQ(1u, set.erase(ptr));
+    }
+    ASSERT_TRUE(weak.expired());
+    ASSERT_TRUE(set.empty());
+}
+
+/** Compare against std::unordered_map on a random sequence. */
+TEST(OpenHashMapTest, Random)
+{
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> key_dist(0, 255);
+    OpenHashMap<int, int> map(16);
+    std::unordered_map<int, int> ref;
+
+    for (int i = 0; i < 100000; i++) {
+        const int key = key_dist(gen);
+        if (gen() % 2) {
+            ASSERT_EQ(ref.emplace(key, i).second,
+                      map.emplace(key, i).second);
+        } else {
+            ASSERT_EQ(ref.erase(key), map.erase(key));
+        }
+        ASSERT_EQ(ref.size(), map.size());
+    }
+
+    for (int key = 0; key < 256; key++) {
+        auto it = ref.find(key);
+        if (it == ref.end())
+            ASSERT_EQ(map.end(), map.find(key));
+        else
+            ASSERT_EQ(it->second, map.find(key)->second);
+    }
+}
@@ -67,5 +67,13 @@ class BaseKvmCPU(BaseCPU):
     alwaysSyncTC = Param.Bool(False,
                               "Always sync thread contexts on entry/exit")
 
+    # When the devices live in a different event queue, IO writes
+    # can be handed to that queue through a per-vCPU ring instead of
+    # locking it, which lets vCPUs doing a lot of IO run in parallel.
+    usePostedIO = Param.Bool(False, "Post IO writes to the device "
+                             "event queue instead of waiting for them")
+    postedIOEntries = Param.Unsigned(256, "Number of IO writes a vCPU "
+                                     "can post before issuing them itself")
+
     hostFreq = Param.Clock("2GHz", "Host clock frequency")
     hostFactor = Param.Float(1.0, "Cycle scale factor")
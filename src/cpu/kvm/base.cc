@@ -73,6 +73,9 @@ BaseKvmCPU::BaseKvmCPU(BaseKvmCPUParams *params)
       pageSize(sysconf(_SC_PAGE_SIZE)),
       tickEvent([this]{ tick(); }, "BaseKvmCPU tick",
                 false, Event::CPU_Tick_Pri),
+      usePostedIO(params->usePostedIO),
+      ioRing(params->postedIOEntries),
+      postedIOPending(false), postedIOTicks(0),
       activeInstPeriod(0),
       perfControlledByTimer(params->usePerfOverflow),
       hostFactor(params->hostFactor), stats(this),
@@ -128,6 +131,10 @@ BaseKvmCPU::startup()
     // Tell the VM that a CPU is about to start.
     vm.cpuStartup();
 
+    // Let the VM issue our posted writes before other vCPUs' accesses.
+    if (usePostedIO)
+        vm.registerPostedIO(this);
+
     // We can't initialize KVM CPUs in BaseKvmCPU::init() since we are
     // not guaranteed that the parent KVM VM has initialized at that
     // point. Initialize virtual CPUs here instead.
@@ -269,6 +276,10 @@ BaseKvmCPU::StatGroup::StatGroup(Stats::Group *parent)
     ADD_STAT(numCoalescedMMIO,
      "number of coalesced memory mapped IO requests"),
     ADD_STAT(numIO, "number of VM exits due to legacy IO"),
+    ADD_STAT(numPostedIO,
+     "number of IO writes posted to the device event queue"),
+    ADD_STAT(numPostedIOBatches,
+     "number of batches in which posted IO writes were issued"),
     ADD_STAT(numHalt,
      "number of VM exits due to wait for interrupt instructions"),
     ADD_STAT(numInterrupts, "number of interrupts delivered"),
@@ -337,6 +348,13 @@ BaseKvmCPU::drain()
         // Idle, no need to drain
         assert(!tickEvent.scheduled());
 
+        // Make sure that all the posted writes have reached the
+        // devices before they are drained.
+        if (!ioRing.empty()) {
+            EventQueue::ScopedMigration migrate(deviceEventQueue());
+            flushPostedIO();
+        }
+
         // Sync the thread context here since we'll need it when we
         // switch CPUs or checkpoint the CPU.
         syncThreadContext();
@@ -1086,6 +1104,9 @@ BaseKvmCPU::doMMIOAccess(Addr paddr, void *data, int size, bool write)
         warn("Finalization of MMIO address failed: %s\n", fault->name());
 
 
+    if (write && !mmio_req->isLocalAccess() && postingIO())
+        return postIOWrite(mmio_req, data);
+
     const MemCmd cmd(write ? MemCmd::WriteReq : MemCmd::ReadReq);
     PacketPtr pkt = new Packet(mmio_req, cmd);
     pkt->dataStatic(data);
@@ -1103,10 +1124,67 @@ BaseKvmCPU::doMMIOAccess(Addr paddr, void *data, int size, bool write)
         // prevent races in multi-core mode.
         EventQueue::ScopedMigration migrate(deviceEventQueue());
 
+        // Writes posted earlier by any vCPU must reach the devices first.
+        flushAllPostedIO();
+
         return dataPort.submitIO(pkt);
     }
 }
 
+Tick
+BaseKvmCPU::postIOWrite(const RequestPtr &req, const void *data)
+{
+    if (ioRing.full()) {
+        // The device queue has fallen behind, issue the posted writes
+        // ourselves to make room.
+        EventQueue::ScopedMigration migrate(deviceEventQueue());
+        flushPostedIO();
+    }
+
+    ioRing.push(req, data);
+    ++stats.numPostedIO;
+
+    // Events scheduled on other queues are only merged at the end of
+    // the quantum, so they need to be at least a quantum away. Every
+    // batch gets its own event, as the device queue's thread may still
+    // be processing the previous one. The flag is cleared before the
+    // ring is drained, so a write posted meanwhile either makes it into
+    // this batch or schedules the next one.
+    if (!postedIOPending.exchange(true)) {
+        auto *event = new EventFunctionWrapper([this]{
+                postedIOPending = false;
+                flushPostedIO();
+            }, name() + ".postedIOEvent", true);
+        deviceEventQueue()->schedule(event, curTick() + simQuantum);
+    }
+
+    return postedIOTicks.exchange(0);
+}
+
+void
+BaseKvmCPU::flushPostedIO()
+{
+    Tick ticks = 0;
+    const unsigned count = ioRing.drain(
+        [this, &ticks](const RequestPtr &req, uint8_t *data) {
+            PacketPtr pkt = new Packet(req, MemCmd::WriteReq);
+            pkt->dataStatic(data);
+            ticks += dataPort.submitIO(pkt);
+        });
+
+    if (count) {
+        DPRINTF(KvmIO, "KVM: Issued %d posted IO writes\n", count);
+        ++stats.numPostedIOBatches;
+        postedIOTicks += ticks;
+    }
+}
+
+void
+BaseKvmCPU::flushAllPostedIO()
+{
+    vm.flushPostedIO();
+}
+
 void
 BaseKvmCPU::setSignalMask(const sigset_t *mask)
 {
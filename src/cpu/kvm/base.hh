@@ -40,11 +40,13 @@
 
 #include <pthread.h>
 
+#include <atomic>
 #include <csignal>
 #include <memory>
 #include <queue>
 
 #include "base/statistics.hh"
+#include "cpu/kvm/io_ring.hh"
 #include "cpu/kvm/perfevent.hh"
 #include "cpu/kvm/timer.hh"
 #include "cpu/kvm/vm.hh"
@@ -531,6 +533,51 @@ class BaseKvmCPU : public BaseCPU
      */
     Tick doMMIOAccess(Addr paddr, void *data, int size, bool write);
 
+    /** @{ */
+    /**
+     * Check if IO writes should be posted to the device event queue.
+     *
+     * Posting is only done if it is enabled, if the devices live in a
+     * different event queue, and in atomic mode where the vCPU only
+     * needs the latency of a write and not its completion. Only MMIO
+     * writes are posted, port IO is always issued directly.
+     */
+    bool
+    postingIO()
+    {
+        return usePostedIO && deviceEventQueue() != eventQueue() &&
+            system->isAtomicMode();
+    }
+
+    /**
+     * Post an IO write to the device event queue.
+     *
+     * The write is copied to the vCPU's IO ring, which the device
+     * event queue drains within a quantum, and the vCPU continues
+     * without taking the device queue's lock. Posted writes are
+     * issued in order, and before any other access of any vCPU in
+     * the VM reaches the devices. Their latency is accounted for in
+     * batches, the next time a write is posted.
+     *
+     * @param req Request of the write, already finalized
+     * @param data Pointer to the data to write
+     * @return Number of ticks spent servicing earlier posted writes
+     */
+    Tick postIOWrite(const RequestPtr &req, const void *data);
+
+    /**
+     * Issue all the writes posted by this vCPU. The device event
+     * queue must be locked by the calling thread.
+     */
+    void flushPostedIO();
+
+    /**
+     * Issue all the writes posted by the vCPUs of the VM. The device
+     * event queue must be locked by the calling thread.
+     */
+    void flushAllPostedIO();
+    /** @} */
+
     /** @{ */
     /**
      * Set the signal mask used in kvmRun()
@@ -704,6 +751,15 @@ class BaseKvmCPU : public BaseCPU
 
     EventFunctionWrapper tickEvent;
 
+    /** Post IO writes to the device event queue, see postIOWrite() */
+    const bool usePostedIO;
+    /** IO writes posted by this vCPU */
+    KvmIORing ioRing;
+    /** Set while an event draining ioRing is scheduled */
+    std::atomic<bool> postedIOPending;
+    /** Latency of the posted writes not yet reported to the vCPU */
+    std::atomic<Tick> postedIOTicks;
+
     /**
      * Setup an instruction break if there is one pending.
      *
@@ -790,6 +846,8 @@ class BaseKvmCPU : public BaseCPU
         Stats::Scalar numMMIO;
         Stats::Scalar numCoalescedMMIO;
         Stats::Scalar numIO;
+        Stats::Scalar numPostedIO;
+        Stats::Scalar numPostedIOBatches;
         Stats::Scalar numHalt;
         Stats::Scalar numInterrupts;
         Stats::Scalar numHypercalls;
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CPU_KVM_IO_RING_HH__
+#define __CPU_KVM_IO_RING_HH__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "mem/request.hh"
+
+/**
+ * Ring of IO writes posted by a vCPU to the device event queue.
+ *
+ * Only the vCPU thread pushes onto the ring. Entries are consumed by
+ * whichever thread holds the device event queue's lock, which is
+ * either the device thread itself or any vCPU of the VM after
+ * migrating to the device queue, so there is never more than one
+ * consumer at a time.
+ */
+class KvmIORing
+{
+  public:
+    /** A write together with its data, which is at most a register */
+    struct Entry
+    {
+        RequestPtr req;
+        uint8_t data[8];
+    };
+
+    KvmIORing(unsigned entries)
+        : ring(entries), indexMask(entries - 1), head(0), tail(0)
+    {
+        fatal_if(!isPowerOf2(entries),
+                 "The KVM IO ring size must be a power of 2 (got %d)\n",
+                 entries);
+    }
+
+    bool
+    empty() const
+    {
+        return head.load(std::memory_order_acquire) ==
+            tail.load(std::memory_order_acquire);
+    }
+
+    /** Check if the producer can push. Only call on the vCPU thread. */
+    bool
+    full() const
+    {
+        return tail.load(std::memory_order_relaxed) -
+            head.load(std::memory_order_acquire) == ring.size();
+    }
+
+    /**
+     * Post a write. Only call on the vCPU thread, and only if the
+     * ring is not full.
+     */
+    void
+    push(const RequestPtr &req, const void *data)
+    {
+        assert(!full());
+        assert(req->getSize() <= sizeof(Entry::data));
+
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        Entry &entry = ring[t & indexMask];
+        entry.req = req;
+        std::memcpy(entry.data, data, req->getSize());
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    /**
+     * Call a visitor on all the posted writes in order and release
+     * them. Only call with the device event queue locked.
+     *
+     * @return The number of writes visited.
+     */
+    template <typename Visitor>
+    unsigned
+    drain(Visitor &&visit)
+    {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        const uint64_t t = tail.load(std::memory_order_acquire);
+        for (uint64_t i = h; i != t; ++i) {
+            Entry &entry = ring[i & indexMask];
+            visit(entry.req, entry.data);
+            entry.req.reset();
+        }
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+
+  private:
+    std::vector<Entry> ring;
+    const uint64_t indexMask;
+
+    /** Next entry to consume, only written by the consumer */
+    std::atomic<uint64_t> head;
+    /** Next entry to produce, only written by the vCPU thread */
+    std::atomic<uint64_t> tail;
+};
+
+#endif // __CPU_KVM_IO_RING_HH__
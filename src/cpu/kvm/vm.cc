@@ -561,6 +561,19 @@ KvmVM::allocVCPUID()
     return nextVCPUID++;
 }
 
+void
+KvmVM::registerPostedIO(BaseKvmCPU *cpu)
+{
+    postedIOCPUs.push_back(cpu);
+}
+
+void
+KvmVM::flushPostedIO()
+{
+    for (auto *cpu : postedIOCPUs)
+        cpu->flushPostedIO();
+}
+
 #if defined(__aarch64__)
 void
 KvmVM::kvmArmPreferredTarget(struct kvm_vcpu_init &target) const
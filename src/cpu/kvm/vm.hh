@@ -493,6 +493,20 @@ class KvmVM : public SimObject
      */
     long allocVCPUID();
 
+    /**
+     * Register a vCPU which posts IO writes to the VM's event queue.
+     *
+     * @param cpu vCPU owning the IO ring
+     */
+    void registerPostedIO(BaseKvmCPU *cpu);
+
+    /**
+     * Issue the IO writes posted by all the vCPUs of the VM. This has
+     * to be done before any access which may observe them. The VM's
+     * event queue must be locked by the calling thread.
+     */
+    void flushPostedIO();
+
     /**
      * @addtogroup KvmIoctl
      * @{
@@ -535,6 +549,9 @@ class KvmVM : public SimObject
     /** Next unallocated vCPU ID */
     long nextVCPUID;
 
+    /** vCPUs posting IO writes to the VM's event queue */
+    std::vector<BaseKvmCPU *> postedIOCPUs;
+
     /**
      *  Structures tracking memory slots.
      */
@@ -1348,6 +1348,9 @@ X86KvmCPU::handleKvmExitIO()
     // Temporarily lock and migrate to the device event queue to
     // prevent races in multi-core mode.
     EventQueue::ScopedMigration migrate(deviceEventQueue());
+    // Port IO is never posted, but writes posted earlier by any vCPU
+    // must reach the devices first.
+    flushAllPostedIO();
     for (int i = 0; i < count; ++i) {
         RequestPtr io_req = std::make_shared<Request>(
             pAddr, kvm_run.io.size,
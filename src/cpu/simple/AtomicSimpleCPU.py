@@ -59,6 +59,9 @@ class AtomicSimpleCPU(BaseSimpleCPU):
     width = Param.Int(1, "CPU width")
     simulate_data_stalls = Param.Bool(False, "Simulate dcache stall cycles")
     simulate_inst_stalls = Param.Bool(False, "Simulate icache stall cycles")
+    fast_cache_hits = Param.Bool(True, "Satisfy hits in the caches directly "
+                                 "attached to the CPU without going "
+                                 "through their full access path")
 
     def addSimPointProbe(self, interval):
         simpoint = SimPoint()
@@ -50,6 +50,7 @@
 #include "debug/Drain.hh"
 #include "debug/ExecFaulting.hh"
 #include "debug/SimpleCPU.hh"
+#include "mem/cache/base.hh"
 #include "mem/packet.hh"
 #include "mem/packet_access.hh"
 #include "mem/physical.hh"
@@ -71,6 +72,8 @@ AtomicSimpleCPU::init()
     data_read_req->setContext(cid);
     data_write_req->setContext(cid);
     data_amo_req->setContext(cid);
+
+    updateAttachedCaches();
 }
 
 AtomicSimpleCPU::AtomicSimpleCPU(AtomicSimpleCPUParams *p)
@@ -80,8 +83,10 @@ AtomicSimpleCPU::AtomicSimpleCPU(AtomicSimpleCPUParams *p)
       width(p->width), locked(false),
       simulate_data_stalls(p->simulate_data_stalls),
       simulate_inst_stalls(p->simulate_inst_stalls),
+      fast_cache_hits(p->fast_cache_hits),
       icachePort(name() + ".icache_port", this),
       dcachePort(name() + ".dcache_port", this),
+      icache(nullptr), dcache(nullptr),
       dcache_access(false), dcache_latency(0),
       ppCommit(nullptr)
 {
@@ -198,6 +203,9 @@ AtomicSimpleCPU::switchOut()
     assert(!tickEvent.scheduled());
     assert(_status == BaseSimpleCPU::Running || _status == Idle);
     assert(isCpuDrained());
+
+    icache = nullptr;
+    dcache = nullptr;
 }
 
 
@@ -208,6 +216,18 @@ AtomicSimpleCPU::takeOverFrom(BaseCPU *oldCPU)
 
     // The tick event should have been descheduled by drain()
     assert(!tickEvent.scheduled());
+
+    // The ports were just bound to the ones of the old CPU
+    updateAttachedCaches();
+}
+
+void
+AtomicSimpleCPU::updateAttachedCaches()
+{
+    if (fast_cache_hits) {
+        icache = BaseCache::getConnectedCache(icachePort);
+        dcache = BaseCache::getConnectedCache(dcachePort);
+    }
 }
 
 void
@@ -274,6 +294,12 @@ AtomicSimpleCPU::suspendContext(ThreadID thread_num)
 Tick
 AtomicSimpleCPU::sendPacket(RequestPort &port, const PacketPtr &pkt)
 {
+    // Hits in a directly attached cache can be satisfied right away
+    BaseCache *cache = &port == &dcachePort ? dcache : icache;
+    Tick latency;
+    if (cache && cache->tryAtomicHit(pkt, latency))
+        return latency;
+
     return port.sendAtomic(pkt);
 }
 
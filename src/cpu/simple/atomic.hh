@@ -47,6 +47,8 @@
 #include "params/AtomicSimpleCPU.hh"
 #include "sim/probe/probe.hh"
 
+class BaseCache;
+
 class AtomicSimpleCPU : public BaseSimpleCPU
 {
   public:
@@ -64,6 +66,7 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     bool locked;
     const bool simulate_data_stalls;
     const bool simulate_inst_stalls;
+    const bool fast_cache_hits;
 
     // main simulation loop (one cycle)
     void tick();
@@ -157,6 +160,16 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     AtomicCPUPort icachePort;
     AtomicCPUDPort dcachePort;
 
+    /**
+     * Caches directly attached to the instruction and data ports, if
+     * any, which can satisfy hits without going through the ports.
+     */
+    BaseCache *icache;
+    BaseCache *dcache;
+
+    /** Look up the caches directly attached to the ports. */
+    void updateAttachedCaches();
+
 
     RequestPtr ifetch_req;
     RequestPtr data_read_req;
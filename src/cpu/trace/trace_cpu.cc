@@ -301,13 +301,14 @@ TraceCPU::ElasticDataGen::readNextWindow()
     while (num_read != windowSize) {
 
         // Create a new graph node
-        GraphNode* new_node = new GraphNode;
+        GraphNode* new_node = allocNode();
 
         // Read the next line to get the next record. If that fails then end of
         // trace has been reached and traceComplete needs to be set in addition
         // to returning false.
         if (!trace.read(new_node)) {
             DPRINTF(TraceCPUData, "\tTrace complete!\n");
+            freeNode(new_node);
             traceComplete = true;
             return false;
         }
@@ -319,8 +320,8 @@ TraceCPU::ElasticDataGen::readNextWindow()
         addDepsOnParent(new_node, new_node->regDep, new_node->numRegDep);
 
         num_read++;
-        // Add to map
-        depGraph[new_node->seqNum] = new_node;
+        // Add to the window
+        depGraph.insert(new_node);
         if (new_node->numRobDep == 0 && new_node->numRegDep == 0) {
             // Source dependencies are already complete, check if resources
             // are available and issue. The execution time is approximated
@@ -334,6 +335,27 @@ TraceCPU::ElasticDataGen::readNextWindow()
     return true;
 }
 
+TraceCPU::ElasticDataGen::GraphNode *
+TraceCPU::ElasticDataGen::allocNode()
+{
+    if (freeNodes.empty()) {
+        nodePool.emplace_back(new GraphNode);
+        return nodePool.back().get();
+    }
+
+    GraphNode *node = freeNodes.back();
+    freeNodes.pop_back();
+    return node;
+}
+
+void
+TraceCPU::ElasticDataGen::freeNode(GraphNode *node)
+{
+    // Keep the storage of the dependents for the next user of the node
+    node->dependents.clear();
+    freeNodes.push_back(node);
+}
+
 template<typename T> void
 TraceCPU::ElasticDataGen::addDepsOnParent(GraphNode *new_node,
                                             T& dep_array, uint8_t& num_dep)
@@ -346,13 +368,13 @@ TraceCPU::ElasticDataGen::addDepsOnParent(GraphNode *new_node,
         if (a_dep == 0)
             break;
         // We look up the valid dependency, i.e. the parent of this node
-        auto parent_itr = depGraph.find(a_dep);
-        if (parent_itr != depGraph.end()) {
+        GraphNode *parent = depGraph.find(a_dep);
+        if (parent) {
             // If the parent is found, it is yet to be executed. Append a
             // pointer to the new node to the dependents list of the parent
             // node.
-            parent_itr->second->dependents.push_back(new_node);
-            auto num_depts = parent_itr->second->dependents.size();
+            parent->dependents.push_back(new_node);
+            auto num_depts = parent->dependents.size();
             elasticStats.maxDependents = std::max<double>(num_depts,
                                         elasticStats.maxDependents.value());
         } else {
@@ -394,16 +416,14 @@ TraceCPU::ElasticDataGen::execute()
         }
     }
     // Proceed to execute from readyList
-    auto graph_itr = depGraph.begin();
     auto free_itr = readyList.begin();
     // Iterate through readyList until the next free node has its execute
     // tick later than curTick or the end of readyList is reached
     while (free_itr->execTick <= curTick() && free_itr != readyList.end()) {
 
         // Get pointer to the node to be executed
-        graph_itr = depGraph.find(free_itr->seqNum);
-        assert(graph_itr != depGraph.end());
-        GraphNode* node_ptr = graph_itr->second;
+        GraphNode* node_ptr = depGraph.find(free_itr->seqNum);
+        assert(node_ptr);
 
         // If there is a retryPkt send that else execute the load
         if (retryPkt) {
@@ -497,14 +517,12 @@ TraceCPU::ElasticDataGen::execute()
         if (!node_ptr->isLoad() || node_ptr->isStrictlyOrdered()) {
             // Release all resources occupied by the completed node
             hwResource.release(node_ptr);
-            // clear the dynamically allocated set of dependents
-            (node_ptr->dependents).clear();
             // Update the stat for numOps simulated
             owner.updateNumOps(node_ptr->robNum);
-            // delete node
-            delete node_ptr;
             // remove from graph
-            depGraph.erase(graph_itr);
+            depGraph.erase(node_ptr->seqNum);
+            // return the node to the pool
+            freeNode(node_ptr);
         }
         // Point to first node to continue to next iteration of while loop
         free_itr = readyList.begin();
@@ -690,9 +708,8 @@ TraceCPU::ElasticDataGen::completeMemAccess(PacketPtr pkt)
     } else {
         // If it is a load response then release the dependents waiting on it.
         // Get pointer to the completed load
-        auto graph_itr = depGraph.find(pkt->req->getReqInstSeqNum());
-        assert(graph_itr != depGraph.end());
-        GraphNode* node_ptr = graph_itr->second;
+        GraphNode* node_ptr = depGraph.find(pkt->req->getReqInstSeqNum());
+        assert(node_ptr);
 
         // Release resources occupied by the load
         hwResource.release(node_ptr);
@@ -706,14 +723,12 @@ TraceCPU::ElasticDataGen::completeMemAccess(PacketPtr pkt)
             }
         }
 
-        // clear the dynamically allocated set of dependents
-        (node_ptr->dependents).clear();
         // Update the stat for numOps completed
         owner.updateNumOps(node_ptr->robNum);
-        // delete node
-        delete node_ptr;
         // remove from graph
-        depGraph.erase(graph_itr);
+        depGraph.erase(node_ptr->seqNum);
+        // return the node to the pool
+        freeNode(node_ptr);
     }
 
     if (DTRACE(TraceCPUData)) {
@@ -810,8 +825,7 @@ TraceCPU::ElasticDataGen::printReadyList() {
     }
     DPRINTF(TraceCPUData, "Printing readyList:\n");
     while (itr != readyList.end()) {
-        auto graph_itr = depGraph.find(itr->seqNum);
-        GraphNode* node_ptr M5_VAR_USED = graph_itr->second;
+        GraphNode* node_ptr M5_VAR_USED = depGraph.find(itr->seqNum);
         DPRINTFR(TraceCPUData, "\t%lld(%s), %lld\n", itr->seqNum,
             node_ptr->typeToStr(), itr->execTick);
         itr++;
@@ -1182,7 +1196,15 @@ TraceCPU::ElasticDataGen::InputStream::InputStream(
     const double time_multiplier)
     : trace(filename),
       timeMultiplier(time_multiplier),
-      microOpCount(0)
+      microOpCount(0),
+      decodedOpCount(0),
+      chunks(numChunks),
+      chunksRead(0),
+      chunksDecoded(0),
+      decodeDone(false),
+      stopDecode(false),
+      readChunk(nullptr),
+      readPos(0)
 {
     // Create a protobuf message for the header and read it from the stream
     ProtoMessage::InstDepRecordHeader header_msg;
@@ -1200,14 +1222,122 @@ TraceCPU::ElasticDataGen::InputStream::InputStream(
     }
 }
 
+TraceCPU::ElasticDataGen::InputStream::~InputStream()
+{
+    stopDecoder();
+}
+
 void
 TraceCPU::ElasticDataGen::InputStream::reset()
 {
+    stopDecoder();
     trace.reset();
+    microOpCount = 0;
+    decodedOpCount = 0;
+}
+
+void
+TraceCPU::ElasticDataGen::InputStream::stopDecoder()
+{
+    if (decoder.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(chunkMutex);
+            stopDecode = true;
+        }
+        chunkReleased.notify_one();
+        decoder.join();
+    }
+
+    chunksRead = 0;
+    chunksDecoded = 0;
+    decodeDone = false;
+    stopDecode = false;
+    readChunk = nullptr;
+    readPos = 0;
+}
+
+void
+TraceCPU::ElasticDataGen::InputStream::decodeLoop()
+{
+    while (true) {
+        uint64_t slot;
+        {
+            // Wait for a free chunk
+            std::unique_lock<std::mutex> lock(chunkMutex);
+            chunkReleased.wait(lock, [this] {
+                return stopDecode || chunksDecoded - chunksRead < numChunks;
+            });
+            if (stopDecode)
+                return;
+            slot = chunksDecoded % numChunks;
+        }
+
+        // The free chunk is not accessed by the reader, so fill it
+        // without holding the lock
+        std::vector<GraphNode> &chunk = chunks[slot];
+        chunk.resize(chunkNodes);
+        size_t num_nodes = 0;
+        while (num_nodes < chunkNodes && decode(&chunk[num_nodes]))
+            ++num_nodes;
+        chunk.resize(num_nodes);
+
+        bool done = num_nodes < chunkNodes;
+        {
+            std::lock_guard<std::mutex> lock(chunkMutex);
+            if (num_nodes)
+                ++chunksDecoded;
+            decodeDone = done;
+        }
+        chunkFilled.notify_one();
+
+        if (done)
+            return;
+    }
+}
+
+bool
+TraceCPU::ElasticDataGen::InputStream::nextChunk()
+{
+    std::unique_lock<std::mutex> lock(chunkMutex);
+
+    // Hand the chunk we are done with back to the decoder
+    if (readChunk) {
+        readChunk = nullptr;
+        ++chunksRead;
+        chunkReleased.notify_one();
+    }
+
+    chunkFilled.wait(lock, [this] {
+        return decodeDone || chunksDecoded != chunksRead;
+    });
+    if (chunksDecoded == chunksRead)
+        return false;
+
+    readChunk = &chunks[chunksRead % numChunks];
+    readPos = 0;
+    return true;
 }
 
 bool
 TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
+{
+    if (!decoder.joinable())
+        decoder = std::thread(&InputStream::decodeLoop, this);
+
+    while (!readChunk || readPos == readChunk->size()) {
+        if (!nextChunk())
+            return false;
+    }
+
+    // Copying the node keeps the storage of the element's dependents
+    // list, which is always empty in the parsed nodes
+    *element = (*readChunk)[readPos++];
+    microOpCount = element->robNum;
+    return true;
+}
+
+bool
+TraceCPU::ElasticDataGen::InputStream::decode(GraphNode* element)
 {
     ProtoMessage::InstDepRecord pkt_msg;
     if (trace.read(pkt_msg)) {
@@ -1269,11 +1399,11 @@ TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
             element->pc = 0;
 
         // ROB occupancy number
-        ++microOpCount;
+        ++decodedOpCount;
         if (pkt_msg.has_weight()) {
-            microOpCount += pkt_msg.weight();
+            decodedOpCount += pkt_msg.weight();
         }
-        element->robNum = microOpCount;
+        element->robNum = decodedOpCount;
         return true;
     }
 
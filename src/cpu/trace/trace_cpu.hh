@@ -38,11 +38,16 @@
 #ifndef __CPU_TRACE_TRACE_CPU_HH__
 #define __CPU_TRACE_TRACE_CPU_HH__
 
+#include <algorithm>
 #include <array>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <set>
-#include <unordered_map>
+#include <thread>
 
 #include "arch/registers.hh"
 #include "base/statistics.hh"
@@ -789,12 +794,24 @@ class TraceCPU : public BaseCPU
          * The InputStream encapsulates a trace file and the
          * internal buffers and populates GraphNodes based on
          * the input.
+         *
+         * Decompressing and parsing the trace is done by a decoder
+         * thread, which runs ahead of the simulation and fills a bounded
+         * ring of chunks of parsed nodes. The simulation thread only
+         * copies the nodes out of the chunks, and synchronises with the
+         * decoder once per chunk.
          */
         class InputStream
         {
 
           private:
 
+            /** Number of nodes parsed into a chunk */
+            static const size_t chunkNodes = 4096;
+
+            /** Number of chunks the decoder can run ahead by */
+            static const size_t numChunks = 8;
+
             /** Input file stream for the protobuf trace */
             ProtoInputStream trace;
 
@@ -814,6 +831,65 @@ class TraceCPU : public BaseCPU
              * trace and used to process the dependency trace
              */
             uint32_t windowSize;
+
+            /**
+             * Count of committed ops parsed by the decoder plus the
+             * filtered ops. Only used by the decoder thread.
+             */
+            uint64_t decodedOpCount;
+
+            /** Ring of chunks of parsed nodes */
+            std::vector<std::vector<GraphNode>> chunks;
+
+            /**
+             * Number of chunks taken by the reader and filled by the
+             * decoder, the chunks in between are ready to be read.
+             */
+            uint64_t chunksRead;
+            uint64_t chunksDecoded;
+
+            /** Set by the decoder when it reached the end of the trace */
+            bool decodeDone;
+
+            /** Set to ask the decoder to stop */
+            bool stopDecode;
+
+            /** Protects the state shared with the decoder */
+            std::mutex chunkMutex;
+            /** Signalled when a chunk is filled or the decoder is done */
+            std::condition_variable chunkFilled;
+            /** Signalled when a chunk is released or stopDecode is set */
+            std::condition_variable chunkReleased;
+
+            /** The decoder thread, not started until the first read */
+            std::thread decoder;
+
+            /** Chunk being read, if any, and the next node to read in it */
+            const std::vector<GraphNode> *readChunk;
+            size_t readPos;
+
+            /**
+             * Parse the next record in the trace into a node. Only
+             * called on the decoder thread.
+             *
+             * @param element Node to populate
+             * @return True if an element could be read successfully
+             */
+            bool decode(GraphNode* element);
+
+            /** Main loop of the decoder thread */
+            void decodeLoop();
+
+            /** Stop the decoder thread, if running, and drop its chunks */
+            void stopDecoder();
+
+            /**
+             * Release the chunk being read and wait for the next one.
+             *
+             * @return False if the end of the trace was reached
+             */
+            bool nextChunk();
+
           public:
 
             /**
@@ -825,6 +901,8 @@ class TraceCPU : public BaseCPU
             InputStream(const std::string& filename,
                         const double time_multiplier);
 
+            ~InputStream();
+
             /**
              * Reset the stream such that it can be played once
              * again.
@@ -1028,8 +1106,97 @@ class TraceCPU : public BaseCPU
          */
         HardwareResource hwResource;
 
+        /**
+         * Window of the graph nodes read from the trace and not yet
+         * completed, indexed by sequence number.
+         *
+         * Nodes are read in ascending sequence number order, so they are
+         * appended to a deque and looked up by binary search. A completed
+         * node leaves a hole, and holes are dropped once they reach the
+         * front of the window.
+         */
+        class NodeWindow
+        {
+          public:
+            NodeWindow() : numNodes(0) {}
+
+            /** Number of nodes in the window */
+            size_t size() const { return numNodes; }
+
+            bool empty() const { return numNodes == 0; }
+
+            /** Append a node, younger than all the nodes in the window */
+            void
+            insert(GraphNode *node)
+            {
+                panic_if(!nodes.empty() && node->seqNum <= nodes.back().first,
+                         "Elastic trace is not sorted by sequence number "
+                         "(%lli after %lli).\n", node->seqNum,
+                         nodes.back().first);
+                nodes.emplace_back(node->seqNum, node);
+                ++numNodes;
+            }
+
+            /** Find a node, nullptr if it is not in the window */
+            GraphNode *
+            find(NodeSeqNum seq_num) const
+            {
+                auto it = lookup(seq_num);
+                return it == nodes.end() ? nullptr : it->second;
+            }
+
+            /** Remove a node from the window */
+            void
+            erase(NodeSeqNum seq_num)
+            {
+                auto it = lookup(seq_num);
+                assert(it != nodes.end() && it->second);
+                nodes[it - nodes.begin()].second = nullptr;
+                --numNodes;
+
+                while (!nodes.empty() && !nodes.front().second)
+                    nodes.pop_front();
+            }
+
+          private:
+            typedef std::deque<std::pair<NodeSeqNum, GraphNode *>> Nodes;
+
+            Nodes::const_iterator
+            lookup(NodeSeqNum seq_num) const
+            {
+                auto it = std::lower_bound(
+                    nodes.begin(), nodes.end(), seq_num,
+                    [](const Nodes::value_type &n, NodeSeqNum s) {
+                        return n.first < s;
+                    });
+                if (it == nodes.end() || it->first != seq_num || !it->second)
+                    return nodes.end();
+                return it;
+            }
+
+            /** Nodes and holes in sequence number order */
+            Nodes nodes;
+
+            /** Number of nodes, i.e. entries that are not holes */
+            size_t numNodes;
+        };
+
         /** Store the depGraph of GraphNodes */
-        std::unordered_map<NodeSeqNum, GraphNode*> depGraph;
+        NodeWindow depGraph;
+
+        /**
+         * All the graph nodes allocated so far, and the ones that are
+         * free to be reused. Reusing nodes also reuses the storage of
+         * their lists of dependents.
+         */
+        std::vector<std::unique_ptr<GraphNode>> nodePool;
+        std::vector<GraphNode *> freeNodes;
+
+        /** Get a node from the pool */
+        GraphNode *allocNode();
+
+        /** Return a completed node to the pool */
+        void freeNode(GraphNode *node);
 
         /**
          * Queue of dependency-free nodes that are pending issue because
@@ -89,6 +89,14 @@ class DmaDevice(PioDevice):
     ssid = Param.Unsigned(0,
         "Substream identifier used by an IOMMU to distinguish amongst "
         "several devices attached to it")
+    dma_bulk = Param.Bool(False,
+        "In atomic mode, split DMA transfers at page rather than cache "
+        "line boundaries. Only valid if there are no caches or interleaved "
+        "memories between the device and memory")
+    dma_window = Param.Unsigned(0,
+        "In timing mode, create the cache line packets of DMA transfers "
+        "as they fit in a window of this many outstanding packets, rather "
+        "than all up front (0)")
 
     def addIommuProperty(self, state, node):
         """
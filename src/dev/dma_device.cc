@@ -50,13 +50,15 @@
 #include "sim/system.hh"
 
 DmaPort::DmaPort(ClockedObject *dev, System *s,
-                 uint32_t sid, uint32_t ssid)
+                 uint32_t sid, uint32_t ssid, bool _bulk, unsigned _window)
     : RequestPort(dev->name() + ".dma", dev),
       device(dev), sys(s), requestorId(s->getRequestorId(dev)),
       sendEvent([this]{ sendDma(); }, dev->name()),
       pendingCount(0), inRetry(false),
       defaultSid(sid),
-      defaultSSid(ssid)
+      defaultSSid(ssid),
+      bulk(_bulk),
+      window(_window)
 { }
 
 void
@@ -97,8 +99,12 @@ DmaPort::handleResp(PacketPtr pkt, Tick delay)
     // delete the packet
     delete pkt;
 
+    // a slot in the window is free, so get the next packet going
+    if (!transferList.empty() && !inRetry && !sendEvent.scheduled())
+        device->schedule(sendEvent, device->clockEdge(Cycles(1)));
+
     // we might be drained at this point, if so signal the drain event
-    if (pendingCount == 0)
+    if (pendingCount == 0 && transferList.empty())
         signalDrainDone();
 }
 
@@ -115,7 +121,8 @@ DmaPort::recvTimingResp(PacketPtr pkt)
 }
 
 DmaDevice::DmaDevice(const Params *p)
-    : PioDevice(p), dmaPort(this, sys, p->sid, p->ssid)
+    : PioDevice(p),
+      dmaPort(this, sys, p->sid, p->ssid, p->dma_bulk, p->dma_window)
 { }
 
 void
@@ -129,7 +136,7 @@ DmaDevice::init()
 DrainState
 DmaPort::drain()
 {
-    if (pendingCount == 0) {
+    if (pendingCount == 0 && transferList.empty()) {
         return DrainState::Drained;
     } else {
         DPRINTF(Drain, "DmaPort not drained\n");
@@ -144,6 +151,45 @@ DmaPort::recvReqRetry()
     trySendTimingReq();
 }
 
+PacketPtr
+DmaPort::createPacket(DmaReqState *state)
+{
+    ChunkGenerator &gen = state->gen;
+    assert(!gen.done());
+
+    RequestPtr req = std::make_shared<Request>(
+        gen.addr(), gen.size(), state->flags, requestorId);
+
+    req->setStreamId(state->sid);
+    req->setSubStreamId(state->ssid);
+
+    req->taskId(ContextSwitchTaskId::DMA);
+    PacketPtr pkt = new Packet(req, state->cmd);
+
+    // Increment the data pointer on a write
+    if (state->data)
+        pkt->dataStatic(state->data + gen.complete());
+
+    pkt->senderState = state;
+
+    DPRINTF(DMA, "--Queuing DMA for addr: %#x size: %d\n", gen.addr(),
+            gen.size());
+    gen.next();
+
+    return pkt;
+}
+
+void
+DmaPort::fillTransmitList()
+{
+    while (!transferList.empty() && pendingCount < window) {
+        DmaReqState *state = transferList.front();
+        queueDma(createPacket(state));
+        if (state->gen.done())
+            transferList.pop_front();
+    }
+}
+
 RequestPtr
 DmaPort::dmaAction(Packet::Command cmd, Addr addr, int size, Event *event,
                    uint8_t *data, uint32_t sid, uint32_t ssid, Tick delay,
@@ -151,38 +197,35 @@ DmaPort::dmaAction(Packet::Command cmd, Addr addr, int size, Event *event,
 {
     // one DMA request sender state for every action, that is then
     // split into many requests and packets based on the block size,
-    // i.e. cache line size
-    DmaReqState *reqState = new DmaReqState(event, size, delay);
+    // i.e. cache line size, or the page size for bulk transfers
+    const bool bulk_action = bulk && sys->isAtomicMode();
+    DmaReqState *reqState = new DmaReqState(
+        cmd, addr, bulk_action ? sys->getPageBytes() : sys->cacheLineSize(),
+        size, data, flag, sid, ssid, event, delay);
 
     // (functionality added for Table Walker statistics)
     // We're only interested in this when there will only be one request.
     // For simplicity, we return the last request, which would also be
-    // the only request in that case.
+    // the only request in that case. In windowed mode the packets that
+    // do not fit yet are created later, and this is the last one created
+    // now, if any.
     RequestPtr req = NULL;
 
     DPRINTF(DMA, "Starting DMA for addr: %#x size: %d sched: %d\n", addr, size,
             event ? event->scheduled() : -1);
-    for (ChunkGenerator gen(addr, size, sys->cacheLineSize());
-         !gen.done(); gen.next()) {
-
-        req = std::make_shared<Request>(
-            gen.addr(), gen.size(), flag, requestorId);
-
-        req->setStreamId(sid);
-        req->setSubStreamId(ssid);
-
-        req->taskId(ContextSwitchTaskId::DMA);
-        PacketPtr pkt = new Packet(req, cmd);
-
-        // Increment the data pointer on a write
-        if (data)
-            pkt->dataStatic(data + gen.complete());
-
-        pkt->senderState = reqState;
-
-        DPRINTF(DMA, "--Queuing DMA for addr: %#x size: %d\n", gen.addr(),
-                gen.size());
-        queueDma(pkt);
+    if (window && sys->isTimingMode()) {
+        if (!reqState->gen.done())
+            transferList.push_back(reqState);
+        size_t queued = transmitList.size();
+        fillTransmitList();
+        if (transmitList.size() > queued)
+            req = transmitList.back()->req;
+    } else {
+        while (!reqState->gen.done()) {
+            PacketPtr pkt = createPacket(reqState);
+            req = pkt->req;
+            queueDma(pkt);
+        }
     }
 
     // in zero time also initiate the sending of the packets we have
@@ -224,6 +267,7 @@ DmaPort::trySendTimingReq()
     inRetry = !sendTimingReq(pkt);
     if (!inRetry) {
         transmitList.pop_front();
+        fillTransmitList();
         DPRINTF(DMA, "-- Done\n");
         // if there is more to do, then do so
         if (!transmitList.empty())
@@ -246,7 +290,7 @@ DmaPort::sendDma()
     // some kind of selcetion between access methods
     // more work is going to have to be done to make
     // switching actually work
-    assert(transmitList.size());
+    assert(transmitList.size() || transferList.size());
 
     if (sys->isTimingMode()) {
         // if we are either waiting for a retry or are still waiting
@@ -256,6 +300,13 @@ DmaPort::sendDma()
             return;
         }
 
+        // with a full window, the next response restarts the sending
+        fillTransmitList();
+        if (transmitList.empty()) {
+            DPRINTF(DMA, "Window full, waiting for responses\n");
+            return;
+        }
+
         trySendTimingReq();
     } else if (sys->isAtomicMode()) {
         // send everything there is to send in zero time
@@ -44,6 +44,7 @@
 #include <deque>
 #include <memory>
 
+#include "base/chunk_generator.hh"
 #include "base/circlebuf.hh"
 #include "dev/io_device.hh"
 #include "params/DmaDevice.hh"
@@ -100,11 +101,36 @@ class DmaPort : public RequestPort, public Drainable
         /** Amount to delay completion of dma by */
         const Tick delay;
 
-        DmaReqState(Event *ce, Addr tb, Tick _delay)
-            : completionEvent(ce), totBytes(tb), numBytes(0), delay(_delay)
+        /** Chunks of the transaction that have no packet yet. */
+        ChunkGenerator gen;
+
+        /** What the packets of the transaction are created with. */
+        const Packet::Command cmd;
+        uint8_t *const data;
+        const Request::Flags flags;
+        const uint32_t sid;
+        const uint32_t ssid;
+
+        DmaReqState(Packet::Command _cmd, Addr addr, Addr chunk_sz,
+                    Addr tb, uint8_t *_data, Request::Flags _flags,
+                    uint32_t _sid, uint32_t _ssid, Event *ce, Tick _delay)
+            : completionEvent(ce), totBytes(tb), numBytes(0), delay(_delay),
+              gen(addr, tb, chunk_sz), cmd(_cmd), data(_data),
+              flags(_flags), sid(_sid), ssid(_ssid)
         {}
     };
 
+    /**
+     * Create the packet for the next chunk of a transaction.
+     */
+    PacketPtr createPacket(DmaReqState *state);
+
+    /**
+     * In windowed mode, create packets for the transactions waiting on
+     * the transfer list for as long as the window allows.
+     */
+    void fillTransmitList();
+
   public:
     /** The device that owns this port. */
     ClockedObject *const device;
@@ -120,6 +146,13 @@ class DmaPort : public RequestPort, public Drainable
     /** Use a deque as we never do any insertion or removal in the middle */
     std::deque<PacketPtr> transmitList;
 
+    /**
+     * Transactions with chunks that have no packet yet, in windowed
+     * mode. The packets are moved to the transmit list as earlier ones
+     * complete.
+     */
+    std::deque<DmaReqState *> transferList;
+
     /** Event used to schedule a future sending from the transmit list. */
     EventFunctionWrapper sendEvent;
 
@@ -136,6 +169,20 @@ class DmaPort : public RequestPort, public Drainable
     /** Default substreamId */
     const uint32_t defaultSSid;
 
+    /**
+     * Split transfers at page rather than cache line boundaries in
+     * atomic mode, so that they take a handful of packets.
+     */
+    const bool bulk;
+
+    /**
+     * Maximum number of outstanding packets in timing mode, if
+     * non-zero. Packets are then created as they fit instead of all at
+     * once, which keeps large transfers from flooding the transmit list.
+     * Each packet is still a cache line and sent a cycle apart.
+     */
+    const unsigned window;
+
   protected:
 
     bool recvTimingResp(PacketPtr pkt) override;
@@ -146,7 +193,8 @@ class DmaPort : public RequestPort, public Drainable
   public:
 
     DmaPort(ClockedObject *dev, System *s,
-            uint32_t sid = 0, uint32_t ssid = 0);
+            uint32_t sid = 0, uint32_t ssid = 0,
+            bool _bulk = false, unsigned _window = 0);
 
     RequestPtr
     dmaAction(Packet::Command cmd, Addr addr, int size, Event *event,
@@ -157,7 +205,11 @@ class DmaPort : public RequestPort, public Drainable
               uint8_t *data, uint32_t sid, uint32_t ssid, Tick delay,
               Request::Flags flag = 0);
 
-    bool dmaPending() const { return pendingCount > 0; }
+    bool
+    dmaPending() const
+    {
+        return pendingCount > 0 || !transferList.empty();
+    }
 
     DrainState drain() override;
 };
@@ -63,6 +63,8 @@ class EtherLink(SimObject):
     speed = Param.NetworkBandwidth('1Gbps', "link speed")
     dump = Param.EtherDump(NULL, "dump object")
 
+class DistTransport(Enum): vals = ['tcp', 'shm']
+
 class DistEtherLink(SimObject):
     type = 'DistEtherLink'
     cxx_header = "dev/net/dist_etherlink.hh"
@@ -75,8 +77,15 @@ class DistEtherLink(SimObject):
     dist_size = Param.UInt32('1', "Number of gem5 processes (dist run)")
     sync_start = Param.Latency('5200000000000t', "first dist sync barrier")
     sync_repeat = Param.Latency('10us', "dist sync barrier repeat")
+    sync_adaptive = Param.Bool(False, "Stretch the sync barrier repeat "
+        "while no peer can send a packet (the peers must not be driven by "
+        "the host, e.g. through an EtherTap)")
     server_name = Param.String('localhost', "Message server name")
     server_port = Param.UInt32('2200', "Message server port")
+    transport = Param.DistTransport('tcp', "Transport to the peer gem5 "
+        "processes, shm needs all of them on the same host")
+    shm_ring_size = Param.MemorySize('4MB', "Size of each ring of a "
+        "shared memory link")
     is_switch = Param.Bool(False, "true if this a link in etherswitch")
     dist_sync_on_pseudo_op = Param.Bool(False, "Start sync with pseudo_op")
     num_nodes = Param.UInt32('2', "Number of simulate nodes")
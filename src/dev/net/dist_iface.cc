@@ -41,6 +41,7 @@
 
 #include "dev/net/dist_iface.hh"
 
+#include <algorithm>
 #include <queue>
 #include <thread>
 
@@ -62,9 +63,11 @@ unsigned DistIface::distIfaceNum = 0;
 unsigned DistIface::recvThreadsNum = 0;
 DistIface *DistIface::primary = nullptr;
 bool DistIface::isSwitch = false;
+std::atomic<Tick> DistIface::nextArrival(MaxTick);
+std::vector<DistIface::RecvScheduler *> DistIface::recvSchedulers;
 
 void
-DistIface::Sync::init(Tick start_tick, Tick repeat_tick)
+DistIface::Sync::init(Tick start_tick, Tick repeat_tick, bool adaptive_sync)
 {
     if (start_tick < nextAt) {
         nextAt = start_tick;
@@ -79,6 +82,9 @@ DistIface::Sync::init(Tick start_tick, Tick repeat_tick)
         inform("Dist synchronisation interval is changed to %lu.\n",
                nextRepeat);
     }
+
+    // Every link of this gem5 process has to agree
+    adaptive = adaptive && adaptive_sync;
 }
 
 void
@@ -98,11 +104,14 @@ DistIface::SyncSwitch::SyncSwitch(int num_nodes)
     numExitReq = 0;
     numCkptReq = 0;
     numStopSyncReq = 0;
+    minNextSend = MaxTick;
     doExit = false;
     doCkpt = false;
     doStopSync = false;
     nextAt = std::numeric_limits<Tick>::max();
     nextRepeat = std::numeric_limits<Tick>::max();
+    nextSend = 0;
+    adaptive = true;
     isAbort = false;
 }
 
@@ -117,12 +126,17 @@ DistIface::SyncNode::SyncNode()
     doStopSync = false;
     nextAt = std::numeric_limits<Tick>::max();
     nextRepeat = std::numeric_limits<Tick>::max();
+    nextSend = 0;
+    adaptive = true;
     isAbort = false;
 }
 
 bool
 DistIface::SyncNode::run(bool same_tick)
 {
+    // Only a periodic sync can stretch the quantum
+    Tick next_send = same_tick ? nextSendBound() : curTick() + 1;
+
     std::unique_lock<std::mutex> sync_lock(lock);
     Header header;
 
@@ -132,6 +146,7 @@ DistIface::SyncNode::run(bool same_tick)
     // initiate the global synchronisation
     header.msgType = MsgType::cmdSyncReq;
     header.sendTick = curTick();
+    header.nextSendTick = next_send;
     header.syncRepeat = nextRepeat;
     header.needCkpt = needCkpt;
     header.needStopSync = needStopSync;
@@ -167,9 +182,15 @@ DistIface::SyncSwitch::run(bool same_tick)
         return false;
     assert(!same_tick || (nextAt == curTick()));
     waitNum = numNodes;
+    // All the nodes sent their sync requests, so every data packet they
+    // sent earlier has been scheduled here already.
+    nextSend = same_tick ? std::min(minNextSend, nextSendBound()) :
+        curTick() + 1;
+    minNextSend = MaxTick;
     // Complete the global synchronisation
     header.msgType = MsgType::cmdSyncAck;
     header.sendTick = nextAt;
+    header.nextSendTick = nextSend;
     header.syncRepeat = nextRepeat;
     if (doCkpt || numCkptReq == numNodes) {
         doCkpt = true;
@@ -198,6 +219,7 @@ DistIface::SyncSwitch::run(bool same_tick)
 bool
 DistIface::SyncSwitch::progress(Tick send_tick,
                                  Tick sync_repeat,
+                                 Tick next_send,
                                  ReqType need_ckpt,
                                  ReqType need_exit,
                                  ReqType need_stop_sync)
@@ -211,6 +233,8 @@ DistIface::SyncSwitch::progress(Tick send_tick,
         nextAt = send_tick;
     if (nextRepeat > sync_repeat)
         nextRepeat = sync_repeat;
+    if (minNextSend > next_send)
+        minNextSend = next_send;
 
     if (need_ckpt == ReqType::collective)
         numCkptReq++;
@@ -239,6 +263,7 @@ DistIface::SyncSwitch::progress(Tick send_tick,
 bool
 DistIface::SyncNode::progress(Tick max_send_tick,
                                Tick next_repeat,
+                               Tick next_send,
                                ReqType do_ckpt,
                                ReqType do_exit,
                                ReqType do_stop_sync)
@@ -250,6 +275,7 @@ DistIface::SyncNode::progress(Tick max_send_tick,
 
     nextAt = max_send_tick;
     nextRepeat = next_repeat;
+    nextSend = next_send;
     doCkpt = (do_ckpt != ReqType::none);
     doExit = (do_exit != ReqType::none);
     doStopSync = (do_stop_sync != ReqType::none);
@@ -420,9 +446,17 @@ DistIface::SyncEvent::process()
         }
         return;
     }
-    // schedule the next periodic sync
+    // schedule the next periodic sync. No peer can send a packet before
+    // nextSend, so the quantum can be stretched up to the point where
+    // a packet sent at nextSend would still arrive in a later quantum.
+    const Tick now = curTick();
+    const Tick next_send = DistIface::sync->nextSend;
+    const Tick quiet = next_send > now + 1 ? next_send - now - 1 : 0;
     repeat = DistIface::sync->nextRepeat;
-    schedule(curTick() + repeat);
+    repeat += std::min(quiet, MaxTick - now - repeat);
+    DPRINTF(DistEthernet, "Next dist sync at %lu (quantum: %lu)\n",
+            now + repeat, repeat);
+    schedule(now + repeat);
 }
 
 void
@@ -483,6 +517,7 @@ DistIface::RecvScheduler::resumeRecvTicks()
 
     if (recvDone->scheduled()) {
         assert(!descQueue.empty());
+        setRecvDoneTick(curTick());
         eventManager->reschedule(recvDone, curTick());
     } else {
         assert(descQueue.empty() && v.empty());
@@ -518,6 +553,7 @@ DistIface::RecvScheduler::pushPacket(EthPacketPtr new_packet,
     descQueue.emplace(new_packet, send_tick, send_delay);
     if (descQueue.size() == 1) {
         assert(!recvDone->scheduled());
+        setRecvDoneTick(recv_tick);
         eventManager->schedule(recvDone, recv_tick);
     } else {
         assert(recvDone->scheduled());
@@ -541,12 +577,29 @@ DistIface::RecvScheduler::popPacket()
         Tick recv_tick = calcReceiveTick(descQueue.front().sendTick,
                                          descQueue.front().sendDelay,
                                          curTick());
+        setRecvDoneTick(recv_tick);
         eventManager->schedule(recvDone, recv_tick);
+    } else {
+        setRecvDoneTick(MaxTick);
     }
     prevRecvTick = curTick();
     return next_packet;
 }
 
+void
+DistIface::RecvScheduler::setRecvDoneTick(Tick recv_tick)
+{
+    std::lock_guard<std::mutex> recv_done_lock(recvDoneLock);
+    recvDoneTick = recv_tick;
+}
+
+Tick
+DistIface::RecvScheduler::nextRecvTick()
+{
+    std::lock_guard<std::mutex> recv_done_lock(recvDoneLock);
+    return recvDoneTick;
+}
+
 void
 DistIface::RecvScheduler::Desc::serialize(CheckpointOut &cp) const
 {
@@ -603,10 +656,12 @@ DistIface::DistIface(unsigned dist_rank,
                      unsigned dist_size,
                      Tick sync_start,
                      Tick sync_repeat,
+                     bool sync_adaptive,
                      EventManager *em,
                      bool use_pseudo_op,
                      bool is_switch, int num_nodes) :
     syncStart(sync_start), syncRepeat(sync_repeat),
+    syncAdaptive(sync_adaptive),
     recvThread(nullptr), recvScheduler(em), syncStartOnPseudoOp(use_pseudo_op),
     rank(dist_rank), size(dist_size)
 {
@@ -626,6 +681,7 @@ DistIface::DistIface(unsigned dist_rank,
     }
     distIfaceId = distIfaceNum;
     distIfaceNum++;
+    recvSchedulers.push_back(&recvScheduler);
 }
 
 DistIface::~DistIface()
@@ -641,6 +697,8 @@ DistIface::~DistIface()
     }
     if (this == primary)
         primary = nullptr;
+    recvSchedulers.erase(std::find(recvSchedulers.begin(),
+                                   recvSchedulers.end(), &recvScheduler));
 }
 
 void
@@ -657,6 +715,15 @@ DistIface::packetOut(EthPacketPtr pkt, Tick send_delay)
     header.dataPacketLength = pkt->length;
     header.simLength = pkt->simLength;
 
+    if (sync->adaptive) {
+        // The packet cannot reach (and trigger anything at) the peer before
+        // this tick, the sync repeat is never larger than the link delay
+        Tick arrival = curTick() + send_delay + sync->nextRepeat;
+        Tick cur = nextArrival.load(std::memory_order_relaxed);
+        while (arrival < cur &&
+               !nextArrival.compare_exchange_weak(cur, arrival)) {}
+    }
+
     // Send out the packet and the meta info.
     sendPacket(header, pkt);
 
@@ -702,6 +769,7 @@ DistIface::recvThreadFunc(Event *recv_done, Tick link_delay)
             // everything else must be synchronisation related command
             if (!sync->progress(header.sendTick,
                                 header.syncRepeat,
+                                header.nextSendTick,
                                 header.needCkpt,
                                 header.needExit,
                                 header.needStopSync))
@@ -723,6 +791,31 @@ DistIface::spawnRecvThread(const Event *recv_done, Tick link_delay)
     recvThreadsNum++;
 }
 
+Tick
+DistIface::nextSendBound()
+{
+    if (!sync->adaptive)
+        return curTick() + 1;
+
+    // The simulation threads all wait in the barrier of the sync event, so
+    // their event queues are only changed by the receiver threads. Those
+    // only ever schedule receive done events, which their schedulers keep
+    // track of. The next tick the queues publish may therefore miss
+    // nothing but those events, and we do not need to take the queue locks
+    // (one of which we may even be holding).
+    Tick bound = nextArrival.exchange(MaxTick);
+    for (auto scheduler : recvSchedulers)
+        bound = std::min(bound, scheduler->nextRecvTick());
+    for (uint32_t i = 0; i < numMainEventQueues; i++) {
+        const EventQueue *eq = mainEventQueue[i];
+        // Events scheduled from other threads are not sorted in yet
+        if (eq->asyncPending())
+            return curTick() + 1;
+        bound = std::min(bound, eq->nextTickHint());
+    }
+    return std::max(bound, curTick() + 1);
+}
+
 DrainState
 DistIface::drain()
 {
@@ -797,7 +890,7 @@ DistIface::init(const Event *done_event, Tick link_delay)
     // might have different requirements. The singleton sync object
     // will select the minimum values for both params.
     assert(sync != nullptr);
-    sync->init(syncStart, syncRepeat);
+    sync->init(syncStart, syncRepeat, syncAdaptive);
 
     // Initialize the seed for random generator to avoid the same sequence
     // in all gem5 peer processes
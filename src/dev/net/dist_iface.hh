@@ -71,15 +71,19 @@
  * This interface is an abstract class. It can work with various low level
  * send/receive service implementations (e.g. TCP/IP, MPI,...). A TCP
  * stream socket version is implemented in src/dev/net/tcp_iface.[hh,cc].
+ * A shared memory version for runs within a single host is implemented in
+ * src/dev/net/shm_iface.[hh,cc].
  */
 #ifndef __DEV_DIST_IFACE_HH__
 #define __DEV_DIST_IFACE_HH__
 
 #include <array>
+#include <atomic>
 #include <mutex>
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "base/logging.hh"
 #include "dev/net/dist_packet.hh"
@@ -151,12 +155,23 @@ class DistIface : public Drainable, public Serializable
          * Tick for the next periodic sync (if the event is not scheduled yet)
          */
         Tick nextAt;
+        /**
+         * Lower bound on the send tick of the next data packet from any of
+         * the peers (agreed at the last sync)
+         */
+        Tick nextSend;
+        /**
+         * Flag is set if the sync quantum may be stretched while no peer
+         * can send (see SyncEvent::process())
+         */
+        bool adaptive;
         /**
          *  Flag is set if the sync is aborted (e.g. due to connection lost)
          */
         bool isAbort;
 
         friend class SyncEvent;
+        friend class DistIface;
 
       public:
         /**
@@ -164,9 +179,10 @@ class DistIface : public Drainable, public Serializable
          *
          * @param start Start tick for dist synchronisation
          * @param repeat Frequency of dist synchronisation
+         * @param adaptive Stretch the sync quantum while no peer can send
          *
          */
-        void init(Tick start, Tick repeat);
+        void init(Tick start, Tick repeat, bool adaptive);
         /**
          *  Core method to perform a full dist sync.
          *
@@ -181,6 +197,7 @@ class DistIface : public Drainable, public Serializable
          */
         virtual bool progress(Tick send_tick,
                               Tick next_repeat,
+                              Tick next_send,
                               ReqType do_ckpt,
                               ReqType do_exit,
                               ReqType do_stop_sync) = 0;
@@ -223,6 +240,7 @@ class DistIface : public Drainable, public Serializable
         bool run(bool same_tick) override;
         bool progress(Tick max_req_tick,
                       Tick next_repeat,
+                      Tick next_send,
                       ReqType do_ckpt,
                       ReqType do_exit,
                       ReqType do_stop_sync) override;
@@ -250,6 +268,10 @@ class DistIface : public Drainable, public Serializable
          * Counter for recording stop sync requests
          */
         unsigned numStopSyncReq;
+        /**
+         * Minimum of the next send ticks requested in the on-going sync
+         */
+        Tick minNextSend;
         /**
          *  Number of connected simulated nodes
          */
@@ -262,6 +284,7 @@ class DistIface : public Drainable, public Serializable
         bool run(bool same_tick) override;
         bool progress(Tick max_req_tick,
                       Tick next_repeat,
+                      Tick next_send,
                       ReqType do_ckpt,
                       ReqType do_exit,
                       ReqType do_stop_sync) override;
@@ -405,6 +428,20 @@ class DistIface : public Drainable, public Serializable
          * recalculated due to changed link latencies at a resume
          */
         bool ckptRestore;
+        /**
+         * The tick the receive done event is scheduled at (MaxTick if it is
+         * not scheduled).
+         *
+         * @note The receiver thread may schedule the receive done event
+         * during a global sync, so this is protected by its own lock rather
+         * than by the event queue lock (see nextRecvTick()).
+         */
+        Tick recvDoneTick;
+        std::mutex recvDoneLock;
+        /**
+         * Update recvDoneTick, the caller has to hold the event queue lock.
+         */
+        void setRecvDoneTick(Tick recv_tick);
 
       public:
         /**
@@ -415,7 +452,7 @@ class DistIface : public Drainable, public Serializable
          */
         RecvScheduler(EventManager *em) :
             prevRecvTick(0), recvDone(nullptr), linkDelay(0),
-            eventManager(em), ckptRestore(false) {}
+            eventManager(em), ckptRestore(false), recvDoneTick(MaxTick) {}
 
         /**
          *  Initialize network link parameters.
@@ -438,6 +475,13 @@ class DistIface : public Drainable, public Serializable
         void pushPacket(EthPacketPtr new_packet,
                         Tick send_tick,
                         Tick send_delay);
+        /**
+         * The tick the next incoming data packet is received at (MaxTick if
+         * there is none pending).
+         *
+         * @note This may be called without holding the event queue lock.
+         */
+        Tick nextRecvTick();
 
         void serialize(CheckpointOut &cp) const override;
         void unserialize(CheckpointIn &cp) override;
@@ -459,6 +503,10 @@ class DistIface : public Drainable, public Serializable
      * Frequency of dist sync events in ticks.
      */
     Tick syncRepeat;
+    /**
+     * Stretch the sync quantum while no peer can send a packet.
+     */
+    bool syncAdaptive;
     /**
      * Receiver thread pointer.
      * Each DistIface object must have exactly one receiver thread.
@@ -519,6 +567,16 @@ class DistIface : public Drainable, public Serializable
      * Is this node a switch?
      */
      static bool isSwitch;
+    /**
+     * Earliest arrival tick of the data packets sent in the current sync
+     * quantum (by any DistIface in this gem5 process).
+     */
+    static std::atomic<Tick> nextArrival;
+    /**
+     * The receive schedulers of all the DistIface objects in this gem5
+     * process.
+     */
+    static std::vector<RecvScheduler *> recvSchedulers;
 
   private:
     /**
@@ -561,6 +619,17 @@ class DistIface : public Drainable, public Serializable
      * The function executed by a receiver thread.
      */
     void recvThreadFunc(Event *recv_done, Tick link_delay);
+    /**
+     * Lower bound on the tick this gem5 process may send its next data
+     * packet at.
+     * @note Nothing can happen here before the earliest scheduled event or
+     * before a packet we sent arrives at a peer. This is only sound if the
+     * simulation is not driven by the host (e.g. by an EtherTap), hence the
+     * sync_adaptive param.
+     * @note This is called from a global sync, while all the simulation
+     * threads wait in the barrier. It must not take the event queue locks.
+     */
+    static Tick nextSendBound();
 
   public:
 
@@ -569,12 +638,14 @@ class DistIface : public Drainable, public Serializable
      * @param dist_rank Rank of this gem5 process within the dist run
      * @param sync_start Start tick for dist synchronisation
      * @param sync_repeat Frequency for dist synchronisation
+     * @param sync_adaptive Stretch the sync quantum while no peer can send
      * @param em The event manager associated with the simulated Ethernet link
      */
     DistIface(unsigned dist_rank,
               unsigned dist_size,
               Tick sync_start,
               Tick sync_repeat,
+              bool sync_adaptive,
               EventManager *em,
               bool use_pseudo_op,
               bool is_switch,
@@ -84,6 +84,12 @@ class DistHeaderPkt
          */
         MsgType msgType;
         Tick sendTick;
+        /**
+         * Lower bound on the tick the sender (or in a sync ack any of the
+         * peers) may send its next data packet at. Only valid for sync
+         * messages.
+         */
+        Tick nextSendTick;
         /**
          * Length used for modeling timing in the simulator.
          * (from EthPacketData::simLength).
@@ -28,14 +28,90 @@
 
 #include "dev/net/etherpkt.hh"
 
+#include <array>
 #include <iostream>
+#include <vector>
 
 #include "base/inet.hh"
+#include "base/intmath.hh"
 #include "base/logging.hh"
 #include "sim/serialize.hh"
 
 using namespace std;
 
+namespace
+{
+
+/** Smallest size class of packet buffers, 64B */
+const unsigned MinBufferShift = 6;
+
+/**
+ * Largest size class kept on the free lists, 64KiB. Larger buffers go
+ * straight back to the heap.
+ */
+const unsigned MaxBufferShift = 16;
+
+/** Number of buffers kept per size class and thread */
+const size_t MaxFreeBuffers = 256;
+
+typedef std::array<std::vector<uint8_t *>,
+                   MaxBufferShift - MinBufferShift + 1> BufferLists;
+
+/**
+ * The free lists are allocated on first use and never destroyed, so
+ * that packets released during static destruction find them intact.
+ */
+thread_local BufferLists *freeBuffers = nullptr;
+
+unsigned
+sizeClass(unsigned size)
+{
+    return size <= (1U << MinBufferShift) ?
+        0 : ceilLog2(size) - MinBufferShift;
+}
+
+} // anonymous namespace
+
+uint8_t *
+EthPacketData::allocBuffer(unsigned size)
+{
+    const unsigned cls = sizeClass(size);
+    if (cls > MaxBufferShift - MinBufferShift)
+        return new uint8_t[size];
+
+    if (!freeBuffers)
+        freeBuffers = new BufferLists;
+
+    auto &list = (*freeBuffers)[cls];
+    if (list.empty())
+        return new uint8_t[1U << (cls + MinBufferShift)];
+
+    uint8_t *buf = list.back();
+    list.pop_back();
+    return buf;
+}
+
+void
+EthPacketData::freeBuffer(uint8_t *buf, unsigned size)
+{
+    // A buffer is never smaller than the size class it goes back to, as
+    // bufLength can only shrink after the buffer has been allocated.
+    const unsigned cls = sizeClass(size);
+    if (cls > MaxBufferShift - MinBufferShift) {
+        delete [] buf;
+        return;
+    }
+
+    if (!freeBuffers)
+        freeBuffers = new BufferLists;
+
+    auto &list = (*freeBuffers)[cls];
+    if (list.size() >= MaxFreeBuffers)
+        delete [] buf;
+    else
+        list.push_back(buf);
+}
+
 void
 EthPacketData::serialize(const string &base, CheckpointOut &cp) const
 {
@@ -64,7 +140,7 @@ EthPacketData::unserialize(const string &base, CheckpointIn &cp)
     }
     assert(length <= bufLength);
     if (!data)
-        data = new uint8_t[bufLength];
+        data = allocBuffer(bufLength);
     arrayParamIn(cp, base + ".data", data, length);
     if (!optParamIn(cp, base + ".simLength", simLength))
         simLength = length;
@@ -75,10 +75,18 @@ class EthPacketData
     { }
 
     explicit EthPacketData(unsigned size)
-        : data(new uint8_t[size]), bufLength(size), length(0), simLength(0)
+        : data(allocBuffer(size)), bufLength(size), length(0), simLength(0)
     { }
 
-    ~EthPacketData() { if (data) delete [] data; }
+    ~EthPacketData() { if (data) freeBuffer(data, bufLength); }
+
+    /**
+     * Packet buffers are recycled through per-thread free lists of power
+     * of two size classes, as every packet a NIC sends or dist-gem5
+     * receives would otherwise be a fresh heap allocation.
+     */
+    static uint8_t *allocBuffer(unsigned size);
+    static void freeBuffer(uint8_t *buf, unsigned size);
 
     void serialize(const std::string &base, CheckpointOut &cp) const;
     void unserialize(const std::string &base, CheckpointIn &cp);
@@ -79,7 +79,7 @@ class EtherSwitch : public SimObject
         /**
          * enqueue packet to the outputFifo
          */
-        void enqueue(EthPacketPtr packet, unsigned senderId);
+        void enqueue(const EthPacketPtr &packet, unsigned senderId);
         void sendDone() {}
         Tick switchingDelay();
 
@@ -99,7 +99,7 @@ class EtherSwitch : public SimObject
       protected:
         struct PortFifoEntry : public Serializable
         {
-            PortFifoEntry(EthPacketPtr pkt, Tick recv_tick, unsigned id)
+            PortFifoEntry(const EthPacketPtr &pkt, Tick recv_tick, unsigned id)
                 : packet(pkt), recvTick(recv_tick), srcId(id) {}
 
             EthPacketPtr packet;
@@ -148,7 +148,7 @@ class EtherSwitch : public SimObject
             // and remove packets from the end of fifo
             int avail() const { return _maxsize - _size; }
 
-            EthPacketPtr front() { return fifo.begin()->packet; }
+            const EthPacketPtr &front() { return fifo.begin()->packet; }
             bool empty() const { return _size == 0; }
             unsigned size() const { return _size; }
 
@@ -156,7 +156,7 @@ class EtherSwitch : public SimObject
              * Push a packet into the fifo
              * and sort the packets with same recv tick by port id
              */
-            bool push(EthPacketPtr ptr, unsigned senderId);
+            bool push(const EthPacketPtr &ptr, unsigned senderId);
             void pop();
             void clear();
             /**
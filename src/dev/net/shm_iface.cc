@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Shared memory based interface class for dist-gem5 runs.
+ */
+
+#include "dev/net/shm_iface.hh"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#endif
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/DistEthernet.hh"
+#include "debug/DistEthernetCmd.hh"
+#include "sim/sim_exit.hh"
+
+using namespace std;
+
+struct ShmIface::Ring
+{
+    /**
+     * Bytes written by the producer so far.
+     */
+    alignas(64) std::atomic<uint64_t> tail;
+    /**
+     * Bumped by the producer for every message (futex word).
+     */
+    std::atomic<uint32_t> dataSeq;
+    /**
+     * Set while the consumer sleeps on dataSeq.
+     */
+    std::atomic<uint32_t> consumerWaiting;
+
+    /**
+     * Bytes consumed so far.
+     */
+    alignas(64) std::atomic<uint64_t> head;
+    /**
+     * Bumped by the consumer for every message (futex word).
+     */
+    std::atomic<uint32_t> spaceSeq;
+    /**
+     * Set while the producer sleeps on spaceSeq.
+     */
+    std::atomic<uint32_t> producerWaiting;
+};
+
+struct ShmIface::Segment
+{
+    /**
+     * Set by the node once the link info below is valid.
+     */
+    std::atomic<uint32_t> magic;
+    /**
+     * Set by either end when it goes away.
+     */
+    std::atomic<uint32_t> closed;
+    uint64_t ringSize;
+
+    /**
+     * Link info of the node end (cf. TCPIface::NodeInfo).
+     */
+    uint32_t rank;
+    uint32_t distIfaceId;
+    uint32_t distIfaceNum;
+    pid_t nodePid;
+
+    /**
+     * Bumped by the switch to ack the link (futex word).
+     */
+    std::atomic<uint32_t> ack;
+    std::atomic<uint32_t> nodeWaiting;
+    uint32_t switchIfaceId;
+    pid_t switchPid;
+
+    Ring toSwitch;
+    Ring toNode;
+};
+
+struct ShmIface::Server
+{
+    std::atomic<uint32_t> magic;
+    pid_t pid;
+};
+
+namespace
+{
+
+const uint32_t Magic = 0x35736d67; // "gms5"
+
+/**
+ * The rings start at the first page boundary after the control area.
+ */
+const size_t ControlBytes = 4096;
+
+/**
+ * A ring must take at least a maximum size (jumbo) frame.
+ */
+const uint64_t MinRingSize = 128 * 1024;
+
+/**
+ * Number of polls before a waiting thread goes to sleep. A sync barrier
+ * usually completes well within that.
+ */
+const unsigned SpinCount = 4096;
+
+/**
+ * Sleeping threads wake up this often to check if the other end is still
+ * alive.
+ */
+const long WaitTimeoutNs = 100 * 1000 * 1000;
+
+/**
+ * Poll interval of the switch while waiting for a node to show up.
+ */
+const unsigned AcceptPollUs = 1000;
+
+void
+futexWait(std::atomic<uint32_t> &word, uint32_t val)
+{
+#if defined(__linux__)
+    // Not FUTEX_PRIVATE, the word is shared with another process
+    struct timespec ts = { 0, WaitTimeoutNs };
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT,
+            val, &ts, nullptr, 0);
+#else
+    this_thread::sleep_for(chrono::microseconds(50));
+#endif
+}
+
+void
+futexWake(std::atomic<uint32_t> &word)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+/**
+ * Publish progress on a futex word and wake up the other end if it
+ * sleeps on it.
+ */
+void
+notify(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &waiting)
+{
+    seq.fetch_add(1, memory_order_release);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (waiting.load(memory_order_relaxed))
+        futexWake(seq);
+}
+
+bool
+processAlive(pid_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+void
+copyIn(uint8_t *ring, uint64_t size, uint64_t pos, const void *src,
+       size_t len)
+{
+    const size_t off = pos & (size - 1);
+    const size_t first = min<uint64_t>(len, size - off);
+    memcpy(ring + off, src, first);
+    memcpy(ring, (const uint8_t *)src + first, len - first);
+}
+
+void
+copyOut(void *dst, const uint8_t *ring, uint64_t size, uint64_t pos,
+        size_t len)
+{
+    const size_t off = pos & (size - 1);
+    const size_t first = min<uint64_t>(len, size - off);
+    memcpy(dst, ring + off, first);
+    memcpy((uint8_t *)dst + first, ring, len - first);
+}
+
+} // anonymous namespace
+
+ShmIface::Server *ShmIface::server = nullptr;
+unsigned ShmIface::listenPort = 0;
+vector<ShmIface *> ShmIface::ifaceRegistry;
+
+ShmIface::ShmIface(unsigned server_port, uint64_t ring_size,
+                   unsigned dist_rank, unsigned dist_size,
+                   Tick sync_start, Tick sync_repeat, bool sync_adaptive,
+                   EventManager *em, bool use_pseudo_op, bool is_switch,
+                   int num_nodes) :
+    DistIface(dist_rank, dist_size, sync_start, sync_repeat, sync_adaptive,
+              em, use_pseudo_op, is_switch, num_nodes),
+    segment(nullptr), segmentSize(0), txRing(nullptr), txData(nullptr),
+    rxRing(nullptr), rxData(nullptr), ringSize(ring_size),
+    serverPort(server_port), isSwitch(is_switch), peerPid(0)
+{
+    static_assert(sizeof(Segment) <= ControlBytes,
+                  "ShmIface control area does not fit");
+    fatal_if(!isPowerOf2(ringSize) || ringSize < MinRingSize,
+             "shm_iface: ring size must be a power of 2 and at least %d "
+             "bytes", MinRingSize);
+
+    if (is_switch && isPrimary) {
+        while (!listen(serverPort)) {
+            DPRINTF(DistEthernet, "ShmIface(listen): Port %d is in use\n",
+                    serverPort);
+            serverPort++;
+        }
+        listenPort = serverPort;
+        inform("shm_iface listening on port %d", serverPort);
+    }
+}
+
+ShmIface::~ShmIface()
+{
+    if (segment && txRing) {
+        // Let the other end (and our own receiver thread) know that the link
+        // is gone
+        segment->closed.store(1);
+        for (Ring *r : { txRing, rxRing }) {
+            notify(r->dataSeq, r->consumerWaiting);
+            notify(r->spaceSeq, r->producerWaiting);
+        }
+        // The receiver thread runs until ~DistIface joins it, so the segment
+        // stays mapped until the process exits.
+    }
+    if (server && isPrimary) {
+        shm_unlink(serverSegmentName(listenPort).c_str());
+        munmap(server, sizeof(Server));
+        server = nullptr;
+    }
+}
+
+string
+ShmIface::serverSegmentName(unsigned port) const
+{
+    return csprintf("/gem5-dist.%d", port);
+}
+
+string
+ShmIface::linkSegmentName(unsigned node_rank, unsigned iface_id) const
+{
+    return csprintf("/gem5-dist.%d.%d.%d", serverPort, node_rank, iface_id);
+}
+
+pid_t
+ShmIface::serverOwner(const string &name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    pid_t pid = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Server)) {
+        void *p = mmap(nullptr, sizeof(Server), PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            const Server *srv = reinterpret_cast<const Server *>(p);
+            if (srv->magic.load(memory_order_acquire) == Magic)
+                pid = srv->pid;
+            munmap(p, sizeof(Server));
+        }
+    }
+    close(fd);
+    return pid;
+}
+
+bool
+ShmIface::listen(unsigned port)
+{
+    const string name = serverSegmentName(port);
+
+    for (;;) {
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) {
+            panic_if(ftruncate(fd, sizeof(Server)) != 0,
+                     "ftruncate() failed: %s", strerror(errno));
+            void *p = mmap(nullptr, sizeof(Server), PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd, 0);
+            panic_if(p == MAP_FAILED, "mmap() failed: %s", strerror(errno));
+            close(fd);
+
+            server = reinterpret_cast<Server *>(p);
+            server->pid = getpid();
+            server->magic.store(Magic, memory_order_release);
+            return true;
+        }
+        panic_if(errno != EEXIST, "shm_open() failed: %s", strerror(errno));
+
+        // Somebody else has the port, take it over only if it is a leftover
+        // of a switch that is gone
+        pid_t owner = serverOwner(name);
+        if (owner == 0 || processAlive(owner))
+            return false;
+        if (owner > 0) {
+            DPRINTF(DistEthernet, "ShmIface(listen): Reclaiming %s\n", name);
+            shm_unlink(name.c_str());
+        }
+    }
+}
+
+void
+ShmIface::accept(unsigned node_rank, unsigned iface_id)
+{
+    const string name = linkSegmentName(node_rank, iface_id);
+
+    // The node creates the segment, wait till it shows up complete
+    for (;;) {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && st.st_size >= (off_t)ControlBytes) {
+                void *p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, fd, 0);
+                panic_if(p == MAP_FAILED, "mmap() failed: %s",
+                         strerror(errno));
+                Segment *seg = reinterpret_cast<Segment *>(p);
+                if (seg->magic.load(memory_order_acquire) == Magic &&
+                    processAlive(seg->nodePid)) {
+                    close(fd);
+                    segment = seg;
+                    segmentSize = st.st_size;
+                    break;
+                }
+                munmap(p, st.st_size);
+            }
+            close(fd);
+        }
+        usleep(AcceptPollUs);
+    }
+
+    ringSize = segment->ringSize;
+    panic_if(segmentSize < ControlBytes + 2 * ringSize,
+             "Truncated dist-gem5 link segment %s", name);
+    assert(segment->rank == node_rank);
+    assert(segment->distIfaceId == iface_id);
+    peerPid = segment->nodePid;
+}
+
+void
+ShmIface::connect()
+{
+    // The switch has to be up already, just like the server of a TCP
+    // connection
+    pid_t owner = serverOwner(serverSegmentName(serverPort));
+    fatal_if(owner <= 0 || !processAlive(owner),
+             "shm_iface: No dist-gem5 switch is serving port %d", serverPort);
+    peerPid = owner;
+
+    // The switch owns the port, so a segment with our name can only be a
+    // leftover of a crashed run
+    const string name = linkSegmentName(rank, distIfaceId);
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    panic_if(fd < 0, "shm_open() failed: %s", strerror(errno));
+
+    segmentSize = ControlBytes + 2 * ringSize;
+    panic_if(ftruncate(fd, segmentSize) != 0,
+             "ftruncate() failed: %s", strerror(errno));
+    void *p = mmap(nullptr, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+    panic_if(p == MAP_FAILED, "mmap() failed: %s", strerror(errno));
+    close(fd);
+
+    // The fresh segment is zero filled, i.e. both rings are empty
+    segment = reinterpret_cast<Segment *>(p);
+    segment->ringSize = ringSize;
+    segment->rank = rank;
+    segment->distIfaceId = distIfaceId;
+    segment->distIfaceNum = distIfaceNum;
+    segment->nodePid = getpid();
+    segment->magic.store(Magic, memory_order_release);
+
+    DPRINTF(DistEthernet, "Connected, waiting for ack (distIfaceId:%d\n",
+            distIfaceId);
+    if (!waitFor([this]() {
+                return segment->ack.load(memory_order_acquire) != 0; },
+            segment->ack, segment->nodeWaiting))
+        panic("Failed to receive ack");
+
+    // Both ends have it mapped, the name is not needed anymore
+    shm_unlink(name.c_str());
+}
+
+void
+ShmIface::setupRings()
+{
+    uint8_t *data = reinterpret_cast<uint8_t *>(segment) + ControlBytes;
+    if (isSwitch) {
+        txRing = &segment->toNode;
+        txData = data + ringSize;
+        rxRing = &segment->toSwitch;
+        rxData = data;
+    } else {
+        txRing = &segment->toSwitch;
+        txData = data;
+        rxRing = &segment->toNode;
+        rxData = data + ringSize;
+    }
+}
+
+void
+ShmIface::establishConnection()
+{
+    static unsigned cur_rank = 0;
+    static unsigned cur_id = 0;
+
+    if (isSwitch) {
+        // Switch ports are connected to the node links in (rank, iface id)
+        // order, as with TCPIface
+        serverPort = listenPort;
+        accept(cur_rank, cur_id);
+        inform("Link okay  (iface:%d -> (node:%d, iface:%d))",
+               distIfaceId, cur_rank, cur_id);
+        if (cur_id < segment->distIfaceNum - 1) {
+            cur_id++;
+        } else {
+            cur_rank++;
+            cur_id = 0;
+        }
+        setupRings();
+        // send ack
+        segment->switchIfaceId = distIfaceId;
+        segment->switchPid = getpid();
+        notify(segment->ack, segment->nodeWaiting);
+    } else { // this is not a switch
+        connect();
+        setupRings();
+        inform("Link okay  (iface:%d -> switch iface:%d)", distIfaceId,
+               segment->switchIfaceId);
+    }
+    ifaceRegistry.push_back(this);
+}
+
+bool
+ShmIface::peerGone() const
+{
+    return segment->closed.load(memory_order_relaxed) ||
+        !processAlive(peerPid);
+}
+
+template <typename Cond>
+bool
+ShmIface::waitFor(Cond cond, std::atomic<uint32_t> &seq,
+                  std::atomic<uint32_t> &waiting)
+{
+    for (unsigned i = 0; i < SpinCount; i++) {
+        if (cond())
+            return true;
+        if (i >= SpinCount / 2)
+            this_thread::yield();
+    }
+
+    for (;;) {
+        waiting.store(1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        // Sample the futex word before the last check, any progress after
+        // that makes futexWait() return right away
+        const uint32_t val = seq.load(memory_order_acquire);
+        if (cond())
+            break;
+        futexWait(seq, val);
+        if (cond())
+            break;
+        if (peerGone()) {
+            waiting.store(0, memory_order_relaxed);
+            return cond();
+        }
+    }
+    waiting.store(0, memory_order_relaxed);
+    return true;
+}
+
+void
+ShmIface::sendMsg(const Header &header, const void *payload,
+                  unsigned length)
+{
+    const uint64_t bytes = sizeof(header) + roundUp(length, 8);
+    fatal_if(bytes > ringSize, "shm_iface: %d byte message does not fit "
+             "in the %d byte ring", bytes, ringSize);
+
+    lock_guard<mutex> guard(txLock);
+
+    const uint64_t tail = txRing->tail.load(memory_order_relaxed);
+    auto has_space = [this, tail, bytes]() {
+        return ringSize - (tail - txRing->head.load(memory_order_acquire)) >=
+            bytes;
+    };
+    if (!waitFor(has_space, txRing->spaceSeq, txRing->producerWaiting)) {
+        exitSimLoop("Message server closed connection, simulation "
+                    "is exiting");
+        return;
+    }
+
+    copyIn(txData, ringSize, tail, &header, sizeof(header));
+    if (length)
+        copyIn(txData, ringSize, tail + sizeof(header), payload, length);
+    txRing->tail.store(tail + bytes, memory_order_release);
+    notify(txRing->dataSeq, txRing->consumerWaiting);
+}
+
+void
+ShmIface::consume(uint64_t bytes)
+{
+    const uint64_t head = rxRing->head.load(memory_order_relaxed);
+    rxRing->head.store(head + bytes, memory_order_release);
+    notify(rxRing->spaceSeq, rxRing->producerWaiting);
+}
+
+void
+ShmIface::sendPacket(const Header &header, const EthPacketPtr &packet)
+{
+    sendMsg(header, packet->data, packet->length);
+}
+
+void
+ShmIface::sendCmd(const Header &header)
+{
+    DPRINTF(DistEthernetCmd, "ShmIface::sendCmd() type: %d\n",
+            static_cast<int>(header.msgType));
+    // Global commands (i.e. sync request) are always sent by the primary
+    // DistIface to every link, as with TCPIface
+    for (auto iface : ifaceRegistry)
+        iface->sendMsg(header, nullptr, 0);
+}
+
+bool
+ShmIface::recvHeader(Header &header)
+{
+    const uint64_t head = rxRing->head.load(memory_order_relaxed);
+    auto has_header = [this, head]() {
+        return rxRing->tail.load(memory_order_acquire) - head >=
+            sizeof(Header);
+    };
+    bool ret = waitFor(has_header, rxRing->dataSeq, rxRing->consumerWaiting);
+    if (ret) {
+        copyOut(&header, rxData, ringSize, head, sizeof(header));
+        // The payload of a data packet is consumed by recvPacket()
+        if (header.msgType != MsgType::dataDescriptor)
+            consume(sizeof(header));
+    } else {
+        inform("shm_iface: Link closed");
+    }
+    DPRINTF(DistEthernetCmd, "ShmIface::recvHeader() type: %d ret: %d\n",
+            static_cast<int>(header.msgType), ret);
+    return ret;
+}
+
+void
+ShmIface::recvPacket(const Header &header, EthPacketPtr &packet)
+{
+    // The producer publishes whole messages, so the payload is already there
+    const uint64_t head = rxRing->head.load(memory_order_relaxed);
+    packet = make_shared<EthPacketData>(header.dataPacketLength);
+    copyOut(packet->data, rxData, ringSize, head + sizeof(header),
+            header.dataPacketLength);
+    consume(sizeof(header) + roundUp(header.dataPacketLength, 8));
+    packet->simLength = header.simLength;
+    packet->length = header.dataPacketLength;
+}
+
+void
+ShmIface::initTransport()
+{
+    // As with TCPIface, links can only be set up once the number of dist
+    // interfaces (per process) is known.
+    establishConnection();
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* @file
+ * Shared memory based interface class for dist-gem5 runs.
+ *
+ * For a high level description about dist-gem5 see comments in
+ * header file dist_iface.hh.
+ *
+ * This transport is meant for dist-gem5 runs where all the gem5 processes
+ * share one host. Each compute node link maps a memory segment together
+ * with the switch port it is connected to. The segment holds two single
+ * producer/single consumer rings (one per direction) that carry the same
+ * header + payload messages the TCPIface puts on the wire. Waiting for a
+ * message (or for ring space) spins briefly and then sleeps on a futex in
+ * the segment, so a sync barrier costs a few cache line transfers instead
+ * of loopback socket round trips.
+ *
+ * The switch process owns a small server segment named after the server
+ * port. It plays the role of the listening socket: it keeps concurrent
+ * runs apart and lets segments left behind by crashed runs be reclaimed.
+ */
+#ifndef __DEV_NET_SHM_IFACE_HH__
+#define __DEV_NET_SHM_IFACE_HH__
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dev/net/dist_iface.hh"
+
+class EventManager;
+
+class ShmIface : public DistIface
+{
+  private:
+    /**
+     * Control block of a ring, the ring data follows the control blocks of
+     * the segment.
+     */
+    struct Ring;
+    /**
+     * Layout of the control area of a link segment.
+     */
+    struct Segment;
+    /**
+     * Layout of the server segment owned by the switch.
+     */
+    struct Server;
+
+    /**
+     * The shared segment of this link.
+     */
+    Segment *segment;
+    size_t segmentSize;
+
+    /**
+     * Ring (and its data) we send messages through.
+     */
+    Ring *txRing;
+    uint8_t *txData;
+    /**
+     * Ring (and its data) we receive messages from.
+     */
+    Ring *rxRing;
+    uint8_t *rxData;
+    /**
+     * Size of a ring data area in bytes (a power of 2).
+     */
+    uint64_t ringSize;
+    /**
+     * Global commands are sent from the primary interface through every
+     * ring, so the producer side of a ring may be used by more than one
+     * simulation thread.
+     */
+    std::mutex txLock;
+
+    unsigned serverPort;
+    bool isSwitch;
+    /**
+     * Process at the other end of the link, used to detect if it is gone.
+     */
+    pid_t peerPid;
+
+    /**
+     * The server segment (switch only).
+     */
+    static Server *server;
+    /**
+     * The port the switch ended up serving (switch only).
+     */
+    static unsigned listenPort;
+    /**
+     * Storage for all connected interfaces
+     */
+    static std::vector<ShmIface *> ifaceRegistry;
+
+  private:
+    std::string serverSegmentName(unsigned port) const;
+    std::string linkSegmentName(unsigned node_rank, unsigned iface_id) const;
+    /**
+     * Claim the server segment for a port.
+     *
+     * @param port Server port the segment names are derived from.
+     * @return false if another live switch process owns the port.
+     */
+    bool listen(unsigned port);
+    /**
+     * Owner of a server segment.
+     * @return -1 if there is no such segment, 0 if its owner has not set
+     * it up yet, the pid of the owner otherwise.
+     */
+    static pid_t serverOwner(const std::string &name);
+    /**
+     * Map the segment of the next node link (switch side).
+     */
+    void accept(unsigned node_rank, unsigned iface_id);
+    /**
+     * Create and map the segment of this link (node side).
+     */
+    void connect();
+    void establishConnection();
+    /**
+     * Point the tx/rx rings to the right halves of the segment.
+     */
+    void setupRings();
+
+    /**
+     * Check if the other end of the link closed it or died.
+     */
+    bool peerGone() const;
+    /**
+     * Wait until a condition on the shared state of a ring holds.
+     *
+     * @param cond The condition.
+     * @param seq Futex word bumped by the other end on any progress.
+     * @param waiting Flag telling the other end that we sleep on seq.
+     * @return false if the other end is gone.
+     */
+    template <typename Cond>
+    bool waitFor(Cond cond, std::atomic<uint32_t> &seq,
+                 std::atomic<uint32_t> &waiting);
+    /**
+     * Put a message into the tx ring.
+     *
+     * @param header Meta info of the message.
+     * @param payload Optional payload to send after the header.
+     * @param length Size of the payload in bytes.
+     */
+    void sendMsg(const Header &header, const void *payload, unsigned length);
+    /**
+     * Release a received message to the producer.
+     */
+    void consume(uint64_t bytes);
+
+  protected:
+
+    void sendPacket(const Header &header,
+                    const EthPacketPtr &packet) override;
+
+    void sendCmd(const Header &header) override;
+
+    bool recvHeader(Header &header) override;
+
+    void recvPacket(const Header &header, EthPacketPtr &packet) override;
+
+    void initTransport() override;
+
+  public:
+    /**
+     * The ctor claims the server segment on the switch, the link segments
+     * are set up by initTransport().
+     * @param server_port The port number segment names are derived from.
+     * @param ring_size Size of each ring of a link segment in bytes.
+     * @param sync_start The tick for the first dist synchronisation.
+     * @param sync_repeat The frequency of dist synchronisation.
+     * @param sync_adaptive Stretch the sync quantum while no peer can send.
+     * @param em The EventManager object associated with the simulated
+     * Ethernet link.
+     */
+    ShmIface(unsigned server_port, uint64_t ring_size,
+             unsigned dist_rank, unsigned dist_size,
+             Tick sync_start, Tick sync_repeat, bool sync_adaptive,
+             EventManager *em, bool use_pseudo_op, bool is_switch,
+             int num_nodes);
+
+    ~ShmIface() override;
+};
+
+#endif // __DEV_NET_SHM_IFACE_HH__
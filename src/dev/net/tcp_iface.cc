@@ -80,11 +80,12 @@ bool TCPIface::anyListening = false;
 
 TCPIface::TCPIface(string server_name, unsigned server_port,
                    unsigned dist_rank, unsigned dist_size,
-                   Tick sync_start, Tick sync_repeat,
+                   Tick sync_start, Tick sync_repeat, bool sync_adaptive,
                    EventManager *em, bool use_pseudo_op, bool is_switch,
                    int num_nodes) :
-    DistIface(dist_rank, dist_size, sync_start, sync_repeat, em, use_pseudo_op,
-              is_switch, num_nodes), serverName(server_name),
+    DistIface(dist_rank, dist_size, sync_start, sync_repeat, sync_adaptive,
+              em, use_pseudo_op, is_switch, num_nodes),
+    serverName(server_name),
     serverPort(server_port), isSwitch(is_switch), listening(false)
 {
     if (is_switch && isPrimary) {
@@ -276,6 +277,42 @@ TCPIface::sendTCP(int sock, const void *buf, unsigned length)
     panic_if(ret != length, "send() failed");
 }
 
+void
+TCPIface::sendTCP(int sock, struct iovec *iov, int iovcnt)
+{
+    while (iovcnt) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+
+        ssize_t ret = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ECONNRESET || errno == EPIPE) {
+                exitSimLoop("Message server closed connection, simulation "
+                            "is exiting");
+                return;
+            } else {
+                panic("sendmsg() failed: %s", strerror(errno));
+            }
+        }
+
+        // Skip over what was sent, a short send leaves the rest for the
+        // next round
+        while (iovcnt && (size_t)ret >= iov->iov_len) {
+            ret -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt) {
+            iov->iov_base = (uint8_t *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+}
+
 bool
 TCPIface::recvTCP(int sock, void *buf, unsigned length)
 {
@@ -298,8 +335,14 @@ TCPIface::recvTCP(int sock, void *buf, unsigned length)
 void
 TCPIface::sendPacket(const Header &header, const EthPacketPtr &packet)
 {
-    sendTCP(sock, &header, sizeof(header));
-    sendTCP(sock, packet->data, packet->length);
+    // Send the header and the payload straight from the packet buffer,
+    // in one go
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<Header *>(&header);
+    iov[0].iov_len = sizeof(header);
+    iov[1].iov_base = packet->data;
+    iov[1].iov_len = packet->length;
+    sendTCP(sock, iov, 2);
 }
 
 void
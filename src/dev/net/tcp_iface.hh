@@ -50,6 +50,8 @@
 #define __DEV_NET_TCP_IFACE_HH__
 
 
+#include <sys/uio.h>
+
 #include <string>
 
 #include "dev/net/dist_iface.hh"
@@ -101,6 +103,16 @@ class TCPIface : public DistIface
     void
     sendTCP(int sock, const void *buf, unsigned length);
 
+    /**
+     * Send out a message gathered from several buffers through a TCP
+     * stream socket, with as few system calls as possible.
+     *
+     * @param sock TCP stream socket.
+     * @param iov Buffers of the message, updated as they are sent.
+     * @param iovcnt Number of buffers.
+     */
+    void sendTCP(int sock, struct iovec *iov, int iovcnt);
+
     /**
      * Receive the next incoming message through a TCP stream socket.
      *
@@ -139,13 +151,15 @@ class TCPIface : public DistIface
      * connections.
      * @param sync_start The tick for the first dist synchronisation.
      * @param sync_repeat The frequency of dist synchronisation.
+     * @param sync_adaptive Stretch the sync quantum while no peer can send.
      * @param em The EventManager object associated with the simulated
      * Ethernet link.
      */
     TCPIface(std::string server_name, unsigned server_port,
              unsigned dist_rank, unsigned dist_size,
-             Tick sync_start, Tick sync_repeat, EventManager *em,
-             bool use_pseudo_op, bool is_switch, int num_nodes);
+             Tick sync_start, Tick sync_repeat, bool sync_adaptive,
+             EventManager *em, bool use_pseudo_op, bool is_switch,
+             int num_nodes);
 
     ~TCPIface() override;
 };
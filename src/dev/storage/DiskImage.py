@@ -42,5 +42,5 @@ class CowDiskImage(DiskImage):
     cxx_header = "dev/storage/disk_image.hh"
     child = Param.DiskImage(RawDiskImage(read_only=True),
                             "child image")
-    table_size = Param.Int(65536, "initial table size")
+    table_size = Param.Int(65536, "unused, the overlay is a sparse mapping")
     image_file = ""
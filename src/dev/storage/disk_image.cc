@@ -32,16 +32,22 @@
 
 #include "dev/storage/disk_image.hh"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <fstream>
 #include <string>
 
+#include "base/bitfield.hh"
 #include "base/callback.hh"
+#include "base/intmath.hh"
 #include "base/logging.hh"
 #include "base/trace.hh"
 #include "debug/DiskImageRead.hh"
@@ -51,12 +57,45 @@
 
 using namespace std;
 
+////////////////////////////////////////////////////////////////////////
+//
+// Disk image
+//
+std::streampos
+DiskImage::readSectors(uint8_t *data, std::streampos offset,
+                       unsigned count) const
+{
+    std::streamoff bytes = 0;
+    for (unsigned i = 0; i < count; i++) {
+        std::streamoff done = read(data + bytes, offset + (std::streamoff)i);
+        bytes += done;
+        if (done != SectorSize)
+            break;
+    }
+    return bytes;
+}
+
+std::streampos
+DiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                        unsigned count)
+{
+    std::streamoff bytes = 0;
+    for (unsigned i = 0; i < count; i++) {
+        std::streamoff done = write(data + bytes,
+                                    offset + (std::streamoff)i);
+        bytes += done;
+        if (done != SectorSize)
+            break;
+    }
+    return bytes;
+}
+
 ////////////////////////////////////////////////////////////////////////
 //
 // Raw Disk image
 //
 RawDiskImage::RawDiskImage(const Params* p)
-    : DiskImage(p), disk_size(0)
+    : DiskImage(p), disk_size(0), mapping(nullptr), mappingBytes(0)
 { open(p->image_file, p->read_only); }
 
 RawDiskImage::~RawDiskImage()
@@ -81,6 +120,29 @@ RawDiskImage::open(const string &filename, bool rd_only)
         readonly = rd_only;
         file = filename;
 
+        // Map regular files, which covers disk images in all but unusual
+        // setups. Writes to a read-write image go straight to the page
+        // cache through the shared mapping.
+        int fd = ::open(file.c_str(), readonly ? O_RDONLY : O_RDWR);
+        if (fd < 0)
+            panic("Error opening %s", filename);
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void *addr = mmap(NULL, st.st_size,
+                              PROT_READ | (readonly ? 0 : PROT_WRITE),
+                              MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                mapping = (uint8_t *)addr;
+                mappingBytes = st.st_size;
+                disk_size = st.st_size;
+            }
+        }
+        ::close(fd);
+
+        if (mapping)
+            return;
+
         ios::openmode mode = ios::in | ios::binary;
         if (!readonly)
             mode |= ios::out;
@@ -93,6 +155,11 @@ RawDiskImage::open(const string &filename, bool rd_only)
 void
 RawDiskImage::close()
 {
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+        mappingBytes = 0;
+    }
     stream.close();
 }
 
@@ -111,28 +178,53 @@ RawDiskImage::size() const
 
 std::streampos
 RawDiskImage::read(uint8_t *data, std::streampos offset) const
+{
+    return readSectors(data, offset, 1);
+}
+
+std::streampos
+RawDiskImage::write(const uint8_t *data, std::streampos offset)
+{
+    return writeSectors(data, offset, 1);
+}
+
+std::streampos
+RawDiskImage::readSectors(uint8_t *data, std::streampos offset,
+                          unsigned count) const
 {
     if (!initialized)
         panic("RawDiskImage not initialized");
 
-    if (!stream.is_open())
-        panic("file not open!\n");
+    const uint64_t pos = (uint64_t)offset * SectorSize;
+    std::streamoff bytes = (uint64_t)count * SectorSize;
 
-    stream.seekg(offset * SectorSize, ios::beg);
-    if (!stream.good())
-        panic("Could not seek to location in file");
+    if (mapping) {
+        bytes = pos < mappingBytes ?
+            std::min<uint64_t>(bytes, mappingBytes - pos) : 0;
+        memcpy(data, mapping + pos, bytes);
+    } else {
+        if (!stream.is_open())
+            panic("file not open!\n");
 
-    streampos pos = stream.tellg();
-    stream.read((char *)data, SectorSize);
+        stream.seekg(pos, ios::beg);
+        if (!stream.good())
+            panic("Could not seek to location in file");
 
-    DPRINTF(DiskImageRead, "read: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageRead, data, SectorSize);
+        streampos start = stream.tellg();
+        stream.read((char *)data, bytes);
+        bytes = stream.tellg() - start;
+    }
+
+    DPRINTF(DiskImageRead, "read: offset=%d count=%d\n",
+            (uint64_t)offset, count);
+    DDUMP(DiskImageRead, data, bytes);
 
-    return stream.tellg() - pos;
+    return bytes;
 }
 
 std::streampos
-RawDiskImage::write(const uint8_t *data, std::streampos offset)
+RawDiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                           unsigned count)
 {
     if (!initialized)
         panic("RawDiskImage not initialized");
@@ -140,19 +232,30 @@ RawDiskImage::write(const uint8_t *data, std::streampos offset)
     if (readonly)
         panic("Cannot write to a read only disk image");
 
+    const uint64_t pos = (uint64_t)offset * SectorSize;
+    std::streamoff bytes = (uint64_t)count * SectorSize;
+
+    DPRINTF(DiskImageWrite, "write: offset=%d count=%d\n",
+            (uint64_t)offset, count);
+    DDUMP(DiskImageWrite, data, bytes);
+
+    if (mapping) {
+        bytes = pos < mappingBytes ?
+            std::min<uint64_t>(bytes, mappingBytes - pos) : 0;
+        memcpy(mapping + pos, data, bytes);
+        return bytes;
+    }
+
     if (!stream.is_open())
         panic("file not open!\n");
 
-    stream.seekp(offset * SectorSize, ios::beg);
+    stream.seekp(pos, ios::beg);
     if (!stream.good())
         panic("Could not seek to location in file");
 
-    DPRINTF(DiskImageWrite, "write: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageWrite, data, SectorSize);
-
-    streampos pos = stream.tellp();
-    stream.write((const char *)data, SectorSize);
-    return stream.tellp() - pos;
+    streampos start = stream.tellp();
+    stream.write((const char *)data, bytes);
+    return stream.tellp() - start;
 }
 
 RawDiskImage *
@@ -165,19 +268,42 @@ RawDiskImageParams::create()
 //
 // Copy on Write Disk image
 //
-const uint32_t CowDiskImage::VersionMajor = 1;
+const uint32_t CowDiskImage::VersionMajor = 2;
 const uint32_t CowDiskImage::VersionMinor = 0;
 
+namespace
+{
+
+void
+writeAll(int fd, const uint8_t *data, size_t bytes, off_t offset,
+         const string &file)
+{
+    while (bytes) {
+        ssize_t done = pwrite(fd, data, bytes, offset);
+        if (done < 0 && errno == EINTR)
+            continue;
+        if (done <= 0)
+            panic("Error writing %s: %s", file, strerror(errno));
+        data += done;
+        bytes -= done;
+        offset += done;
+    }
+}
+
+} // anonymous namespace
+
 CowDiskImage::CowDiskImage(const Params *p)
-    : DiskImage(p), filename(p->image_file), child(p->child), table(NULL)
+    : DiskImage(p), filename(p->image_file), child(p->child),
+      numSectors(child->size()), overlay(nullptr), overlayBytes(0),
+      bitmap(nullptr), sectors(nullptr), sharedOverlay(false), allocated(0)
 {
     if (filename.empty()) {
         initSectorTable(p->table_size);
     } else {
-        if (!open(filename)) {
+        if (!open(filename, !p->read_only)) {
             if (p->read_only)
                 fatal("could not open read-only file");
-            initSectorTable(p->table_size);
+            create(filename);
         }
 
         if (!p->read_only)
@@ -187,13 +313,7 @@ CowDiskImage::CowDiskImage(const Params *p)
 
 CowDiskImage::~CowDiskImage()
 {
-    SectorTable::iterator i = table->begin();
-    SectorTable::iterator end = table->end();
-
-    while (i != end) {
-        delete (*i).second;
-        ++i;
-    }
+    unmapOverlay();
 }
 
 void
@@ -204,6 +324,136 @@ CowDiskImage::notifyFork()
         inform("Disabling saving of COW image in forked child process.\n");
         filename = "";
     }
+
+    if (sharedOverlay) {
+        // The parent keeps writing to the shared file, so give the child
+        // a private copy of the sectors present so far.
+        uint8_t *old_overlay = overlay;
+        size_t old_bytes = overlayBytes;
+        uint8_t *old_sectors = sectors;
+
+        overlay = nullptr;
+        mapOverlay("", false);
+        memcpy(bitmap, old_overlay + HeaderBytes, bitmapBytes());
+        forEachRun([&](uint64_t sector, uint64_t count) {
+            memcpy(sectors + sector * SectorSize,
+                   old_sectors + sector * SectorSize, count * SectorSize);
+        });
+        munmap(old_overlay, old_bytes);
+    }
+}
+
+size_t
+CowDiskImage::bitmapBytes() const
+{
+    return roundUp(divCeil(numSectors, 8), (uint64_t)HeaderBytes);
+}
+
+size_t
+CowDiskImage::overlaySize() const
+{
+    return HeaderBytes + bitmapBytes() + numSectors * SectorSize;
+}
+
+template <typename F>
+void
+CowDiskImage::forEachRun(F f) const
+{
+    uint64_t sector = 0;
+    while (sector < numSectors) {
+        if (sector % 8 == 0 && !bitmap[sector / 8]) {
+            sector += 8;
+            continue;
+        }
+        if (!isAllocated(sector)) {
+            sector++;
+            continue;
+        }
+
+        uint64_t end = sector + 1;
+        while (end < numSectors && isAllocated(end))
+            end++;
+        f(sector, end - sector);
+        sector = end;
+    }
+}
+
+void
+CowDiskImage::mapOverlay(const string &file, bool shared)
+{
+    unmapOverlay();
+    overlayBytes = overlaySize();
+
+    // The overlay is as large as the disk, but only the sectors that are
+    // written are ever backed by memory or by blocks of the file.
+    void *addr;
+    if (file.empty()) {
+        addr = mmap(NULL, overlayBytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    } else {
+        int fd = ::open(file.c_str(), shared ? O_RDWR : O_RDONLY);
+        if (fd < 0)
+            panic("Error opening %s", file);
+        addr = mmap(NULL, overlayBytes, PROT_READ | PROT_WRITE,
+                    (shared ? MAP_SHARED : MAP_PRIVATE) | MAP_NORESERVE,
+                    fd, 0);
+        ::close(fd);
+    }
+
+    if (addr == MAP_FAILED)
+        panic("Could not map the COW overlay of %s: %s", name(),
+              strerror(errno));
+
+    overlay = (uint8_t *)addr;
+    bitmap = overlay + HeaderBytes;
+    sectors = bitmap + bitmapBytes();
+    sharedOverlay = shared;
+
+    if (file.empty()) {
+        writeHeader();
+        allocated = 0;
+    }
+}
+
+void
+CowDiskImage::unmapOverlay()
+{
+    if (overlay) {
+        munmap(overlay, overlayBytes);
+        overlay = nullptr;
+        bitmap = nullptr;
+        sectors = nullptr;
+    }
+}
+
+void
+CowDiskImage::writeHeader()
+{
+    memcpy(overlay, "COWDISK!", 8);
+
+    uint32_t major = htole(VersionMajor);
+    uint32_t minor = htole(VersionMinor);
+    uint64_t sector_count = htole(numSectors);
+    memcpy(overlay + 8, &major, sizeof(major));
+    memcpy(overlay + 12, &minor, sizeof(minor));
+    memcpy(overlay + 16, &sector_count, sizeof(sector_count));
+}
+
+void
+CowDiskImage::create(const string &file)
+{
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        panic("Error creating %s", file);
+    if (ftruncate(fd, overlaySize()) != 0)
+        panic("Error creating %s: %s", file, strerror(errno));
+    ::close(fd);
+
+    mapOverlay(file, true);
+    writeHeader();
+    allocated = 0;
+
+    initialized = true;
 }
 
 void
@@ -236,7 +486,7 @@ SafeReadSwap(ifstream &stream, T &data)
 }
 
 bool
-CowDiskImage::open(const string &file)
+CowDiskImage::open(const string &file, bool shared)
 {
     ifstream stream(file.c_str());
     if (!stream.is_open())
@@ -255,36 +505,66 @@ CowDiskImage::open(const string &file)
     SafeReadSwap(stream, major);
     SafeReadSwap(stream, minor);
 
-    if (major != VersionMajor && minor != VersionMinor)
+    if (major == 1) {
+        loadV1(stream, file);
+        initialized = true;
+        return true;
+    }
+
+    if (major != VersionMajor)
         panic("Could not open %s: invalid version %d.%d != %d.%d",
               file, major, minor, VersionMajor, VersionMinor);
 
     uint64_t sector_count;
     SafeReadSwap(stream, sector_count);
-    table = new SectorTable(sector_count);
+    stream.close();
+
+    if (sector_count != numSectors)
+        panic("Could not open %s: it has %d sectors, the disk has %d",
+              file, sector_count, numSectors);
+
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0 || (size_t)st.st_size != overlaySize())
+        panic("Could not open %s: truncated file", file);
+
+    mapOverlay(file, shared);
+    allocated = 0;
+    for (size_t i = 0; i < bitmapBytes(); i++)
+        allocated += popCount(bitmap[i]);
+
+    initialized = true;
+    return true;
+}
 
+void
+CowDiskImage::loadV1(ifstream &stream, const string &file)
+{
+    mapOverlay("", false);
+
+    uint64_t sector_count;
+    SafeReadSwap(stream, sector_count);
 
     for (uint64_t i = 0; i < sector_count; i++) {
         uint64_t offset;
         SafeReadSwap(stream, offset);
 
-        Sector *sector = new Sector;
-        SafeRead(stream, sector, sizeof(Sector));
+        if (offset >= numSectors)
+            panic("Could not open %s: sector %d is out of range", file,
+                  offset);
+        assert(!isAllocated(offset));
 
-        assert(table->find(offset) == table->end());
-        (*table)[offset] = sector;
+        SafeRead(stream, sectors + offset * SectorSize, SectorSize);
+        bitmap[offset / 8] |= 1 << (offset % 8);
+        allocated++;
     }
 
     stream.close();
-
-    initialized = true;
-    return true;
 }
 
 void
 CowDiskImage::initSectorTable(int hash_size)
 {
-    table = new SectorTable(hash_size);
+    mapOverlay("", false);
 
     initialized = true;
 }
@@ -333,44 +613,42 @@ CowDiskImage::save(const string &file) const
     if (!initialized)
         panic("RawDiskImage not initialized");
 
-    ofstream stream(file.c_str());
-    if (!stream.is_open() || stream.fail() || stream.bad())
-        panic("Error opening %s", file);
-
-    uint64_t magic;
-    memcpy(&magic, "COWDISK!", sizeof(magic));
-    SafeWrite(stream, magic);
-
-    SafeWriteSwap(stream, (uint32_t)VersionMajor);
-    SafeWriteSwap(stream, (uint32_t)VersionMinor);
-    SafeWriteSwap(stream, (uint64_t)table->size());
-
-    uint64_t size = table->size();
-    SectorTable::iterator iter = table->begin();
-    SectorTable::iterator end = table->end();
-
-    for (uint64_t i = 0; i < size; i++) {
-        if (iter == end)
-            panic("Incorrect Table Size during save of COW disk image");
-
-        SafeWriteSwap(stream, (uint64_t)(*iter).first);
-        SafeWrite(stream, (*iter).second->data, sizeof(Sector));
-        ++iter;
+    // The overlay already is this file, it only has to be synced.
+    if (sharedOverlay && file == filename) {
+        if (msync(overlay, overlayBytes, MS_SYNC) != 0)
+            panic("Error syncing %s: %s", file, strerror(errno));
+        return;
     }
 
-    stream.close();
+    // Write a sparse copy holding only the sectors that are present. It
+    // goes to a temporary file that is renamed into place, so a file
+    // that is mapped (e.g. the one this image was restored from) is not
+    // truncated under its mapping.
+    const string tmp = file + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        panic("Error opening %s", tmp);
+    if (ftruncate(fd, overlayBytes) != 0)
+        panic("Error writing %s: %s", tmp, strerror(errno));
+
+    writeAll(fd, overlay, HeaderBytes + bitmapBytes(), 0, tmp);
+    const off_t data_offset = HeaderBytes + bitmapBytes();
+    forEachRun([&](uint64_t sector, uint64_t count) {
+        writeAll(fd, sectors + sector * SectorSize, count * SectorSize,
+                 data_offset + sector * SectorSize, tmp);
+    });
+
+    ::close(fd);
+    if (rename(tmp.c_str(), file.c_str()) != 0)
+        panic("Error renaming %s to %s: %s", tmp, file, strerror(errno));
 }
 
 void
 CowDiskImage::writeback()
 {
-    SectorTable::iterator i = table->begin();
-    SectorTable::iterator end = table->end();
-
-    while (i != end) {
-        child->write((*i).second->data, (*i).first);
-        ++i;
-    }
+    forEachRun([&](uint64_t sector, uint64_t count) {
+        child->writeSectors(sectors + sector * SectorSize, sector, count);
+    });
 }
 
 std::streampos
@@ -379,46 +657,76 @@ CowDiskImage::size() const
 
 std::streampos
 CowDiskImage::read(uint8_t *data, std::streampos offset) const
+{
+    return readSectors(data, offset, 1);
+}
+
+std::streampos
+CowDiskImage::write(const uint8_t *data, std::streampos offset)
+{
+    return writeSectors(data, offset, 1);
+}
+
+std::streampos
+CowDiskImage::readSectors(uint8_t *data, std::streampos offset,
+                          unsigned count) const
 {
     if (!initialized)
         panic("CowDiskImage not initialized");
 
-    if (offset > size())
+    const uint64_t first = offset;
+    if (first + count > numSectors)
         panic("access out of bounds");
 
-    SectorTable::const_iterator i = table->find(offset);
-    if (i == table->end())
-        return child->read(data, offset);
-    else {
-        memcpy(data, (*i).second->data, SectorSize);
-        DPRINTF(DiskImageRead, "read: offset=%d\n", (uint64_t)offset);
-        DDUMP(DiskImageRead, data, SectorSize);
-        return SectorSize;
+    // Split the request into runs that are all in the overlay, which are
+    // copied out of it, or all in the child, which are passed down.
+    uint64_t done = 0;
+    while (done < count) {
+        const uint64_t sector = first + done;
+        const bool present = isAllocated(sector);
+        uint64_t run = 1;
+        while (done + run < count && isAllocated(sector + run) == present)
+            run++;
+
+        uint8_t *dst = data + done * SectorSize;
+        if (present) {
+            memcpy(dst, sectors + sector * SectorSize, run * SectorSize);
+        } else {
+            std::streamoff bytes = child->readSectors(dst, sector, run);
+            if (bytes != (std::streamoff)(run * SectorSize))
+                return done * SectorSize + bytes;
+        }
+        done += run;
     }
+
+    DPRINTF(DiskImageRead, "read: offset=%d count=%d\n", first, count);
+    DDUMP(DiskImageRead, data, count * SectorSize);
+    return count * SectorSize;
 }
 
 std::streampos
-CowDiskImage::write(const uint8_t *data, std::streampos offset)
+CowDiskImage::writeSectors(const uint8_t *data, std::streampos offset,
+                           unsigned count)
 {
     if (!initialized)
-        panic("RawDiskImage not initialized");
+        panic("CowDiskImage not initialized");
 
-    if (offset > size())
+    const uint64_t first = offset;
+    if (first + count > numSectors)
         panic("access out of bounds");
 
-    SectorTable::iterator i = table->find(offset);
-    if (i == table->end()) {
-        Sector *sector = new Sector;
-        memcpy(sector, data, SectorSize);
-        table->insert(make_pair(offset, sector));
-    } else {
-        memcpy((*i).second->data, data, SectorSize);
+    memcpy(sectors + first * SectorSize, data, count * SectorSize);
+    for (uint64_t sector = first; sector < first + count; sector++) {
+        if (!isAllocated(sector)) {
+            bitmap[sector / 8] |= 1 << (sector % 8);
+            allocated++;
+        }
     }
 
-    DPRINTF(DiskImageWrite, "write: offset=%d\n", (uint64_t)offset);
-    DDUMP(DiskImageWrite, data, SectorSize);
+    DPRINTF(DiskImageWrite, "write: offset=%d count=%d\n", first, count);
+    DDUMP(DiskImageWrite, data, count * SectorSize);
 
-    return SectorSize;
+    return count * SectorSize;
 }
 
 void
@@ -34,7 +34,7 @@
 #define __DEV_STORAGE_DISK_IMAGE_HH__
 
 #include <fstream>
-#include <unordered_map>
+#include <string>
 
 #include "params/CowDiskImage.hh"
 #include "params/DiskImage.hh"
@@ -62,10 +62,34 @@ class DiskImage : public SimObject
                                 std::streampos offset) const = 0;
     virtual std::streampos write(const uint8_t *data,
                                  std::streampos offset) = 0;
+
+    /**
+     * Read a run of consecutive sectors. Images that can move several
+     * sectors at once override this; the default goes through read()
+     * one sector at a time.
+     *
+     * @param data Buffer of at least count sectors.
+     * @param offset First sector to read.
+     * @param count Number of sectors.
+     * @return The number of bytes read, short if the run failed part way.
+     */
+    virtual std::streampos readSectors(uint8_t *data, std::streampos offset,
+                                       unsigned count) const;
+
+    /**
+     * Write a run of consecutive sectors.
+     * @sa readSectors()
+     */
+    virtual std::streampos writeSectors(const uint8_t *data,
+                                        std::streampos offset,
+                                        unsigned count);
 };
 
 /**
- * Specialization for accessing a raw disk image
+ * Specialization for accessing a raw disk image. Regular files are mapped
+ * into the simulator's address space, so sectors are moved with a memcpy
+ * and writes go to the file through the page cache. Anything that cannot
+ * be mapped is accessed through a stream.
  */
 class RawDiskImage : public DiskImage
 {
@@ -75,6 +99,10 @@ class RawDiskImage : public DiskImage
     bool readonly;
     mutable std::streampos disk_size;
 
+    /// The mapped image, or nullptr when going through the stream
+    uint8_t *mapping;
+    size_t mappingBytes;
+
   public:
     typedef RawDiskImageParams Params;
     RawDiskImage(const Params *p);
@@ -89,6 +117,11 @@ class RawDiskImage : public DiskImage
 
     std::streampos read(uint8_t *data, std::streampos offset) const override;
     std::streampos write(const uint8_t *data, std::streampos offset) override;
+
+    std::streampos readSectors(uint8_t *data, std::streampos offset,
+                               unsigned count) const override;
+    std::streampos writeSectors(const uint8_t *data, std::streampos offset,
+                                unsigned count) override;
 };
 
 /**
@@ -108,15 +141,64 @@ class CowDiskImage : public DiskImage
     static const uint32_t VersionMinor;
 
   protected:
-    struct Sector {
-        uint8_t data[SectorSize];
-    };
-    typedef std::unordered_map<uint64_t, Sector *> SectorTable;
+    /**
+     * The overlay is laid out as in a version 2 COW file: a header page,
+     * a bitmap of the sectors present in the overlay, then every sector
+     * of the disk at its own offset. Only the sectors that were written
+     * take up space, in memory and in the file, which is sparse.
+     *
+     * The overlay is an anonymous mapping, or a mapping of a COW file.
+     * When the image file is writable the mapping is shared, so writes
+     * reach it as they happen and saving it only has to sync. Restoring
+     * from a checkpoint maps the checkpointed file privately rather than
+     * reading it in.
+     */
+    static const uint64_t HeaderBytes = 4096;
 
-  protected:
     std::string filename;
     DiskImage *child;
-    SectorTable *table;
+
+    /// Number of sectors in the disk
+    uint64_t numSectors;
+
+    uint8_t *overlay;
+    size_t overlayBytes;
+    uint8_t *bitmap;
+    uint8_t *sectors;
+
+    /// Whether the overlay is mapped shared from filename
+    bool sharedOverlay;
+
+    /// Number of sectors present in the overlay
+    uint64_t allocated;
+
+    bool
+    isAllocated(uint64_t sector) const
+    {
+        return bitmap[sector / 8] & (1 << (sector % 8));
+    }
+
+    size_t bitmapBytes() const;
+    size_t overlaySize() const;
+
+    /// Call a function on each run of sectors present in the overlay
+    template <typename F>
+    void forEachRun(F f) const;
+
+    void writeHeader();
+
+    /**
+     * Map the overlay. An empty file name maps anonymous memory,
+     * otherwise the file must already have the right size.
+     */
+    void mapOverlay(const std::string &file, bool shared);
+    void unmapOverlay();
+
+    /// Create an empty version 2 COW file and map it shared
+    void create(const std::string &file);
+
+    /// Read a version 1 COW file into an anonymous overlay
+    void loadV1(std::ifstream &stream, const std::string &file);
 
   public:
     typedef CowDiskImageParams Params;
@@ -126,7 +208,14 @@ class CowDiskImage : public DiskImage
     void notifyFork() override;
 
     void initSectorTable(int hash_size);
-    bool open(const std::string &file);
+
+    /**
+     * Open a COW file.
+     * @param shared Map a version 2 file shared, so that writes update
+     *               it in place.
+     * @return False if the file does not exist.
+     */
+    bool open(const std::string &file, bool shared=false);
     void save() const;
     void save(const std::string &file) const;
     void writeback();
@@ -138,6 +227,11 @@ class CowDiskImage : public DiskImage
 
     std::streampos read(uint8_t *data, std::streampos offset) const override;
     std::streampos write(const uint8_t *data, std::streampos offset) override;
+
+    std::streampos readSectors(uint8_t *data, std::streampos offset,
+                               unsigned count) const override;
+    std::streampos writeSectors(const uint8_t *data, std::streampos offset,
+                                unsigned count) override;
 };
 
 void SafeRead(std::ifstream &stream, void *data, int count);
@@ -461,15 +461,11 @@ IdeDisk::doDmaRead()
 void
 IdeDisk::dmaReadDone()
 {
-    uint32_t bytesWritten = 0;
-
     // write the data to the disk image
-    for (bytesWritten = 0; bytesWritten < curPrd.getByteCount();
-         bytesWritten += SectorSize) {
-
-        cmdBytesLeft -= SectorSize;
-        writeDisk(curSector++, (uint8_t *)(dataBuffer + bytesWritten));
-    }
+    uint32_t sectors = divCeil(curPrd.getByteCount(), SectorSize);
+    writeDisk(curSector, dataBuffer, sectors);
+    curSector += sectors;
+    cmdBytesLeft -= sectors * SectorSize;
 
     // check for the EOT
     if (curPrd.getEOT()) {
@@ -486,18 +482,17 @@ IdeDisk::doDmaDataWrite()
 {
     /** @todo we need to figure out what the delay actually will be */
     Tick totalDiskDelay = diskDelay + (curPrd.getByteCount() / SectorSize);
-    uint32_t bytesRead = 0;
 
     DPRINTF(IdeDisk, "doDmaWrite, diskDelay: %d totalDiskDelay: %d\n",
             diskDelay, totalDiskDelay);
 
     memset(dataBuffer, 0, MAX_DMA_SIZE);
     assert(cmdBytesLeft <= MAX_DMA_SIZE);
-    while (bytesRead < curPrd.getByteCount()) {
-        readDisk(curSector++, (uint8_t *)(dataBuffer + bytesRead));
-        bytesRead += SectorSize;
-        cmdBytesLeft -= SectorSize;
-    }
+    uint32_t sectors = divCeil(curPrd.getByteCount(), SectorSize);
+    readDisk(curSector, dataBuffer, sectors);
+    curSector += sectors;
+    cmdBytesLeft -= sectors * SectorSize;
+    uint32_t bytesRead = sectors * SectorSize;
     DPRINTF(IdeDisk, "doDmaWrite, bytesRead: %d cmdBytesLeft: %d\n",
             bytesRead, cmdBytesLeft);
 
@@ -565,23 +560,23 @@ IdeDisk::dmaWriteDone()
 ///
 
 void
-IdeDisk::readDisk(uint32_t sector, uint8_t *data)
+IdeDisk::readDisk(uint32_t sector, uint8_t *data, unsigned count)
 {
-    uint32_t bytesRead = image->read(data, sector);
+    uint32_t bytesRead = image->readSectors(data, sector, count);
 
-    if (bytesRead != SectorSize)
+    if (bytesRead != count * SectorSize)
         panic("Can't read from %s. Only %d of %d read. errno=%d\n",
-              name(), bytesRead, SectorSize, errno);
+              name(), bytesRead, count * SectorSize, errno);
 }
 
 void
-IdeDisk::writeDisk(uint32_t sector, uint8_t *data)
+IdeDisk::writeDisk(uint32_t sector, uint8_t *data, unsigned count)
 {
-    uint32_t bytesWritten = image->write(data, sector);
+    uint32_t bytesWritten = image->writeSectors(data, sector, count);
 
-    if (bytesWritten != SectorSize)
+    if (bytesWritten != count * SectorSize)
         panic("Can't write to %s. Only %d of %d written. errno=%d\n",
-              name(), bytesWritten, SectorSize, errno);
+              name(), bytesWritten, count * SectorSize, errno);
 }
 
 ////
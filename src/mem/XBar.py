@@ -140,6 +140,10 @@ class SnoopFilter(SimObject):
     # Sanity check on max capacity to track, adjust if needed.
     max_capacity = Param.MemorySize('8MB', "Maximum capacity of snoop filter")
 
+    # The tracked lines are kept in a set-associative table covering
+    # max_capacity
+    assoc = Param.Unsigned(16, "Associativity of the snoop filter")
+
 # We use a coherent crossbar to connect multiple requestors to the L2
 # caches. Normally this crossbar would be part of the cache itself.
 class L2XBar(CoherentXBar):
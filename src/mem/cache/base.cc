@@ -616,6 +616,62 @@ BaseCache::recvAtomic(PacketPtr pkt)
     return lat * clockPeriod();
 }
 
+bool
+BaseCache::tryAtomicHit(PacketPtr pkt, Tick &latency)
+{
+    // Only plain loads and stores qualify, and only if they do not need
+    // any of the special handling of the full access path (e.g. locked
+    // accesses, uncacheable accesses, or whole-line writes that could
+    // be promoted)
+    if (system->bypassCaches() ||
+        !(pkt->cmd == MemCmd::ReadReq || pkt->cmd == MemCmd::WriteReq) ||
+        pkt->req->isUncacheable() ||
+        (pkt->isWrite() && pkt->getSize() == blkSize)) {
+        return false;
+    }
+
+    // Check that the access hits before touching the replacement state,
+    // so that it is not updated twice if the full path has to be taken
+    CacheBlk *blk = tags->findBlock(pkt->getAddr(), pkt->isSecure());
+    if (!blk || !(pkt->isWrite() ? blk->isWritable() : blk->isReadable())) {
+        return false;
+    }
+
+    Cycles tag_latency(0);
+    tags->accessBlock(pkt->getAddr(), pkt->isSecure(), tag_latency);
+
+    DPRINTF(Cache, "%s for %s hit %s\n", __func__, pkt->print(),
+            blk->print());
+
+    incHitCount(pkt);
+
+    Cycles lat;
+    if (pkt->isRead()) {
+        lat = calculateAccessLatency(blk, pkt->headerDelay, tag_latency);
+        if (compressor) {
+            lat += compressor->getDecompressionLatency(blk);
+        }
+    } else {
+        lat = calculateTagOnlyLatency(pkt->headerDelay, tag_latency);
+    }
+
+    satisfyRequest(pkt, blk);
+    pkt->makeAtomicResponse();
+
+    latency = lat * clockPeriod();
+    return true;
+}
+
+BaseCache *
+BaseCache::getConnectedCache(Port &port)
+{
+    if (!port.isConnected())
+        return nullptr;
+
+    auto *cpu_side_port = dynamic_cast<CpuSidePort *>(&port.getPeer());
+    return cpu_side_port ? cpu_side_port->getCache() : nullptr;
+}
+
 void
 BaseCache::functionalAccess(PacketPtr pkt, bool from_cpu_side)
 {
@@ -303,6 +303,8 @@ class BaseCache : public ClockedObject
         CpuSidePort(const std::string &_name, BaseCache *_cache,
                     const std::string &_label);
 
+        /** Get the cache this port belongs to. */
+        BaseCache *getCache() const { return cache; }
     };
 
     CpuSidePort cpuSidePort;
@@ -1217,6 +1219,31 @@ class BaseCache : public ClockedObject
         return mshrQueue.findMatch(addr, is_secure);
     }
 
+    /**
+     * Fast path for atomic accesses from a requestor directly attached
+     * to this cache. A plain load or store that hits on a block with
+     * the required permissions is satisfied right away, with the same
+     * effect on the tags, the replacement state, the data and the stats
+     * as recvAtomic, but without walking the full access path. Any
+     * other access is left untouched, and must be sent through the port
+     * as usual.
+     *
+     * @param pkt The request to perform.
+     * @param latency Set to the number of ticks required for the access
+     *                if the access was satisfied.
+     * @return Whether the access was satisfied.
+     */
+    bool tryAtomicHit(PacketPtr pkt, Tick &latency);
+
+    /**
+     * Get the cache whose CPU-side port is connected to a port.
+     *
+     * @param port Port of a requestor.
+     * @return The cache, or nullptr if the port is not directly
+     *         connected to a cache.
+     */
+    static BaseCache *getConnectedCache(Port &port);
+
     void incMissCount(PacketPtr pkt)
     {
         assert(pkt->req->requestorId() < system->maxRequestors());
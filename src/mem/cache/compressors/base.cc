@@ -95,8 +95,15 @@ Base::toChunks(const uint64_t* data) const
 
     // Turn a 64-bit array into a chunkSizeBits-array
     std::vector<Chunk> chunks((blkSize * CHAR_BIT) / chunkSizeBits, 0);
+
+    // Qword chunks are a plain copy of the data
+    if (num_chunks_per_64 == 1) {
+        std::copy(data, data + chunks.size(), chunks.begin());
+        return chunks;
+    }
+
     for (int i = 0; i < chunks.size(); i++) {
-        const int index_64 = std::floor(i / (double)num_chunks_per_64);
+        const int index_64 = i / num_chunks_per_64;
         const unsigned start = i % num_chunks_per_64;
         chunks[i] = bits(data[index_64],
             (start + 1) * chunkSizeBits - 1, start * chunkSizeBits);
@@ -113,9 +120,14 @@ Base::fromChunks(const std::vector<Chunk>& chunks, uint64_t* data) const
         (sizeof(uint64_t) * CHAR_BIT) / chunkSizeBits;
 
     // Turn a chunkSizeBits-array into a 64-bit array
+    if (num_chunks_per_64 == 1) {
+        std::copy(chunks.begin(), chunks.end(), data);
+        return;
+    }
+
     std::memset(data, 0, blkSize);
     for (int i = 0; i < chunks.size(); i++) {
-        const int index_64 = std::floor(i / (double)num_chunks_per_64);
+        const int index_64 = i / num_chunks_per_64;
         const unsigned start = i % num_chunks_per_64;
         replaceBits(data[index_64], (start + 1) * chunkSizeBits - 1,
             start * chunkSizeBits, chunks[i]);
@@ -101,6 +101,14 @@ class BaseDelta : public DictionaryCompressor<BaseType>
         return PatternFactory::getPattern(bytes, dict_bytes, match_location);
     }
 
+    std::unique_ptr<typename DictionaryCompressor<BaseType>::Pattern>
+    getBestPattern(const DictionaryEntry& bytes) const override
+    {
+        return PatternFactory::getBestPattern(bytes,
+            DictionaryCompressor<BaseType>::dictionary,
+            DictionaryCompressor<BaseType>::numEntries);
+    }
+
     std::string
     getName(int number) const override
     {
@@ -96,6 +96,12 @@ class CPack : public DictionaryCompressor<uint32_t>
         return PatternFactory::getPattern(bytes, dict_bytes, match_location);
     }
 
+    std::unique_ptr<Pattern>
+    getBestPattern(const DictionaryEntry& bytes) const override
+    {
+        return PatternFactory::getBestPattern(bytes, dictionary, numEntries);
+    }
+
     void addToDictionary(DictionaryEntry data) override;
 
     std::unique_ptr<Base::CompressionData> compress(
@@ -44,6 +44,7 @@
 #define __MEM_CACHE_COMPRESSORS_DICTIONARY_COMPRESSOR_HH__
 
 #include <array>
+#include <cassert>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -139,10 +140,19 @@ class DictionaryCompressor : public BaseDictionaryCompressor
      * Create a factory to determine if input matches a pattern. The if else
      * chains are constructed by recursion. The patterns should be explored
      * sorted by size for correct behaviour.
+     *
+     * Besides instantiating patterns, the factory can also search for the
+     * best pattern of a value against a whole dictionary without allocating
+     * any intermediate pattern. This requires every pattern type to have a
+     * fixed size, which is true for all patterns derived from the ones
+     * declared in this file.
      */
     template <class Head, class... Tail>
     struct Factory
     {
+        /** Number of patterns handled by this factory. */
+        static constexpr int numPatterns = 1 + sizeof...(Tail);
+
         static std::unique_ptr<Pattern> getPattern(
             const DictionaryEntry& bytes, const DictionaryEntry& dict_bytes,
             const int match_location)
@@ -160,6 +170,107 @@ class DictionaryCompressor : public BaseDictionaryCompressor
                                                     match_location);
             }
         }
+
+        /**
+         * Same as getPattern(), but returns the position of the matching
+         * pattern in the factory's list instead of instantiating it.
+         *
+         * @param bytes The bytes being compressed.
+         * @param dict_bytes The bytes of the dictionary entry.
+         * @param match_location The index of the dictionary entry.
+         * @return The index of the first matching pattern.
+         */
+        static int
+        getPatternIndex(const DictionaryEntry& bytes,
+            const DictionaryEntry& dict_bytes, const int match_location)
+        {
+            if (Head::isPattern(bytes, dict_bytes, match_location)) {
+                return 0;
+            } else {
+                return 1 + Factory<Tail...>::getPatternIndex(bytes,
+                    dict_bytes, match_location);
+            }
+        }
+
+        /**
+         * Instantiate the pattern at the given position of the factory's
+         * list.
+         *
+         * @param index The index of the pattern, as given by
+         *              getPatternIndex().
+         * @param bytes The bytes being compressed.
+         * @param match_location The index of the dictionary entry.
+         * @return The new pattern.
+         */
+        static std::unique_ptr<Pattern>
+        instantiate(const int index, const DictionaryEntry& bytes,
+            const int match_location)
+        {
+            if (index == 0) {
+                return std::unique_ptr<Pattern>(
+                            new Head(bytes, match_location));
+            } else {
+                return Factory<Tail...>::instantiate(index - 1, bytes,
+                                                     match_location);
+            }
+        }
+
+        /**
+         * Get the size, in bits, of the pattern at the given position of
+         * the factory's list. The sizes are calculated only once.
+         *
+         * @param index The index of the pattern.
+         * @return The size of the pattern.
+         */
+        static std::size_t
+        getSizeBits(const int index)
+        {
+            static const std::array<std::size_t, numPatterns> sizes = {{
+                Head(DictionaryEntry(), -1).getSizeBits(),
+                Tail(DictionaryEntry(), -1).getSizeBits()...
+            }};
+            return sizes[index];
+        }
+
+        /**
+         * Search the dictionary for the pattern that best compresses the
+         * given value. This produces exactly the same pattern as creating
+         * a pattern for the no-match case and for every dictionary entry,
+         * and keeping the first smallest one, but only the chosen pattern
+         * is instantiated. The search stops as soon as a pattern of the
+         * minimum possible size is found.
+         *
+         * @param bytes The bytes being compressed.
+         * @param dictionary The dictionary.
+         * @param num_entries The number of valid dictionary entries.
+         * @return The best pattern.
+         */
+        static std::unique_ptr<Pattern>
+        getBestPattern(const DictionaryEntry& bytes,
+            const std::vector<DictionaryEntry>& dictionary,
+            const std::size_t num_entries)
+        {
+            // Start as a no-match pattern, as in compressValue()
+            int best_index = getPatternIndex(bytes,
+                DictionaryCompressor<T>::toDictionaryEntry(0), -1);
+            int best_location = -1;
+            std::size_t best_size = getSizeBits(best_index);
+
+            // The smallest pattern is always the first one
+            const std::size_t min_size = getSizeBits(0);
+            for (std::size_t i = 0;
+                 (i < num_entries) && (best_size > min_size); i++) {
+                const int index = getPatternIndex(bytes, dictionary[i], i);
+                const std::size_t size = getSizeBits(index);
+                if (size < best_size) {
+                    best_index = index;
+                    best_location = i;
+                    best_size = size;
+                }
+            }
+
+            return instantiate(best_index, bytes, best_location);
+        }
     };
 
     /**
@@ -175,12 +286,29 @@ class DictionaryCompressor : public BaseDictionaryCompressor
             "The last pattern must always be derived from the uncompressed "
             "pattern.");
 
+        static constexpr int numPatterns = 1;
+
         static std::unique_ptr<Pattern>
         getPattern(const DictionaryEntry& bytes,
             const DictionaryEntry& dict_bytes, const int match_location)
         {
             return std::unique_ptr<Pattern>(new Head(bytes, match_location));
         }
+
+        static int
+        getPatternIndex(const DictionaryEntry& bytes,
+            const DictionaryEntry& dict_bytes, const int match_location)
+        {
+            return 0;
+        }
+
+        static std::unique_ptr<Pattern>
+        instantiate(const int index, const DictionaryEntry& bytes,
+            const int match_location)
+        {
+            assert(index == 0);
+            return std::unique_ptr<Pattern>(new Head(bytes, match_location));
+        }
     };
 
     /** The dictionary. */
@@ -195,6 +323,19 @@ class DictionaryCompressor : public BaseDictionaryCompressor
     getPattern(const DictionaryEntry& bytes, const DictionaryEntry& dict_bytes,
         const int match_location) const = 0;
 
+    /**
+     * Find the pattern that best compresses the given value, considering
+     * the no-match case and every valid dictionary entry. The default
+     * implementation instantiates a pattern per dictionary entry through
+     * getPattern(); sub-classes should override it to use their factory's
+     * getBestPattern(), which does not allocate while searching.
+     *
+     * @param bytes The value to be compressed.
+     * @return The smallest pattern found.
+     */
+    virtual std::unique_ptr<Pattern>
+    getBestPattern(const DictionaryEntry& bytes) const;
+
     /**
      * Compress data.
      *
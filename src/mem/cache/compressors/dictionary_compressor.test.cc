@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "base/types.hh"
+#include "mem/cache/compressors/base_delta.hh"
+#include "mem/cache/compressors/cpack.hh"
+#include "mem/cache/compressors/dictionary_compressor_impl.hh"
+#include "mem/cache/compressors/fpcd.hh"
+#include "mem/cache/compressors/repeated_qwords.hh"
+#include "mem/cache/compressors/zero.hh"
+#include "params/Base16Delta8.hh"
+#include "params/Base32Delta16.hh"
+#include "params/Base32Delta8.hh"
+#include "params/Base64Delta16.hh"
+#include "params/Base64Delta32.hh"
+#include "params/Base64Delta8.hh"
+#include "params/CPack.hh"
+#include "params/FPCD.hh"
+#include "params/RepeatedQwordsCompressor.hh"
+#include "params/ZeroCompressor.hh"
+
+using namespace Compressor;
+
+/** Size of the cache lines used in the tests, in bytes. */
+static const int blkSize = 64;
+
+/** Number of 64-bit words in a cache line. */
+static const int blkWords = blkSize / sizeof(uint64_t);
+
+/** A real compressor whose decompression is accessible to the tests. */
+template <class C>
+class TestCompressor : public C
+{
+  public:
+    using C::C;
+    using C::decompress;
+};
+
+/**
+ * The same compressor, but searching its dictionary through the default,
+ * allocation-based, DictionaryCompressor::getBestPattern(). This is the
+ * search every dictionary compressor used before their factories could
+ * search the dictionary by themselves, and it serves as reference.
+ */
+template <class C, class T>
+class ReferenceCompressor : public TestCompressor<C>
+{
+  public:
+    using TestCompressor<C>::TestCompressor;
+
+  protected:
+    std::unique_ptr<typename DictionaryCompressor<T>::Pattern>
+    getBestPattern(const typename DictionaryCompressor<T>::DictionaryEntry&
+        bytes) const override
+    {
+        return DictionaryCompressor<T>::getBestPattern(bytes);
+    }
+};
+
+/**
+ * Fill the parameters shared by all dictionary compressors, using the
+ * defaults of Compressors.py for a 64-byte cache line.
+ */
+template <class P>
+static P
+makeParams(const std::string &name, unsigned chunk_size_bits,
+    int dictionary_size = blkSize)
+{
+    P p;
+    p.name = name;
+    p.eventq_index = 0;
+    p.block_size = blkSize;
+    p.chunk_size_bits = chunk_size_bits;
+    p.size_threshold_percentage = 50;
+    p.dictionary_size = dictionary_size;
+    return p;
+}
+
+/**
+ * Generate a cache line resembling real data: zeros, small integers,
+ * pointers into the same region, repeated values, floating point numbers,
+ * text, or random noise, either for the whole line or per word.
+ */
+static void
+randomLine(std::mt19937_64 &rng, uint64_t *line)
+{
+    const uint64_t base = rng() & ~0xFFFFULL;
+    const uint64_t value = rng();
+    const int kind = rng() % 9;
+    for (int i = 0; i < blkWords; i++) {
+        const int word_kind = (kind == 8) ? (rng() % 8) : kind;
+        switch (word_kind) {
+          case 0:
+            line[i] = 0;
+            break;
+          case 1:
+            // Small integers, 32 and 16 bits wide
+            line[i] = (rng() & 0xFF) | ((rng() & 0xFF) << 32);
+            break;
+          case 2:
+            // Pointers into the same region
+            line[i] = base + (rng() & 0xFFF);
+            break;
+          case 3:
+            line[i] = value;
+            break;
+          case 4:
+            {
+                // Single precision floating point numbers
+                const float f[2] = { float(i), float(rng() % 100) / 4 };
+                std::memcpy(&line[i], f, sizeof(line[i]));
+            }
+            break;
+          case 5:
+            // Text
+            line[i] = 0;
+            for (int j = 0; j < 8; j++) {
+                line[i] |= uint64_t('a' + rng() % 26) << (8 * j);
+            }
+            break;
+          case 6:
+            // Values sharing everything but their lower bytes
+            line[i] = (value & ~0xFFULL) | (rng() & 0xFF);
+            break;
+          default:
+            line[i] = rng();
+            break;
+        }
+    }
+}
+
+/**
+ * Compress many cache lines with a compressor and with its reference, and
+ * check that both produce compressed data of the same size, and that the
+ * data decompresses back to the original line.
+ */
+template <class C, class T>
+static void
+checkCompressor(typename C::Params params)
+{
+    TestCompressor<C> compressor(&params);
+    ReferenceCompressor<C, T> reference(&params);
+    compressor.regStats();
+    reference.regStats();
+
+    // The compressors hide the public interface of the base class
+    Base &base_compressor = compressor;
+    Base &base_reference = reference;
+
+    std::mt19937_64 rng(0);
+    for (int n = 0; n < 5000; n++) {
+        uint64_t line[blkWords];
+        randomLine(rng, line);
+
+        Cycles comp_lat, decomp_lat, ref_comp_lat, ref_decomp_lat;
+        const std::unique_ptr<Base::CompressionData> comp_data =
+            base_compressor.compress(line, comp_lat, decomp_lat);
+        const std::unique_ptr<Base::CompressionData> ref_comp_data =
+            base_reference.compress(line, ref_comp_lat, ref_decomp_lat);
+        ASSERT_EQ(comp_data->getSizeBits(), ref_comp_data->getSizeBits())
+            << params.name << " line " << n;
+        ASSERT_EQ(comp_lat, ref_comp_lat);
+        ASSERT_EQ(decomp_lat, ref_decomp_lat);
+
+        uint64_t decomp_line[blkWords];
+        compressor.decompress(comp_data.get(), decomp_line);
+        ASSERT_EQ(0, std::memcmp(line, decomp_line, blkSize))
+            << params.name << " line " << n;
+    }
+}
+
+TEST(DictionaryCompressorTest, CPack)
+{
+    checkCompressor<CPack, uint32_t>(makeParams<CPackParams>("cpack", 32));
+}
+
+TEST(DictionaryCompressorTest, FPCD)
+{
+    checkCompressor<FPCD, uint32_t>(makeParams<FPCDParams>("fpcd", 32, 2));
+}
+
+/** The sub-compressors of BDI. */
+TEST(DictionaryCompressorTest, BaseDelta)
+{
+    checkCompressor<Base64Delta8, uint64_t>(
+        makeParams<Base64Delta8Params>("b64d8", 64));
+    checkCompressor<Base64Delta16, uint64_t>(
+        makeParams<Base64Delta16Params>("b64d16", 64));
+    checkCompressor<Base64Delta32, uint64_t>(
+        makeParams<Base64Delta32Params>("b64d32", 64));
+    checkCompressor<Base32Delta8, uint32_t>(
+        makeParams<Base32Delta8Params>("b32d8", 32));
+    checkCompressor<Base32Delta16, uint32_t>(
+        makeParams<Base32Delta16Params>("b32d16", 32));
+    checkCompressor<Base16Delta8, uint16_t>(
+        makeParams<Base16Delta8Params>("b16d8", 16));
+}
+
+TEST(DictionaryCompressorTest, ZeroAndRepeatedQwords)
+{
+    checkCompressor<Zero, uint64_t>(
+        makeParams<ZeroCompressorParams>("zero", 64));
+    checkCompressor<RepeatedQwords, uint64_t>(
+        makeParams<RepeatedQwordsCompressorParams>("rqw", 64));
+}
@@ -88,11 +88,8 @@ DictionaryCompressor<T>::instantiateDictionaryCompData() const
 
 template <typename T>
 std::unique_ptr<typename DictionaryCompressor<T>::Pattern>
-DictionaryCompressor<T>::compressValue(const T data)
+DictionaryCompressor<T>::getBestPattern(const DictionaryEntry& bytes) const
 {
-    // Split data in bytes
-    const DictionaryEntry bytes = toDictionaryEntry(data);
-
     // Start as a no-match pattern. A negative match location is used so that
     // patterns that depend on the dictionary entry don't match
     std::unique_ptr<Pattern> pattern =
@@ -110,6 +107,19 @@ DictionaryCompressor<T>::compressValue(const T data)
         }
     }
 
+    return pattern;
+}
+
+template <typename T>
+std::unique_ptr<typename DictionaryCompressor<T>::Pattern>
+DictionaryCompressor<T>::compressValue(const T data)
+{
+    // Split data in bytes
+    const DictionaryEntry bytes = toDictionaryEntry(data);
+
+    // Search for the best matching pattern
+    std::unique_ptr<Pattern> pattern = getBestPattern(bytes);
+
     // Update stats
     dictionaryStats.patterns[pattern->getPatternNumber()]++;
 
@@ -133,6 +143,7 @@ DictionaryCompressor<T>::compress(const std::vector<Chunk>& chunks)
 
     // Compress every value sequentially
     CompData* const comp_data_ptr = static_cast<CompData*>(comp_data.get());
+    comp_data_ptr->entries.reserve(chunks.size());
     for (const auto& value : chunks) {
         std::unique_ptr<Pattern> pattern = compressValue(value);
         DPRINTF(CacheComp, "Compressed %016x to %s\n", value,
@@ -175,6 +186,7 @@ DictionaryCompressor<T>::decompress(const CompressionData* comp_data,
 
     // Decompress every entry sequentially
     std::vector<T> decomp_values;
+    decomp_values.reserve(casted_comp_data->entries.size());
     for (const auto& entry : casted_comp_data->entries) {
         const T value = decompressValue(&*entry);
         decomp_values.push_back(value);
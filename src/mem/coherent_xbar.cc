@@ -605,6 +605,10 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID cpu_side_port_id)
     DPRINTF(CoherentXBar, "%s: src %s packet %s\n", __func__,
             src_port->name(), pkt->print());
 
+    // remove the request from the routing table, before forwarding
+    // the packet changes the table and invalidates the lookup
+    routeTo.erase(route_lookup);
+
     // store size and command as they might be modified when
     // forwarding the packet
     unsigned int pkt_size = pkt->hasData() ? pkt->getSize() : 0;
@@ -679,9 +683,6 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID cpu_side_port_id)
         respLayers[dest_port_id]->succeededTiming(packetFinishTime);
     }
 
-    // remove the request from the routing table
-    routeTo.erase(route_lookup);
-
     // stats updates
     transDist[pkt_cmd]++;
     snoops++;
@@ -693,7 +694,7 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID cpu_side_port_id)
 
 void
 CoherentXBar::forwardTiming(PacketPtr pkt, PortID exclude_cpu_side_port_id,
-                           const std::vector<QueuedResponsePort*>& dests)
+                           const SnoopFilter::SnoopList& dests)
 {
     DPRINTF(CoherentXBar, "%s for %s\n", __func__, pkt->print());
 
@@ -924,7 +925,7 @@ CoherentXBar::recvAtomicSnoop(PacketPtr pkt, PortID mem_side_port_id)
 std::pair<MemCmd, Tick>
 CoherentXBar::forwardAtomic(PacketPtr pkt, PortID exclude_cpu_side_port_id,
                            PortID source_mem_side_port_id,
-                           const std::vector<QueuedResponsePort*>& dests)
+                           const SnoopFilter::SnoopList& dests)
 {
     // the packet may be changed on snoops, record the original
     // command to enable us to restore it between snoops so that
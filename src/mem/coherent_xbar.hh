@@ -46,9 +46,7 @@
 #ifndef __MEM_COHERENT_XBAR_HH__
 #define __MEM_COHERENT_XBAR_HH__
 
-#include <unordered_map>
-#include <unordered_set>
-
+#include "base/open_hash_map.hh"
 #include "mem/snoop_filter.hh"
 #include "mem/xbar.hh"
 #include "params/CoherentXBar.hh"
@@ -255,14 +253,14 @@ class CoherentXBar : public BaseXBar
      * responses from so we can determine which snoop responses we
      * generated and which ones were merely forwarded.
      */
-    std::unordered_set<RequestPtr> outstandingSnoop;
+    OpenHashSet<RequestPtr> outstandingSnoop;
 
     /**
      * Store the outstanding cache maintenance that we are expecting
      * snoop responses from so we can determine when we received all
      * snoop responses and if any of the agents satisfied the request.
      */
-    std::unordered_map<PacketId, PacketPtr> outstandingCMO;
+    OpenHashMap<PacketId, PacketPtr> outstandingCMO;
 
     /**
      * Keep a pointer to the system to be allow to querying memory system
@@ -312,7 +310,8 @@ class CoherentXBar : public BaseXBar
     void
     forwardTiming(PacketPtr pkt, PortID exclude_cpu_side_port_id)
     {
-        forwardTiming(pkt, exclude_cpu_side_port_id, snoopPorts);
+        forwardTiming(pkt, exclude_cpu_side_port_id,
+                      SnoopFilter::SnoopList(snoopPorts));
     }
 
     /**
@@ -322,10 +321,10 @@ class CoherentXBar : public BaseXBar
      *
      * @param pkt Packet to forward
      * @param exclude_cpu_side_port_id Id of CPU-side port to exclude
-     * @param dests Vector of destination ports for the forwarded pkt
+     * @param dests List of destination ports for the forwarded pkt
      */
     void forwardTiming(PacketPtr pkt, PortID exclude_cpu_side_port_id,
-                       const std::vector<QueuedResponsePort*>& dests);
+                       const SnoopFilter::SnoopList& dests);
 
     Tick recvAtomicBackdoor(PacketPtr pkt, PortID cpu_side_port_id,
                             MemBackdoorPtr *backdoor=nullptr);
@@ -345,7 +344,7 @@ class CoherentXBar : public BaseXBar
     forwardAtomic(PacketPtr pkt, PortID exclude_cpu_side_port_id)
     {
         return forwardAtomic(pkt, exclude_cpu_side_port_id, InvalidPortID,
-                             snoopPorts);
+                             SnoopFilter::SnoopList(snoopPorts));
     }
 
     /**
@@ -357,14 +356,14 @@ class CoherentXBar : public BaseXBar
      * @param exclude_cpu_side_port_id Id of CPU-side port to exclude
      * @param source_mem_side_port_id Id of the memory-side port for
      * snoops from below
-     * @param dests Vector of destination ports for the forwarded pkt
+     * @param dests List of destination ports for the forwarded pkt
      *
      * @return a pair containing the snoop response and snoop latency
      */
     std::pair<MemCmd, Tick> forwardAtomic(PacketPtr pkt,
                                           PortID exclude_cpu_side_port_id,
                                           PortID source_mem_side_port_id,
-                                          const std::vector<QueuedResponsePort*>&
+                                          const SnoopFilter::SnoopList&
                                           dests);
 
     /** Function called by the port when the crossbar is receiving a Functional
@@ -35,12 +35,130 @@
 
 #include <string>
 
+#include "base/bitfield.hh"
 #include "base/compiler.hh"
 #include "base/trace.hh"
 #include "debug/MMU.hh"
 #include "sim/faults.hh"
 #include "sim/serialize.hh"
 
+namespace
+{
+
+/**
+ * Mask of the bits of a word of a leaf's valid bitmap that are in a
+ * range of page indices.
+ */
+uint64_t
+wordMask(unsigned word, unsigned first, unsigned num)
+{
+    const unsigned lo = std::max(first, word * 64);
+    const unsigned hi = std::min(first + num, word * 64 + 64);
+    return mask(hi - lo) << (lo - word * 64);
+}
+
+} // anonymous namespace
+
+template <typename F>
+void
+EmulationPageTable::forEachLeaf(Addr vaddr, int64_t size, bool create, F f)
+{
+    assert(pageOffset(vaddr) == 0);
+
+    uint64_t pages = size > 0 ? divCeil(size, pageSize) : 0;
+    while (pages > 0) {
+        const Addr base = leafBase(vaddr);
+        const unsigned first = leafIndex(vaddr);
+        const unsigned num = std::min<uint64_t>(pages, LeafPages - first);
+
+        auto it = pTable.lower_bound(base);
+        if (it == pTable.end() || it->first != base) {
+            if (create) {
+                it = pTable.emplace_hint(it, std::piecewise_construct,
+                                         std::forward_as_tuple(base),
+                                         std::forward_as_tuple());
+            } else if (it == pTable.end()) {
+                return;
+            } else {
+                // Skip straight to the next leaf that exists
+                const uint64_t skip = (it->first - vaddr) >> pageShift;
+                if (skip >= pages)
+                    return;
+                vaddr += skip << pageShift;
+                pages -= skip;
+                continue;
+            }
+        }
+
+        if (!f(it, vaddr, first, num))
+            return;
+
+        vaddr += (Addr)num << pageShift;
+        pages -= num;
+    }
+}
+
+EmulationPageTable::Leaf *
+EmulationPageTable::findLeaf(Addr vaddr)
+{
+    const Addr base = leafBase(vaddr);
+    if (lastLeaf && lastLeafBase == base)
+        return lastLeaf;
+
+    auto it = pTable.find(base);
+    if (it == pTable.end())
+        return nullptr;
+
+    lastLeafBase = base;
+    lastLeaf = &it->second;
+    return lastLeaf;
+}
+
+void
+EmulationPageTable::eraseLeaf(PTable::iterator it)
+{
+    assert(it->second.count == 0);
+    if (lastLeaf == &it->second)
+        lastLeaf = nullptr;
+    pTable.erase(it);
+}
+
+void
+EmulationPageTable::setPage(Addr vaddr, const Entry &entry)
+{
+    const Addr base = leafBase(vaddr);
+    auto it = pTable.lower_bound(base);
+    if (it == pTable.end() || it->first != base) {
+        it = pTable.emplace_hint(it, std::piecewise_construct,
+                                 std::forward_as_tuple(base),
+                                 std::forward_as_tuple());
+    }
+
+    Leaf &leaf = it->second;
+    const unsigned idx = leafIndex(vaddr);
+    if (!leaf.isValid(idx)) {
+        leaf.valid[idx / 64] |= 1ULL << (idx % 64);
+        ++leaf.count;
+        ++numPages;
+    }
+    leaf.entries[idx] = entry;
+}
+
+void
+EmulationPageTable::erasePage(Addr vaddr)
+{
+    auto it = pTable.find(leafBase(vaddr));
+    assert(it != pTable.end());
+
+    Leaf &leaf = it->second;
+    const unsigned idx = leafIndex(vaddr);
+    assert(leaf.isValid(idx));
+    leaf.valid[idx / 64] &= ~(1ULL << (idx % 64));
+    --numPages;
+    if (--leaf.count == 0)
+        eraseLeaf(it);
+}
+
 void
 EmulationPageTable::map(Addr vaddr, Addr paddr, int64_t size, uint64_t flags)
 {
@@ -50,22 +168,27 @@ EmulationPageTable::map(Addr vaddr, Addr paddr, int64_t size, uint64_t flags)
 
     DPRINTF(MMU, "Allocating Page: %#x-%#x\n", vaddr, vaddr + size);
 
-    while (size > 0) {
-        auto it = pTable.find(vaddr);
-        if (it != pTable.end()) {
-            // already mapped
-            panic_if(!clobber,
-                     "EmulationPageTable::allocate: addr %#x already mapped",
-                     vaddr);
-            it->second = Entry(paddr, flags);
-        } else {
-            pTable.emplace(vaddr, Entry(paddr, flags));
-        }
-
-        size -= pageSize;
-        vaddr += pageSize;
-        paddr += pageSize;
-    }
+    forEachLeaf(vaddr, size, true,
+        [&](PTable::iterator it, Addr leaf_vaddr, unsigned first,
+            unsigned num) {
+            Leaf &leaf = it->second;
+            for (unsigned idx = first; idx < first + num; ++idx) {
+                if (leaf.isValid(idx)) {
+                    // already mapped
+                    panic_if(!clobber,
+                             "EmulationPageTable::allocate: addr %#x "
+                             "already mapped",
+                             leaf_vaddr + ((Addr)(idx - first) << pageShift));
+                } else {
+                    leaf.valid[idx / 64] |= 1ULL << (idx % 64);
+                    ++leaf.count;
+                    ++numPages;
+                }
+                leaf.entries[idx] = Entry(paddr, flags);
+                paddr += pageSize;
+            }
+            return true;
+        });
 }
 
 void
@@ -78,12 +201,13 @@ EmulationPageTable::remap(Addr vaddr, int64_t size, Addr new_vaddr)
             new_vaddr, size);
 
     while (size > 0) {
-        auto new_it M5_VAR_USED = pTable.find(new_vaddr);
-        auto old_it = pTable.find(vaddr);
-        assert(old_it != pTable.end() && new_it == pTable.end());
+        const Entry *old_entry = lookup(vaddr);
+        assert(old_entry && !lookup(new_vaddr));
+
+        const Entry entry = *old_entry;
+        erasePage(vaddr);
+        setPage(new_vaddr, entry);
 
-        pTable.emplace(new_vaddr, old_it->second);
-        pTable.erase(old_it);
         size -= pageSize;
         vaddr += pageSize;
         new_vaddr += pageSize;
@@ -93,8 +217,15 @@ EmulationPageTable::remap(Addr vaddr, int64_t size, Addr new_vaddr)
 void
 EmulationPageTable::getMappings(std::vector<std::pair<Addr, Addr>> *addr_maps)
 {
-    for (auto &iter : pTable)
-        addr_maps->push_back(std::make_pair(iter.first, iter.second.paddr));
+    for (auto &leaf : pTable) {
+        for (unsigned idx = 0; idx < LeafPages; ++idx) {
+            if (leaf.second.isValid(idx)) {
+                addr_maps->push_back(std::make_pair(
+                    leaf.first + ((Addr)idx << pageShift),
+                    leaf.second.entries[idx].paddr));
+            }
+        }
+    }
 }
 
 void
@@ -104,13 +235,27 @@ EmulationPageTable::unmap(Addr vaddr, int64_t size)
 
     DPRINTF(MMU, "Unmapping page: %#x-%#x\n", vaddr, vaddr + size);
 
-    while (size > 0) {
-        auto it = pTable.find(vaddr);
-        assert(it != pTable.end());
-        pTable.erase(it);
-        size -= pageSize;
-        vaddr += pageSize;
-    }
+    uint64_t pages = size > 0 ? divCeil(size, pageSize) : 0;
+    forEachLeaf(vaddr, size, false,
+        [&](PTable::iterator it, Addr leaf_vaddr, unsigned first,
+            unsigned num) {
+            // All the pages must be mapped, so there can be no gaps
+            assert(leaf_vaddr == vaddr);
+            Leaf &leaf = it->second;
+            for (unsigned w = first / 64; w <= (first + num - 1) / 64; ++w) {
+                const uint64_t bits = wordMask(w, first, num);
+                assert((leaf.valid[w] & bits) == bits);
+                leaf.valid[w] &= ~bits;
+                leaf.count -= popCount(bits);
+            }
+            numPages -= num;
+            pages -= num;
+            vaddr += (Addr)num << pageShift;
+            if (leaf.count == 0)
+                eraseLeaf(it);
+            return true;
+        });
+    assert(pages == 0);
 }
 
 bool
@@ -119,21 +264,58 @@ EmulationPageTable::isUnmapped(Addr vaddr, int64_t size)
     // starting address must be page aligned
     assert(pageOffset(vaddr) == 0);
 
-    for (int64_t offset = 0; offset < size; offset += pageSize)
-        if (pTable.find(vaddr + offset) != pTable.end())
-            return false;
+    bool unmapped = true;
+    forEachLeaf(vaddr, size, false,
+        [&](PTable::iterator it, Addr leaf_vaddr, unsigned first,
+            unsigned num) {
+            const Leaf &leaf = it->second;
+            for (unsigned w = first / 64; w <= (first + num - 1) / 64; ++w) {
+                if (leaf.valid[w] & wordMask(w, first, num)) {
+                    unmapped = false;
+                    return false;
+                }
+            }
+            return true;
+        });
 
-    return true;
+    return unmapped;
+}
+
+std::vector<AddrRange>
+EmulationPageTable::mappedRanges(Addr vaddr, int64_t size)
+{
+    std::vector<AddrRange> ranges;
+    forEachLeaf(vaddr, size, false,
+        [&](PTable::iterator it, Addr leaf_vaddr, unsigned first,
+            unsigned num) {
+            const Leaf &leaf = it->second;
+            for (unsigned idx = first; idx < first + num; ++idx) {
+                if (!leaf.isValid(idx))
+                    continue;
+
+                const Addr page =
+                    leaf_vaddr + ((Addr)(idx - first) << pageShift);
+                if (!ranges.empty() && ranges.back().end() == page) {
+                    ranges.back() =
+                        AddrRange(ranges.back().start(), page + pageSize);
+                } else {
+                    ranges.emplace_back(page, page + pageSize);
+                }
+            }
+            return true;
+        });
+
+    return ranges;
 }
 
 const EmulationPageTable::Entry *
 EmulationPageTable::lookup(Addr vaddr)
 {
-    Addr page_addr = pageAlign(vaddr);
-    PTableItr iter = pTable.find(page_addr);
-    if (iter == pTable.end())
+    Leaf *leaf = findLeaf(vaddr);
+    const unsigned idx = leafIndex(vaddr);
+    if (!leaf || !leaf->isValid(idx))
         return nullptr;
-    return &(iter->second);
+    return &leaf->entries[idx];
 }
 
 bool
@@ -169,17 +351,23 @@ void
 EmulationPageTable::serialize(CheckpointOut &cp) const
 {
     ScopedCheckpointSection sec(cp, "ptable");
-    paramOut(cp, "size", pTable.size());
+    paramOut(cp, "size", numPages);
 
-    PTable::size_type count = 0;
-    for (auto &pte : pTable) {
-        ScopedCheckpointSection sec(cp, csprintf("Entry%d", count++));
+    uint64_t count = 0;
+    for (auto &leaf : pTable) {
+        for (unsigned idx = 0; idx < LeafPages; ++idx) {
+            if (!leaf.second.isValid(idx))
+                continue;
 
-        paramOut(cp, "vaddr", pte.first);
-        paramOut(cp, "paddr", pte.second.paddr);
-        paramOut(cp, "flags", pte.second.flags);
+            ScopedCheckpointSection sec(cp, csprintf("Entry%d", count++));
+
+            const Entry &pte = leaf.second.entries[idx];
+            paramOut(cp, "vaddr", leaf.first + ((Addr)idx << pageShift));
+            paramOut(cp, "paddr", pte.paddr);
+            paramOut(cp, "flags", pte.flags);
+        }
     }
-    assert(count == pTable.size());
+    assert(count == numPages);
 }
 
 void
@@ -199,7 +387,6 @@ EmulationPageTable::unserialize(CheckpointIn &cp)
         UNSERIALIZE_SCALAR(paddr);
         UNSERIALIZE_SCALAR(flags);
 
-        pTable.emplace(vaddr, Entry(paddr, flags));
+        setPage(vaddr, Entry(paddr, flags));
     }
 }
-
@@ -35,9 +35,12 @@
 #ifndef __MEM_PAGE_TABLE_HH__
 #define __MEM_PAGE_TABLE_HH__
 
+#include <array>
+#include <map>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
+#include "base/addr_range.hh"
 #include "base/intmath.hh"
 #include "base/types.hh"
 #include "mem/request.hh"
@@ -58,12 +61,78 @@ class EmulationPageTable : public Serializable
     };
 
   protected:
-    typedef std::unordered_map<Addr, Entry> PTable;
-    typedef PTable::iterator PTableItr;
+    /// Number of pages covered by a leaf of the page table
+    static const unsigned LeafPages = 512;
+
+    /**
+     * A leaf holds the entries of an aligned block of LeafPages pages,
+     * and a bitmap of the entries that are valid.
+     */
+    struct Leaf
+    {
+        std::array<Entry, LeafPages> entries;
+        std::array<uint64_t, LeafPages / 64> valid;
+        unsigned count;
+
+        Leaf() : valid{}, count(0) {}
+
+        bool
+        isValid(unsigned idx) const
+        {
+            return valid[idx / 64] & (1ULL << (idx % 64));
+        }
+    };
+
+    /**
+     * The page table is two-level: the leaves are kept in an ordered
+     * map keyed by their base address, so that operations on a range
+     * of pages skip the parts of the address space that have no leaf.
+     */
+    typedef std::map<Addr, Leaf> PTable;
     PTable pTable;
 
+    /// Number of valid entries in all the leaves
+    uint64_t numPages;
+
+    /// Leaf used by the last lookup, translations tend to be local
+    Addr lastLeafBase;
+    Leaf *lastLeaf;
+
     const Addr pageSize;
     const Addr offsetMask;
+    const unsigned pageShift;
+    const Addr leafMask;
+
+    /// Base address of the leaf holding a page
+    Addr leafBase(Addr vaddr) const { return vaddr & ~leafMask; }
+
+    /// Index of a page in its leaf
+    unsigned
+    leafIndex(Addr vaddr) const
+    {
+        return (vaddr >> pageShift) & (LeafPages - 1);
+    }
+
+    /// Find the leaf holding a page, nullptr if there is none
+    Leaf *findLeaf(Addr vaddr);
+
+    /**
+     * Call a function on each leaf that overlaps a page aligned range,
+     * with the first page in that leaf and the number of pages. Leaves
+     * are created on the way if create is set, otherwise the parts of
+     * the range without a leaf are skipped.
+     */
+    template <typename F>
+    void forEachLeaf(Addr vaddr, int64_t size, bool create, F f);
+
+    /// Remove a leaf that no longer holds any entries
+    void eraseLeaf(PTable::iterator it);
+
+    /// Set the entry for a single page, creating its leaf if needed
+    void setPage(Addr vaddr, const Entry &entry);
+
+    /// Remove the entry for a single page, which must be mapped
+    void erasePage(Addr vaddr);
 
     const uint64_t _pid;
     const std::string _name;
@@ -72,7 +141,10 @@ class EmulationPageTable : public Serializable
 
     EmulationPageTable(
             const std::string &__name, uint64_t _pid, Addr _pageSize) :
+            numPages(0), lastLeafBase(0), lastLeaf(nullptr),
             pageSize(_pageSize), offsetMask(mask(floorLog2(_pageSize))),
+            pageShift(floorLog2(_pageSize)),
+            leafMask(mask(floorLog2(_pageSize) + floorLog2(LeafPages))),
             _pid(_pid), _name(__name), shared(false)
     {
         assert(isPowerOf2(pageSize));
@@ -125,6 +197,15 @@ class EmulationPageTable : public Serializable
      */
     virtual bool isUnmapped(Addr vaddr, int64_t size);
 
+    /**
+     * Find the mapped parts of a region.
+     * @param vaddr The starting virtual address of the region.
+     * @param size The length of the region.
+     * @return The ranges of contiguous mapped pages in the region, in
+     *         ascending order.
+     */
+    std::vector<AddrRange> mappedRanges(Addr vaddr, int64_t size);
+
     /**
      * Lookup function
      * @param vaddr The virtual address.
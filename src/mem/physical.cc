@@ -39,6 +39,7 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/user.h>
 #include <unistd.h>
@@ -47,6 +48,7 @@
 #include <cerrno>
 #include <climits>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -72,9 +74,10 @@ using namespace std;
 PhysicalMemory::PhysicalMemory(const string& _name,
                                const vector<AbstractMemory*>& _memories,
                                bool mmap_using_noreserve,
-                               const std::string& shared_backstore) :
+                               const std::string& shared_backstore,
+                               bool mmap_memory_image) :
     _name(_name), size(0), mmapUsingNoReserve(mmap_using_noreserve),
-    sharedBackstore(shared_backstore)
+    sharedBackstore(shared_backstore), mmapMemoryImage(mmap_memory_image)
 {
     if (mmap_using_noreserve)
         warn("Not reserving swap space. May cause SIGSEGV on actual usage\n");
@@ -344,8 +347,10 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
 {
     // we cannot use the address range for the name as the
     // memories that are not part of the address map can overlap
-    string filename = name() + ".store" + to_string(store_id) + ".pmem";
+    string filename = name() + ".store" + to_string(store_id) +
+        (mmapMemoryImage ? ".img" : ".pmem");
     long range_size = range.size();
+    string format = mmapMemoryImage ? "raw" : "gzip";
 
     DPRINTF(Checkpoint, "Serializing physical memory %s with size %d\n",
             filename, range_size);
@@ -353,9 +358,16 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
     SERIALIZE_SCALAR(store_id);
     SERIALIZE_SCALAR(filename);
     SERIALIZE_SCALAR(range_size);
+    SERIALIZE_SCALAR(format);
 
     // write memory file
     string filepath = CheckpointIn::dir() + "/" + filename.c_str();
+
+    if (mmapMemoryImage) {
+        writeStoreImage(filepath, pmem, range.size());
+        return;
+    }
+
     gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
     if (compressed_mem == NULL)
         fatal("Can't open physical memory checkpoint file '%s'\n",
@@ -421,11 +433,6 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
     UNSERIALIZE_SCALAR(filename);
     string filepath = cp.getCptDir() + "/" + filename;
 
-    // mmap memoryfile
-    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
-    if (compressed_mem == NULL)
-        fatal("Can't open physical memory checkpoint file '%s'", filename);
-
     // we've already got the actual backing store mapped
     uint8_t* pmem = backingStore[store_id].pmem;
     AddrRange range = backingStore[store_id].range;
@@ -440,6 +447,27 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
         fatal("Memory range size has changed! Saw %lld, expected %lld\n",
               range_size, range.size());
 
+    // checkpoints that predate the raw images are all compressed
+    string format = "gzip";
+    UNSERIALIZE_OPT_SCALAR(format);
+
+    if (format == "raw") {
+        // a shared backing store has to stay shared, so it can only
+        // be filled in and not remapped
+        if (sharedBackstore.empty())
+            mapStoreImage(filepath, pmem, range.size());
+        else
+            readStoreImage(filepath, pmem, range.size());
+        return;
+    }
+    fatal_if(format != "gzip",
+             "Unknown format '%s' of physical memory checkpoint file '%s'\n",
+             format, filename);
+
+    gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
+    if (compressed_mem == NULL)
+        fatal("Can't open physical memory checkpoint file '%s'", filename);
+
     uint64_t curr_size = 0;
     long* temp_page = new long[chunk_size];
     long* pmem_current;
@@ -468,3 +496,111 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
         fatal("Close failed on physical memory checkpoint file '%s'\n",
               filename);
 }
+
+void
+PhysicalMemory::writeStoreImage(const string &filepath, const uint8_t *pmem,
+                                uint64_t size) const
+{
+    int fd = open(filepath.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0664);
+    fatal_if(fd == -1, "Can't open physical memory checkpoint file '%s': %s\n",
+             filepath, strerror(errno));
+
+    // size the file up front and only write the pages holding data, so
+    // that the untouched parts of the memory stay holes in the image
+    fatal_if(ftruncate(fd, size) == -1,
+             "Can't size physical memory checkpoint file '%s': %s\n",
+             filepath, strerror(errno));
+
+    const uint64_t page_size = sysconf(_SC_PAGESIZE);
+    auto is_zero = [](const uint8_t *page, uint64_t len) {
+        return page[0] == 0 && memcmp(page, page + 1, len - 1) == 0;
+    };
+
+    uint64_t offset = 0;
+    while (offset < size) {
+        // skip the zero pages
+        uint64_t len = std::min(page_size, size - offset);
+        if (is_zero(pmem + offset, len)) {
+            offset += len;
+            continue;
+        }
+
+        // and write the following run of pages with data in one go
+        uint64_t end = offset + len;
+        while (end < size) {
+            len = std::min(page_size, size - end);
+            if (is_zero(pmem + end, len))
+                break;
+            end += len;
+        }
+
+        while (offset < end) {
+            ssize_t written = pwrite(fd, pmem + offset,
+                                     std::min<uint64_t>(end - offset, INT_MAX),
+                                     offset);
+            if (written == -1 && errno == EINTR)
+                continue;
+            fatal_if(written <= 0,
+                     "Write failed on physical memory checkpoint file "
+                     "'%s': %s\n", filepath, strerror(errno));
+            offset += written;
+        }
+    }
+
+    fatal_if(close(fd), "Close failed on physical memory checkpoint file "
+             "'%s'\n", filepath);
+}
+
+void
+PhysicalMemory::mapStoreImage(const string &filepath, uint8_t *pmem,
+                              uint64_t size)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    fatal_if(fd == -1, "Can't open physical memory checkpoint file '%s': %s\n",
+             filepath, strerror(errno));
+
+    struct stat st;
+    fatal_if(fstat(fd, &st) == -1 || (uint64_t)st.st_size != size,
+             "Physical memory checkpoint file '%s' does not match the size "
+             "of the memory (%lld bytes)\n", filepath, size);
+
+    // map the image privately over the existing backing store, so the
+    // memories keep pointing at the same host address and writes only
+    // copy the pages they touch
+    int map_flags = MAP_PRIVATE | MAP_FIXED;
+    if (mmapUsingNoReserve)
+        map_flags |= MAP_NORESERVE;
+
+    uint8_t *mapped = (uint8_t *)mmap(pmem, size, PROT_READ | PROT_WRITE,
+                                      map_flags, fd, 0);
+    fatal_if(mapped != pmem,
+             "Could not map physical memory checkpoint file '%s': %s\n",
+             filepath, strerror(errno));
+
+    // the mapping holds its own reference to the file
+    close(fd);
+}
+
+void
+PhysicalMemory::readStoreImage(const string &filepath, uint8_t *pmem,
+                               uint64_t size)
+{
+    int fd = open(filepath.c_str(), O_RDONLY);
+    fatal_if(fd == -1, "Can't open physical memory checkpoint file '%s': %s\n",
+             filepath, strerror(errno));
+
+    uint64_t offset = 0;
+    while (offset < size) {
+        ssize_t bytes_read = pread(fd, pmem + offset,
+                                   std::min<uint64_t>(size - offset, INT_MAX),
+                                   offset);
+        if (bytes_read == -1 && errno == EINTR)
+            continue;
+        fatal_if(bytes_read <= 0,
+                 "Read failed on physical memory checkpoint file '%s'\n",
+                 filepath);
+        offset += bytes_read;
+    }
+
+    close(fd);
+}
@@ -129,6 +129,9 @@ class PhysicalMemory : public Serializable
 
     const std::string sharedBackstore;
 
+    // Checkpoint the backing store as a raw image that can be mapped
+    const bool mmapMemoryImage;
+
     // The physical memory used to provide the memory in the simulated
     // system
     std::vector<BackingStoreEntry> backingStore;
@@ -161,7 +164,8 @@ class PhysicalMemory : public Serializable
     PhysicalMemory(const std::string& _name,
                    const std::vector<AbstractMemory*>& _memories,
                    bool mmap_using_noreserve,
-                   const std::string& shared_backstore);
+                   const std::string& shared_backstore,
+                   bool mmap_memory_image);
 
     /**
      * Unmap all the backing store we have used.
@@ -254,6 +258,17 @@ class PhysicalMemory : public Serializable
     void serializeStore(CheckpointOut &cp, unsigned int store_id,
                         AddrRange range, uint8_t* pmem) const;
 
+    /**
+     * Write a backing store as an uncompressed image. Pages that are
+     * all zero are left as holes in the file.
+     *
+     * @param filepath Path of the image file
+     * @param pmem The host pointer to the backing store
+     * @param size The size of the backing store
+     */
+    void writeStoreImage(const std::string &filepath, const uint8_t *pmem,
+                         uint64_t size) const;
+
     /**
      * Unserialize the memories in the system. As with the
      * serialization, this action is independent of how the address
@@ -266,6 +281,25 @@ class PhysicalMemory : public Serializable
      */
     void unserializeStore(CheckpointIn &cp);
 
+    /**
+     * Replace a backing store with a private, copy-on-write mapping
+     * of an uncompressed image, keeping its host address.
+     *
+     * @param filepath Path of the image file
+     * @param pmem The host pointer to the backing store
+     * @param size The size of the backing store
+     */
+    void mapStoreImage(const std::string &filepath, uint8_t *pmem,
+                       uint64_t size);
+
+    /**
+     * Read an uncompressed image into a backing store, for stores
+     * that cannot be remapped as they are shared with other
+     * processes.
+     */
+    void readStoreImage(const std::string &filepath, uint8_t *pmem,
+                        uint64_t size);
+
 };
 
 #endif //__MEM_PHYSICAL_HH__
@@ -49,6 +49,11 @@ class StackDistProbe(BaseMemProbe):
                                "Cache line size in bytes (must be larger or "
                                "equal to the system's line size)")
 
+    # spatial sampling of the tracked cache lines
+    sampling_ratio = Param.Unsigned(1, "Only track one in this many cache "
+                                    "lines, selected by address hash, and "
+                                    "scale the results accordingly")
+
     # enable verification stack
     verify = Param.Bool(False, "Verify behaviuor with reference implementation")
 
@@ -43,6 +43,7 @@
 StackDistProbe::StackDistProbe(StackDistProbeParams *p)
     : BaseMemProbe(p),
       lineSize(p->line_size),
+      samplingRatio(p->sampling_ratio),
       disableLinearHists(p->disable_linear_hists),
       disableLogHists(p->disable_log_hists),
       calc(p->verify)
@@ -50,6 +51,8 @@ StackDistProbe::StackDistProbe(StackDistProbeParams *p)
     fatal_if(p->system->cacheLineSize() > p->line_size,
              "The stack distance probe must use a cache line size that is "
              "larger or equal to the system's cahce line size.");
+    fatal_if(samplingRatio == 0,
+             "The stack distance probe's sampling ratio must be positive.");
 }
 
 void
@@ -93,6 +96,22 @@ StackDistProbe::regStats()
         .flags(nozero);
 }
 
+bool
+StackDistProbe::isSampled(Addr aligned_addr) const
+{
+    if (samplingRatio == 1)
+        return true;
+
+    // Mix the line address bits (splitmix64 finalizer) so that strided
+    // access patterns are not aliased with the sampling ratio
+    uint64_t hash = aligned_addr / lineSize;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    hash = hash ^ (hash >> 31);
+
+    return (hash % samplingRatio) == 0;
+}
+
 void
 StackDistProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
 {
@@ -104,19 +123,26 @@ StackDistProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
     // Align the address to a cache line size
     const Addr aligned_addr(roundDown(pkt_info.addr, lineSize));
 
+    // Only a subset of the lines is tracked when sampling. Each tracked
+    // access stands for samplingRatio accesses, and its distance only
+    // counts the tracked lines, so both are scaled
+    if (!isSampled(aligned_addr))
+        return;
+
     // Calculate the stack distance
-    const uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
+    uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
     if (sd == StackDistCalc::Infinity) {
-        infiniteSD++;
+        infiniteSD += samplingRatio;
         return;
     }
+    sd *= samplingRatio;
 
     // Sample the stack distance of the address in linear bins
     if (!disableLinearHists) {
         if (pkt_info.cmd.isRead())
-            readLinearHist.sample(sd);
+            readLinearHist.sample(sd, samplingRatio);
         else
-            writeLinearHist.sample(sd);
+            writeLinearHist.sample(sd, samplingRatio);
     }
 
     if (!disableLogHists) {
@@ -124,9 +150,9 @@ StackDistProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
 
         // Sample the stack distance of the address in log bins
         if (pkt_info.cmd.isRead())
-            readLogHist.sample(sd_lg2);
+            readLogHist.sample(sd_lg2, samplingRatio);
         else
-            writeLogHist.sample(sd_lg2);
+            writeLogHist.sample(sd_lg2, samplingRatio);
     }
 }
 
@@ -55,10 +55,23 @@ class StackDistProbe : public BaseMemProbe
   protected:
     void handleRequest(const ProbePoints::PacketInfo &pkt_info) override;
 
+    /**
+     * Check if a cache line belongs to the sampled subset of lines. The
+     * selection is based on a hash of the line address, so that all
+     * accesses to a sampled line are tracked (SHARDS-style sampling).
+     *
+     * @param aligned_addr The line-aligned address.
+     * @return True if the line is tracked.
+     */
+    bool isSampled(Addr aligned_addr) const;
+
   protected:
     // Cache line size to simulate
     const unsigned lineSize;
 
+    // Track only one in this many cache lines
+    const unsigned samplingRatio;
+
     // Disable the linear histograms
     const bool disableLinearHists;
 
@@ -54,7 +54,9 @@ class Consumer
 
     virtual void wakeup() = 0;
     virtual void print(std::ostream& out) const = 0;
-    virtual void storeEventInfo(int info) {}
+    // Called by a MessageBuffer with the incoming link and virtual network
+    // it was registered with whenever a message is enqueued
+    virtual void storeEventInfo(int link_id, int vnet) {}
 
     bool
     alreadyScheduled(Tick time)
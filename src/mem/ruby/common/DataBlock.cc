@@ -28,22 +28,45 @@
 
 #include "mem/ruby/common/DataBlock.hh"
 
+#include <utility>
+
 #include "mem/ruby/common/WriteMask.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 DataBlock::DataBlock(const DataBlock &cp)
 {
-    m_data = new uint8_t[RubySystem::getBlockSizeBytes()];
-    memcpy(m_data, cp.m_data, RubySystem::getBlockSizeBytes());
-    m_alloc = true;
+    alloc();
+    if (cp.m_data) {
+        memcpy(m_data, cp.m_data, RubySystem::getBlockSizeBytes());
+    } else {
+        // a block that was moved from has no data left to copy
+        clear();
+    }
+}
+
+DataBlock::DataBlock(DataBlock &&mv)
+{
+    if (!mv.m_data) {
+        alloc();
+        clear();
+    } else if (mv.m_data != mv.m_inline_data) {
+        // take over the heap-allocated data
+        m_data = mv.m_data;
+        mv.m_data = nullptr;
+    } else {
+        m_data = m_inline_data;
+        memcpy(m_data, mv.m_data, RubySystem::getBlockSizeBytes());
+    }
 }
 
 void
 DataBlock::alloc()
 {
-    m_data = new uint8_t[RubySystem::getBlockSizeBytes()];
-    m_alloc = true;
-    clear();
+    if (RubySystem::getBlockSizeBytes() <= InlineBlockSizeBytes) {
+        m_data = m_inline_data;
+    } else {
+        m_data = new uint8_t[RubySystem::getBlockSizeBytes()];
+    }
 }
 
 void
@@ -113,6 +136,28 @@ DataBlock::setData(const uint8_t *data, int offset, int len)
 DataBlock &
 DataBlock::operator=(const DataBlock & obj)
 {
-    memcpy(m_data, obj.m_data, RubySystem::getBlockSizeBytes());
+    const uint8_t *data = obj.m_data;
+    if (!m_data)
+        alloc();
+    if (data) {
+        memcpy(m_data, data, RubySystem::getBlockSizeBytes());
+    } else {
+        // a block that was moved from has no data left to copy
+        clear();
+    }
+    return *this;
+}
+
+DataBlock &
+DataBlock::operator=(DataBlock && obj)
+{
+    if (obj.m_data && obj.m_data != obj.m_inline_data &&
+        m_data != m_inline_data) {
+        // neither block is stored inline, so swap the data rather than
+        // copying it
+        std::swap(m_data, obj.m_data);
+    } else if (this != &obj) {
+        *this = obj;
+    }
     return *this;
 }
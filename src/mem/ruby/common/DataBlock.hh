@@ -40,22 +40,30 @@ class WriteMask;
 class DataBlock
 {
   public:
+    /**
+     * Block sizes up to this number of bytes are stored inline, so that
+     * creating and copying blocks does not allocate memory. Larger
+     * blocks are allocated on the heap.
+     */
+    static const int InlineBlockSizeBytes = 64;
+
     DataBlock()
     {
         alloc();
+        clear();
     }
 
     DataBlock(const DataBlock &cp);
+    DataBlock(DataBlock &&mv);
 
     ~DataBlock()
     {
-        if (m_alloc)
+        if (m_data != m_inline_data)
             delete [] m_data;
     }
 
     DataBlock& operator=(const DataBlock& obj);
-
-    void assign(uint8_t *data);
+    DataBlock& operator=(DataBlock&& obj);
 
     void clear();
     uint8_t getByte(int whichByte) const;
@@ -71,21 +79,18 @@ class DataBlock
 
   private:
     void alloc();
+
+    /**
+     * The data of the block, pointing to m_inline_data unless the block
+     * is too large for it. The data of a block that was moved from may
+     * have been taken away, in which case this is null until the block
+     * is assigned to again. Such a block can only be destroyed, assigned
+     * to, or copied and moved from as if it were cleared.
+     */
     uint8_t *m_data;
-    bool m_alloc;
+    uint8_t m_inline_data[InlineBlockSizeBytes];
 };
 
-inline void
-DataBlock::assign(uint8_t *data)
-{
-    assert(data != NULL);
-    if (m_alloc) {
-        delete [] m_data;
-    }
-    m_data = data;
-    m_alloc = false;
-}
-
 inline uint8_t
 DataBlock::getByte(int whichByte) const
 {
@@ -30,24 +30,26 @@
 
 #include <algorithm>
 
+#include "base/bitfield.hh"
+
 NetDest::NetDest()
 {
-  resize();
+    clear();
 }
 
 void
 NetDest::add(MachineID newElement)
 {
-    assert(bitIndex(newElement.num) < m_bits[vecIndex(newElement)].getSize());
-    m_bits[vecIndex(newElement)].add(bitIndex(newElement.num));
+    assert(bitIndex(newElement.num) <
+           MachineType_base_count(newElement.type));
+    m_words[wordIndex(newElement)] |= bitMask(newElement);
 }
 
 void
 NetDest::addNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].addSet(netDest.m_bits[i]);
+    for (int i = 0; i < NumWords; i++) {
+        m_words[i] |= netDest.m_words[i];
     }
 }
 
@@ -57,30 +59,28 @@ NetDest::setNetDest(MachineType machine, const Set& set)
     // assure that there is only one set of destinations for this machine
     assert(MachineType_base_level((MachineType)(machine + 1)) -
            MachineType_base_level(machine) == 1);
-    m_bits[MachineType_base_level(machine)] = set;
+    uint64_t *slot = &m_words[slotOffset(MachineType_base_level(machine))];
+    std::copy(set.m_words, set.m_words + Set::NumWords, slot);
 }
 
 void
 NetDest::remove(MachineID oldElement)
 {
-    m_bits[vecIndex(oldElement)].remove(bitIndex(oldElement.num));
+    m_words[wordIndex(oldElement)] &= ~bitMask(oldElement);
 }
 
 void
 NetDest::removeNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].removeSet(netDest.m_bits[i]);
+    for (int i = 0; i < NumWords; i++) {
+        m_words[i] &= ~netDest.m_words[i];
     }
 }
 
 void
 NetDest::clear()
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].clear();
-    }
+    std::fill(m_words, m_words + NumWords, 0);
 }
 
 void
@@ -95,55 +95,64 @@ NetDest::broadcast()
 void
 NetDest::broadcast(MachineType machineType)
 {
-    for (NodeID i = 0; i < MachineType_base_count(machineType); i++) {
-        MachineID mach = {machineType, i};
-        add(mach);
+    uint64_t *slot = &m_words[slotOffset(MachineType_base_level(machineType))];
+    int count = MachineType_base_count(machineType);
+    assert(count <= NUMBER_BITS_PER_SET);
+    for (int w = 0; w < Set::NumWords; w++) {
+        int lo = w * Set::WordBits;
+        if (count >= lo + Set::WordBits)
+            slot[w] = ~uint64_t(0);
+        else if (count > lo)
+            slot[w] |= mask(count - lo);
     }
 }
 
 //For Princeton Network
-std::vector<NodeID>
-NetDest::getAllDest()
+void
+NetDest::getAllDest(std::vector<NodeID>& dest) const
 {
-    std::vector<NodeID> dest;
     dest.clear();
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                int id = MachineType_base_number((MachineType)i) + j;
-                dest.push_back((NodeID)id);
-            }
+    for (int i = 0; i < NumWords; i++) {
+        uint64_t word = m_words[i];
+        if (!word)
+            continue;
+        MachineType machine = MachineType_from_base_level(i / Set::NumWords);
+        NodeID base = MachineType_base_number(machine) +
+            (i % Set::NumWords) * Set::WordBits;
+        while (word) {
+            dest.push_back(base + ctz64(word));
+            word &= word - 1;
         }
     }
-    return dest;
 }
 
 int
 NetDest::count() const
 {
     int counter = 0;
-    for (int i = 0; i < m_bits.size(); i++) {
-        counter += m_bits[i].count();
+    for (int i = 0; i < NumWords; i++) {
+        counter += popCount(m_words[i]);
     }
     return counter;
 }
 
 NodeID
-NetDest::elementAt(MachineID index)
+NetDest::elementAt(MachineID index) const
 {
-    return m_bits[vecIndex(index)].elementAt(bitIndex(index.num));
+    return isElement(index);
 }
 
 MachineID
 NetDest::smallestElement() const
 {
     assert(count() > 0);
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (NodeID j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
-                MachineID mach = {MachineType_from_base_level(i), j};
-                return mach;
-            }
+    for (int i = 0; i < NumWords; i++) {
+        if (m_words[i]) {
+            NodeID j = (i % Set::NumWords) * Set::WordBits +
+                ctz64(m_words[i]);
+            MachineID mach = {
+                MachineType_from_base_level(i / Set::NumWords), j};
+            return mach;
         }
     }
     panic("No smallest element of an empty set.");
@@ -152,10 +161,12 @@ NetDest::smallestElement() const
 MachineID
 NetDest::smallestElement(MachineType machine) const
 {
-    int size = m_bits[MachineType_base_level(machine)].getSize();
-    for (NodeID j = 0; j < size; j++) {
-        if (m_bits[MachineType_base_level(machine)].isElement(j)) {
-            MachineID mach = {machine, j};
+    const uint64_t *slot =
+        &m_words[slotOffset(MachineType_base_level(machine))];
+    for (int w = 0; w < Set::NumWords; w++) {
+        if (slot[w]) {
+            MachineID mach = {machine,
+                              NodeID(w * Set::WordBits + ctz64(slot[w]))};
             return mach;
         }
     }
@@ -167,8 +178,13 @@ NetDest::smallestElement(MachineType machine) const
 bool
 NetDest::isBroadcast() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isBroadcast()) {
+    for (int i = 0; i < MachineType_NUM; i++) {
+        const uint64_t *slot = &m_words[slotOffset(i)];
+        int counter = 0;
+        for (int w = 0; w < Set::NumWords; w++) {
+            counter += popCount(slot[w]);
+        }
+        if (counter != MachineType_base_count((MachineType)i)) {
             return false;
         }
     }
@@ -179,23 +195,19 @@ NetDest::isBroadcast() const
 bool
 NetDest::isEmpty() const
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isEmpty()) {
-            return false;
-        }
+    uint64_t r = 0;
+    for (int i = 0; i < NumWords; i++) {
+        r |= m_words[i];
     }
-    return true;
+    return r == 0;
 }
 
 // returns the logical OR of "this" set and orNetDest
 NetDest
 NetDest::OR(const NetDest& orNetDest) const
 {
-    assert(m_bits.size() == orNetDest.getSize());
-    NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].OR(orNetDest.m_bits[i]);
-    }
+    NetDest result(*this);
+    result.addNetDest(orNetDest);
     return result;
 }
 
@@ -203,10 +215,9 @@ NetDest::OR(const NetDest& orNetDest) const
 NetDest
 NetDest::AND(const NetDest& andNetDest) const
 {
-    assert(m_bits.size() == andNetDest.getSize());
-    NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].AND(andNetDest.m_bits[i]);
+    NetDest result(*this);
+    for (int i = 0; i < NumWords; i++) {
+        result.m_words[i] &= andNetDest.m_words[i];
     }
     return result;
 }
@@ -215,53 +226,38 @@ NetDest::AND(const NetDest& andNetDest) const
 bool
 NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 {
-    assert(m_bits.size() == other_netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].intersectionIsEmpty(other_netDest.m_bits[i])) {
-            return true;
-        }
+    uint64_t r = 0;
+    for (int i = 0; i < NumWords; i++) {
+        r |= m_words[i] & other_netDest.m_words[i];
     }
-    return false;
+    return r != 0;
 }
 
 bool
 NetDest::isSuperset(const NetDest& test) const
 {
-    assert(m_bits.size() == test.getSize());
-
-    for (int i = 0; i < m_bits.size(); i++) {
-        if (!m_bits[i].isSuperset(test.m_bits[i])) {
-            return false;
-        }
+    uint64_t r = 0;
+    for (int i = 0; i < NumWords; i++) {
+        r |= test.m_words[i] & ~m_words[i];
     }
-    return true;
+    return r == 0;
 }
 
 bool
 NetDest::isElement(MachineID element) const
 {
-    return ((m_bits[vecIndex(element)])).isElement(bitIndex(element.num));
-}
-
-void
-NetDest::resize()
-{
-    m_bits.resize(MachineType_base_level(MachineType_NUM));
-    assert(m_bits.size() == MachineType_NUM);
-
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].setSize(MachineType_base_count((MachineType)i));
-    }
+    return m_words[wordIndex(element)] & bitMask(element);
 }
 
 void
 NetDest::print(std::ostream& out) const
 {
-    out << "[NetDest (" << m_bits.size() << ") ";
+    out << "[NetDest (" << MachineType_NUM << ") ";
 
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            out << (bool) m_bits[i].isElement(j) << " ";
+    for (int i = 0; i < MachineType_NUM; i++) {
+        MachineType machine = MachineType_from_base_level(i);
+        for (NodeID j = 0; j < MachineType_base_count(machine); j++) {
+            out << isElement({machine, j}) << " ";
         }
         out << " - ";
     }
@@ -271,10 +267,9 @@ NetDest::print(std::ostream& out) const
 bool
 NetDest::isEqual(const NetDest& n) const
 {
-    assert(m_bits.size() == n.m_bits.size());
-    for (unsigned int i = 0; i < m_bits.size(); ++i) {
-        if (!m_bits[i].isEqual(n.m_bits[i]))
-            return false;
+    uint64_t diff = 0;
+    for (int i = 0; i < NumWords; i++) {
+        diff |= m_words[i] ^ n.m_words[i];
     }
-    return true;
+    return diff == 0;
 }
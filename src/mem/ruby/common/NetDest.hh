@@ -36,6 +36,11 @@
 #include "mem/ruby/common/MachineID.hh"
 
 // NetDest specifies the network destination of a Message
+//
+// The destinations are kept as one flat array of bit words with a fixed
+// slot of Set::NumWords words per MachineType, so a NetDest is a plain
+// value that never touches the heap and the set operations below reduce
+// to straight loops over the whole array.
 class NetDest
 {
   public:
@@ -46,6 +51,9 @@ class NetDest
 
     NetDest& operator=(const Set& obj);
 
+    NetDest(const NetDest& obj) = default;
+    NetDest& operator=(const NetDest& obj) = default;
+
     ~NetDest()
     { }
 
@@ -78,17 +86,18 @@ class NetDest
     bool isBroadcast() const;
     bool isEmpty() const;
 
-    // For Princeton Network
-    std::vector<NodeID> getAllDest();
+    // For Princeton Network: fills dest with the global NodeID of every
+    // destination. The vector is cleared first so that callers can reuse
+    // its storage across messages.
+    void getAllDest(std::vector<NodeID>& dest) const;
 
     MachineID smallestElement() const;
     MachineID smallestElement(MachineType machine) const;
 
-    void resize();
-    int getSize() const { return m_bits.size(); }
+    int getSize() const { return MachineType_NUM; }
 
     // get element for a index
-    NodeID elementAt(MachineID index);
+    NodeID elementAt(MachineID index) const;
 
     void print(std::ostream& out) const;
 
@@ -99,13 +108,30 @@ class NetDest
     vecIndex(MachineID m) const
     {
         int vec_index = MachineType_base_level(m.type);
-        assert(vec_index < m_bits.size());
+        assert(vec_index < MachineType_NUM);
         return vec_index;
     }
 
     NodeID bitIndex(NodeID index) const { return index; }
 
-    std::vector<Set> m_bits;  // a vector of bit vectors - i.e. Sets
+    // first word of the slot holding the given MachineType level
+    static int slotOffset(int vec_index) { return vec_index * Set::NumWords; }
+
+    int
+    wordIndex(MachineID m) const
+    {
+        return slotOffset(vecIndex(m)) + bitIndex(m.num) / Set::WordBits;
+    }
+
+    static uint64_t
+    bitMask(MachineID m)
+    {
+        return uint64_t(1) << (m.num % Set::WordBits);
+    }
+
+    static constexpr int NumWords = MachineType_NUM * Set::NumWords;
+
+    uint64_t m_words[NumWords];  // one Set-sized slot per MachineType
 };
 
 inline std::ostream&
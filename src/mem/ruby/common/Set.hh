@@ -32,23 +32,44 @@
 #ifndef __MEM_RUBY_COMMON_SET_HH__
 #define __MEM_RUBY_COMMON_SET_HH__
 
-#include <bitset>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 
+#include "base/bitfield.hh"
 #include "base/logging.hh"
 #include "mem/ruby/common/TypeDefines.hh"
 
+class NetDest;
+
+/**
+ * A fixed-capacity bit set of NodeIDs. The bits live inline in an array
+ * of 64-bit words whose length is fixed at compile time by
+ * NUMBER_BITS_PER_SET, so copies never allocate and the set operations
+ * below are fixed trip-count loops over whole words that the compiler
+ * can unroll and vectorize.
+ */
 class Set
 {
+  public:
+    static constexpr int WordBits = 64;
+    static constexpr int NumWords =
+        (NUMBER_BITS_PER_SET + WordBits - 1) / WordBits;
+
   private:
+    friend class NetDest;
+
     // Number of bits in use in this set.
     // can be defined in build_opts file (default=64).
     int m_nSize;
-    std::bitset<NUMBER_BITS_PER_SET> bits;
+    uint64_t m_words[NumWords];
+
+    static int wordIndex(NodeID index) { return index / WordBits; }
+    static uint64_t bitMask(NodeID index)
+    { return uint64_t(1) << (index % WordBits); }
 
   public:
-    Set() : m_nSize(0) {}
+    Set() : m_nSize(0) { clear(); }
 
     Set(int size) : m_nSize(size)
     {
@@ -56,22 +77,19 @@ class Set
             fatal("Number of bits(%d) < size specified(%d). "
                   "Increase the number of bits and recompile.\n",
                   NUMBER_BITS_PER_SET, size);
+        clear();
     }
 
-    Set(const Set& obj) : m_nSize(obj.m_nSize), bits(obj.bits) {}
+    Set(const Set& obj) = default;
     ~Set() {}
 
-    Set& operator=(const Set& obj)
-    {
-        m_nSize = obj.m_nSize;
-        bits = obj.bits;
-        return *this;
-    }
+    Set& operator=(const Set& obj) = default;
 
     void
     add(NodeID index)
     {
-        bits.set(index);
+        assert(index < NUMBER_BITS_PER_SET);
+        m_words[wordIndex(index)] |= bitMask(index);
     }
 
     /*
@@ -82,7 +100,8 @@ class Set
     addSet(const Set& obj)
     {
         assert(m_nSize == obj.m_nSize);
-        bits |= obj.bits;
+        for (int i = 0; i < NumWords; ++i)
+            m_words[i] |= obj.m_words[i];
     }
 
     /*
@@ -91,7 +110,8 @@ class Set
     void
     remove(NodeID index)
     {
-        bits.reset(index);
+        assert(index < NUMBER_BITS_PER_SET);
+        m_words[wordIndex(index)] &= ~bitMask(index);
     }
 
     /*
@@ -101,26 +121,44 @@ class Set
     removeSet(const Set& obj)
     {
         assert(m_nSize == obj.m_nSize);
-        bits &= (~obj.bits);
+        for (int i = 0; i < NumWords; ++i)
+            m_words[i] &= ~obj.m_words[i];
     }
 
-    void clear() { bits.reset(); }
+    void
+    clear()
+    {
+        for (int i = 0; i < NumWords; ++i)
+            m_words[i] = 0;
+    }
 
     /*
      * this function sets all bits in the set
      */
     void broadcast()
     {
-        bits.set();
-        for (int j = m_nSize; j < NUMBER_BITS_PER_SET; ++j) {
-            bits.reset(j);
+        for (int i = 0; i < NumWords; ++i) {
+            int lo = i * WordBits;
+            if (m_nSize >= lo + WordBits)
+                m_words[i] = ~uint64_t(0);
+            else if (m_nSize > lo)
+                m_words[i] = mask(m_nSize - lo);
+            else
+                m_words[i] = 0;
         }
     }
 
     /*
      * This function returns the population count of 1's in the set
      */
-    int count() const { return bits.count(); }
+    int
+    count() const
+    {
+        int counter = 0;
+        for (int i = 0; i < NumWords; ++i)
+            counter += popCount(m_words[i]);
+        return counter;
+    }
 
     /*
      * This function checks for set equality
@@ -129,7 +167,10 @@ class Set
     isEqual(const Set& obj) const
     {
         assert(m_nSize == obj.m_nSize);
-        return bits == obj.bits;
+        uint64_t diff = 0;
+        for (int i = 0; i < NumWords; ++i)
+            diff |= m_words[i] ^ obj.m_words[i];
+        return diff == 0;
     }
 
     // return the logical OR of this set and orSet
@@ -137,8 +178,8 @@ class Set
     OR(const Set& obj) const
     {
         assert(m_nSize == obj.m_nSize);
-        Set r(m_nSize);
-        r.bits = bits | obj.bits;
+        Set r(*this);
+        r.addSet(obj);
         return r;
     };
 
@@ -147,8 +188,9 @@ class Set
     AND(const Set& obj) const
     {
         assert(m_nSize == obj.m_nSize);
-        Set r(m_nSize);
-        r.bits = bits & obj.bits;
+        Set r(*this);
+        for (int i = 0; i < NumWords; ++i)
+            r.m_words[i] &= obj.m_words[i];
         return r;
     }
 
@@ -156,8 +198,10 @@ class Set
     bool
     intersectionIsEmpty(const Set& obj) const
     {
-        std::bitset<NUMBER_BITS_PER_SET> r = bits & obj.bits;
-        return r.none();
+        uint64_t r = 0;
+        for (int i = 0; i < NumWords; ++i)
+            r |= m_words[i] & obj.m_words[i];
+        return r == 0;
     }
 
     /*
@@ -168,13 +212,20 @@ class Set
     isSuperset(const Set& test) const
     {
         assert(m_nSize == test.m_nSize);
-        std::bitset<NUMBER_BITS_PER_SET> r = bits | test.bits;
-        return (r == bits);
+        uint64_t r = 0;
+        for (int i = 0; i < NumWords; ++i)
+            r |= test.m_words[i] & ~m_words[i];
+        return r == 0;
     }
 
     bool isSubset(const Set& test) const { return test.isSuperset(*this); }
 
-    bool isElement(NodeID element) const { return bits.test(element); }
+    bool
+    isElement(NodeID element) const
+    {
+        assert(element < NUMBER_BITS_PER_SET);
+        return m_words[wordIndex(element)] & bitMask(element);
+    }
 
     /*
      * this function returns true iff all bits in use are set
@@ -182,22 +233,51 @@ class Set
     bool
     isBroadcast() const
     {
-        return (bits.count() == m_nSize);
+        return (count() == m_nSize);
     }
 
-    bool isEmpty() const { return bits.none(); }
+    bool
+    isEmpty() const
+    {
+        uint64_t r = 0;
+        for (int i = 0; i < NumWords; ++i)
+            r |= m_words[i];
+        return r == 0;
+    }
 
-    NodeID smallestElement() const
+    /**
+     * Returns the first element at or above the given index, or the size
+     * of the set if there is none. Walking a set with
+     *
+     *   for (NodeID i = s.nextElement(0); i < s.getSize();
+     *        i = s.nextElement(i + 1))
+     *
+     * visits only the set bits and does not allocate.
+     */
+    NodeID
+    nextElement(NodeID from) const
     {
-        for (int i = 0; i < m_nSize; ++i) {
-            if (bits.test(i)) {
-                return i;
+        for (int i = wordIndex(from); i < NumWords; ++i) {
+            uint64_t word = m_words[i];
+            if (i == wordIndex(from))
+                word &= ~(bitMask(from) - 1);
+            if (word) {
+                NodeID elem = i * WordBits + ctz64(word);
+                return elem < m_nSize ? elem : m_nSize;
             }
         }
+        return m_nSize;
+    }
+
+    NodeID smallestElement() const
+    {
+        NodeID elem = nextElement(0);
+        if (elem < m_nSize)
+            return elem;
         panic("No smallest element of an empty set.");
     }
 
-    bool elementAt(int index) const { return bits[index]; }
+    bool elementAt(int index) const { return isElement(index); }
 
     int getSize() const { return m_nSize; }
 
@@ -209,12 +289,15 @@ class Set
                   "Increase the number of bits and recompile.\n",
                   NUMBER_BITS_PER_SET, size);
         m_nSize = size;
-        bits.reset();
+        clear();
     }
 
     void print(std::ostream& out) const
     {
-        out << "[Set (" << m_nSize << "): " << bits << "]";
+        out << "[Set (" << m_nSize << "): ";
+        for (int i = NUMBER_BITS_PER_SET - 1; i >= 0; --i)
+            out << (isElement(i) ? '1' : '0');
+        out << "]";
     }
 };
 
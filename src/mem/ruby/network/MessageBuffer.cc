@@ -231,7 +231,7 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
     // Schedule the wakeup
     assert(m_consumer != NULL);
     m_consumer->scheduleEventAbsolute(arrival_time);
-    m_consumer->storeEventInfo(m_vnet_id);
+    m_consumer->storeEventInfo(m_input_link_id, m_vnet_id);
 }
 
 Tick
@@ -91,6 +91,8 @@ class MessageBuffer : public SimObject
     }
 
     bool areNSlotsAvailable(unsigned int n, Tick curTime);
+    // Whether slots are always available, i.e. the buffer is infinite
+    bool isUnbounded() const { return m_max_size == 0; }
     int getPriority() { return m_priority_rank; }
     void setPriority(int rank) { m_priority_rank = rank; }
     void setConsumer(Consumer* consumer)
@@ -73,6 +73,11 @@ Network::Network(const Params *p)
     NodeID local_node_id = 0;
     for (int i = 0; i < MachineType_base_level(MachineType_NUM); ++i) {
         MachineType mach = static_cast<MachineType>(i);
+        fatal_if(MachineType_base_count(mach) > NUMBER_BITS_PER_SET,
+                 "Number of bits(%d) < number of %s controllers(%d). "
+                 "Increase the number of bits and recompile.\n",
+                 NUMBER_BITS_PER_SET, MachineType_to_string(mach),
+                 MachineType_base_count(mach));
         if (localNodeVersions.count(mach)) {
             for (auto &ver : localNodeVersions.at(mach)) {
                 // Get the global ID Ruby will pass around
@@ -365,7 +365,7 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
     NetDest net_msg_dest = net_msg_ptr->getDestination();
 
     // gets all the destinations associated with this message.
-    vector<NodeID> dest_nodes = net_msg_dest.getAllDest();
+    net_msg_dest.getAllDest(m_dest_nodes);
 
     // Number of flits is dependent on the link bandwidth available.
     // This is expressed in terms of bytes/cycle or the flit size
@@ -379,7 +379,7 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
         vnet, oPort->bitWidth());
 
     // loop to convert all multicast messages into unicast messages
-    for (int ctr = 0; ctr < dest_nodes.size(); ctr++) {
+    for (int ctr = 0; ctr < m_dest_nodes.size(); ctr++) {
 
         // this will return a free output virtual channel
         int vc = calculateVC(vnet);
@@ -388,10 +388,10 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
             return false ;
         }
         MsgPtr new_msg_ptr = msg_ptr->clone();
-        NodeID destID = dest_nodes[ctr];
+        NodeID destID = m_dest_nodes[ctr];
 
         Message *new_net_msg_ptr = new_msg_ptr.get();
-        if (dest_nodes.size() > 1) {
+        if (m_dest_nodes.size() > 1) {
             NetDest personal_dest;
             for (int m = 0; m < (int) MachineType_NUM; m++) {
                 if ((destID >= MachineType_base_number((MachineType) m)) &&
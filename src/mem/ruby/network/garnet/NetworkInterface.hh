@@ -281,6 +281,8 @@ class NetworkInterface : public ClockedObject, public Consumer
     std::vector<MessageBuffer *> outNode_ptr;
     // When a vc stays busy for a long time, it indicates a deadlock
     std::vector<int> vc_busy_counter;
+    // Scratch list of destinations reused by flitisizeMessage
+    std::vector<NodeID> m_dest_nodes;
 
     void checkStallQueue();
     bool flitisizeMessage(MsgPtr msg_ptr, int vnet);
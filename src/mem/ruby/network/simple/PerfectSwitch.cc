@@ -55,16 +55,13 @@ PerfectSwitch::PerfectSwitch(SwitchID sid, Switch *sw, uint32_t virt_nets)
     m_round_robin_start = 0;
     m_wakeups_wo_switch = 0;
     m_virtual_networks = virt_nets;
+    m_pending_ports.resize(virt_nets);
 }
 
 void
 PerfectSwitch::init(SimpleNetwork *network_ptr)
 {
     m_network_ptr = network_ptr;
-
-    for (int i = 0;i < m_virtual_networks;++i) {
-        m_pending_message_count.push_back(0);
-    }
 }
 
 void
@@ -73,6 +70,10 @@ PerfectSwitch::addInPort(const vector<MessageBuffer*>& in)
     NodeID port = m_in.size();
     m_in.push_back(in);
 
+    for (auto &pending : m_pending_ports) {
+        pending.resize(m_in.size());
+    }
+
     for (int i = 0; i < in.size(); ++i) {
         if (in[i] != nullptr) {
             in[i]->setConsumer(this);
@@ -111,27 +112,37 @@ PerfectSwitch::operateVnet(int vnet)
         m_round_robin_start = 0;
     }
 
-    if (m_pending_message_count[vnet] > 0) {
-        // for all input ports, use round robin scheduling
-        for (int counter = 0; counter < m_in.size(); counter++) {
-            // Round robin scheduling
-            incoming++;
-            if (incoming >= m_in.size()) {
-                incoming = 0;
-            }
+    // Only visit the input ports that may have a message waiting, in
+    // round robin order starting after the previous start port
+    const ReadyBitmap &pending = m_pending_ports[vnet];
+    int start = incoming + 1;
+    if (start >= m_in.size()) {
+        start = 0;
+    }
 
-            // Is there a message waiting?
-            if (m_in[incoming].size() <= vnet) {
-                continue;
-            }
+    for (int port = pending.next(start); port >= 0;
+         port = pending.next(port + 1)) {
+        operatePort(port, vnet);
+    }
+    for (int port = pending.next(0); port >= 0 && port < start;
+         port = pending.next(port + 1)) {
+        operatePort(port, vnet);
+    }
+}
 
-            MessageBuffer *buffer = m_in[incoming][vnet];
-            if (buffer == nullptr) {
-                continue;
-            }
+void
+PerfectSwitch::operatePort(int incoming, int vnet)
+{
+    assert(m_in[incoming].size() > vnet);
+    MessageBuffer *buffer = m_in[incoming][vnet];
+    assert(buffer != nullptr);
 
-            operateMessageBuffer(buffer, incoming, vnet);
-        }
+    operateMessageBuffer(buffer, incoming, vnet);
+
+    // Messages that are not ready yet keep the port pending; their
+    // arrival already scheduled a wakeup
+    if (buffer->isEmpty()) {
+        m_pending_ports[vnet].clear(incoming);
     }
 }
 
@@ -195,7 +206,7 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int incoming,
         for (int i = 0; i < m_routing_table.size(); i++) {
             // pick the next link to look at
             int link = m_link_order[i].m_link;
-            NetDest dst = m_routing_table[link];
+            const NetDest &dst = m_routing_table[link];
             DPRINTF(RubyNetwork, "dst: %s\n", dst);
 
             if (!msg_dsts.intersectionIsNotEmpty(dst))
@@ -254,7 +265,6 @@ PerfectSwitch::operateMessageBuffer(MessageBuffer *buffer, int incoming,
 
         // Dequeue msg
         buffer->dequeue(current_time);
-        m_pending_message_count[vnet]--;
 
         // Enqueue it - for all outgoing queues
         for (int i=0; i<output_links.size(); i++) {
@@ -307,9 +317,9 @@ PerfectSwitch::wakeup()
 }
 
 void
-PerfectSwitch::storeEventInfo(int info)
+PerfectSwitch::storeEventInfo(int link_id, int vnet)
 {
-    m_pending_message_count[info]++;
+    m_pending_ports[vnet].set(link_id);
 }
 
 void
@@ -42,6 +42,7 @@
 
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/common/TypeDefines.hh"
+#include "mem/ruby/network/simple/ReadyBitmap.hh"
 
 class MessageBuffer;
 class NetDest;
@@ -74,7 +75,7 @@ class PerfectSwitch : public Consumer
     int getOutLinks() const { return m_out.size(); }
 
     void wakeup();
-    void storeEventInfo(int info);
+    void storeEventInfo(int link_id, int vnet);
 
     void clearStats();
     void collateStats();
@@ -86,6 +87,7 @@ class PerfectSwitch : public Consumer
     PerfectSwitch& operator=(const PerfectSwitch& obj);
 
     void operateVnet(int vnet);
+    void operatePort(int incoming, int vnet);
     void operateMessageBuffer(MessageBuffer *b, int incoming, int vnet);
 
     const SwitchID m_switch_id;
@@ -103,7 +105,8 @@ class PerfectSwitch : public Consumer
     int m_wakeups_wo_switch;
 
     SimpleNetwork* m_network_ptr;
-    std::vector<int> m_pending_message_count;
+    // For each vnet, the input ports whose buffers may hold messages
+    std::vector<ReadyBitmap> m_pending_ports;
 };
 
 inline std::ostream&
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_SIMPLE_READYBITMAP_HH__
+#define __MEM_RUBY_NETWORK_SIMPLE_READYBITMAP_HH__
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "base/bitfield.hh"
+
+/**
+ * Bitmap of the input buffers of a switch or throttle that may hold
+ * messages. Buffers mark themselves when a message is enqueued, and
+ * the owner clears the bit once it has drained the buffer, so a wakeup
+ * only has to look at the buffers that have work.
+ */
+class ReadyBitmap
+{
+  public:
+    void
+    resize(int bits)
+    {
+        m_words.resize((bits + 63) / 64, 0);
+        m_bits = bits;
+    }
+
+    int size() const { return m_bits; }
+
+    void
+    set(int i)
+    {
+        assert(i >= 0 && i < m_bits);
+        m_words[i / 64] |= uint64_t(1) << (i % 64);
+    }
+
+    void
+    clear(int i)
+    {
+        assert(i >= 0 && i < m_bits);
+        m_words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+    bool
+    test(int i) const
+    {
+        assert(i >= 0 && i < m_bits);
+        return m_words[i / 64] & (uint64_t(1) << (i % 64));
+    }
+
+    bool
+    any() const
+    {
+        for (uint64_t word : m_words) {
+            if (word)
+                return true;
+        }
+        return false;
+    }
+
+    /** First set bit at or above from, or -1 if there is none. */
+    int
+    next(int from) const
+    {
+        if (from >= m_bits)
+            return -1;
+        int w = from / 64;
+        uint64_t word = m_words[w] & ~mask(from % 64);
+        while (!word) {
+            if (++w == (int)m_words.size())
+                return -1;
+            word = m_words[w];
+        }
+        return w * 64 + ctz64(word);
+    }
+
+    /** Last set bit at or below from, or -1 if there is none. */
+    int
+    prev(int from) const
+    {
+        if (from < 0)
+            return -1;
+        int w = from / 64;
+        uint64_t word = m_words[w] & mask(from % 64 + 1);
+        while (!word) {
+            if (w-- == 0)
+                return -1;
+            word = m_words[w];
+        }
+        return w * 64 + findMsbSet(word);
+    }
+
+  private:
+    std::vector<uint64_t> m_words;
+    int m_bits = 0;
+};
+
+#endif // __MEM_RUBY_NETWORK_SIMPLE_READYBITMAP_HH__
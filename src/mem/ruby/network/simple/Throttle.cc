@@ -32,6 +32,7 @@
 
 #include "base/cast.hh"
 #include "base/cprintf.hh"
+#include "base/intmath.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
 #include "mem/ruby/network/Network.hh"
@@ -64,6 +65,8 @@ Throttle::Throttle(int sID, RubySystem *rs, NodeID node, Cycles link_latency,
 
     m_wakeups_wo_switch = 0;
     m_link_utilization_proxy = 0;
+
+    m_batch_vnet = -1;
 }
 
 void
@@ -83,9 +86,18 @@ Throttle::addLinks(const vector<MessageBuffer*>& in_vec,
 
         // Set consumer and description
         in_ptr->setConsumer(this);
+        in_ptr->setVnet(vnet);
         string desc = "[Queue to Throttle " + to_string(m_switch_id) + " " +
             to_string(m_node) + "]";
     }
+
+    m_active_vnets.resize(m_vnets);
+}
+
+void
+Throttle::storeEventInfo(int link_id, int vnet)
+{
+    m_active_vnets.set(vnet);
 }
 
 void
@@ -93,6 +105,7 @@ Throttle::operateVnet(int vnet, int &bw_remaining, bool &schedule_wakeup,
                       MessageBuffer *in, MessageBuffer *out)
 {
     if (out == nullptr || in == nullptr) {
+        m_active_vnets.clear(vnet);
         return;
     }
 
@@ -141,6 +154,72 @@ Throttle::operateVnet(int vnet, int &bw_remaining, bool &schedule_wakeup,
         // output queue to become available
         schedule_wakeup = true;
     }
+
+    // Messages that are not ready yet keep the vnet active; their
+    // arrival already scheduled a wakeup
+    if (in->isEmpty() && m_units_remaining[vnet] == 0) {
+        m_active_vnets.clear(vnet);
+    }
+}
+
+void
+Throttle::settleBatchedCycles()
+{
+    if (m_batch_vnet < 0) {
+        return;
+    }
+
+    // The skipped cycles each spent the whole link bandwidth on the
+    // message being transmitted on the batched vnet, as its output
+    // buffer always has a free slot
+    uint64_t elapsed = m_switch->curCycle() - m_batch_start;
+    if (elapsed > 1) {
+        int skipped = elapsed - 1;
+        m_units_remaining[m_batch_vnet] -= skipped * getLinkBandwidth();
+        assert(m_units_remaining[m_batch_vnet] > 0);
+        m_link_utilization_proxy += skipped;
+        m_wakeups_wo_switch += skipped;
+    }
+    m_batch_vnet = -1;
+}
+
+Cycles
+Throttle::cyclesToNextWork(Tick current_time)
+{
+    // Find the only vnet with a message in flight. Any other vnet with
+    // work to do needs the bandwidth of the next cycle.
+    int busy = -1;
+    for (int vnet = m_active_vnets.next(0); vnet >= 0;
+         vnet = m_active_vnets.next(vnet + 1)) {
+        if (m_units_remaining[vnet] > 0 && busy < 0) {
+            busy = vnet;
+        } else if (m_units_remaining[vnet] > 0 ||
+                   m_in[vnet]->isReady(current_time)) {
+            return Cycles(1);
+        }
+    }
+
+    if (busy < 0) {
+        return Cycles(1);
+    }
+
+    // The message only gets bandwidth in the cycles its output buffer
+    // has a free slot, which cannot be known in advance unless the
+    // buffer is infinite
+    if (!m_out[busy]->isUnbounded()) {
+        return Cycles(1);
+    }
+
+    // Wake up in the cycle that finishes the transmission, so that any
+    // bandwidth left over in that cycle goes to the next message
+    Cycles cycles(divCeil(m_units_remaining[busy], getLinkBandwidth()));
+    if (cycles > 1) {
+        m_batch_vnet = busy;
+        m_batch_start = m_switch->curCycle();
+    } else {
+        cycles = Cycles(1);
+    }
+    return cycles;
 }
 
 void
@@ -150,6 +229,8 @@ Throttle::wakeup()
     assert(getLinkBandwidth() > 0);
     int bw_remaining = getLinkBandwidth();
 
+    settleBatchedCycles();
+
     m_wakeups_wo_switch++;
     bool schedule_wakeup = false;
 
@@ -163,13 +244,16 @@ Throttle::wakeup()
         iteration_direction = true;
     }
 
+    // Only the vnets with messages in flight or waiting need a look
     if (iteration_direction) {
-        for (int vnet = 0; vnet < m_vnets; ++vnet) {
+        for (int vnet = m_active_vnets.next(0); vnet >= 0;
+             vnet = m_active_vnets.next(vnet + 1)) {
             operateVnet(vnet, bw_remaining, schedule_wakeup,
                         m_in[vnet], m_out[vnet]);
         }
     } else {
-        for (int vnet = m_vnets-1; vnet >= 0; --vnet) {
+        for (int vnet = m_active_vnets.prev(m_vnets - 1); vnet >= 0;
+             vnet = m_active_vnets.prev(vnet - 1)) {
             operateVnet(vnet, bw_remaining, schedule_wakeup,
                         m_in[vnet], m_out[vnet]);
         }
@@ -194,8 +278,11 @@ Throttle::wakeup()
         DPRINTF(RubyNetwork, "%s scheduled again\n", *this);
 
         // We are out of bandwidth for this cycle, so wakeup next
-        // cycle and continue
-        scheduleEvent(Cycles(1));
+        // cycle and continue, or once the message in flight is sent
+        // if that is all there is to do
+        Tick current_time = m_switch->clockEdge();
+        scheduleEvent(bw_remaining == 0 ?
+                      cyclesToNextWork(current_time) : Cycles(1));
     }
 }
 
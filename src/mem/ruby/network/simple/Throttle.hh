@@ -44,6 +44,7 @@
 
 #include "mem/ruby/common/Consumer.hh"
 #include "mem/ruby/network/Network.hh"
+#include "mem/ruby/network/simple/ReadyBitmap.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 class MessageBuffer;
@@ -63,6 +64,7 @@ class Throttle : public Consumer
     void addLinks(const std::vector<MessageBuffer*>& in_vec,
                   const std::vector<MessageBuffer*>& out_vec);
     void wakeup();
+    void storeEventInfo(int link_id, int vnet);
 
     // The average utilization (a fraction) since last clearStats()
     const Stats::Scalar & getUtilization() const
@@ -85,6 +87,8 @@ class Throttle : public Consumer
               int endpoint_bandwidth);
     void operateVnet(int vnet, int &bw_remainin, bool &schedule_wakeup,
                      MessageBuffer *in, MessageBuffer *out);
+    void settleBatchedCycles();
+    Cycles cyclesToNextWork(Tick current_time);
 
     // Private copy constructor and assignment operator
     Throttle(const Throttle& obj);
@@ -94,6 +98,14 @@ class Throttle : public Consumer
     std::vector<MessageBuffer*> m_out;
     unsigned int m_vnets;
     std::vector<int> m_units_remaining;
+    // Virtual networks with messages in flight or waiting to be sent
+    ReadyBitmap m_active_vnets;
+
+    // While a single message is being transmitted and nothing else is
+    // waiting, the wakeups of the following cycles are skipped and the
+    // bandwidth they would have used is accounted for on the next wakeup
+    int m_batch_vnet;
+    Cycles m_batch_start;
 
     const int m_switch_id;
     Switch *m_switch;
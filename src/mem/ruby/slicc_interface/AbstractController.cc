@@ -51,6 +51,7 @@ AbstractController::AbstractController(const Params *p)
     : ClockedObject(p), Consumer(this), m_version(p->version),
       m_clusterID(p->cluster_id),
       m_id(p->system->getRequestorId(this)), m_is_blocking(false),
+      m_functional_indexed(false),
       m_number_of_TBEs(p->number_of_TBEs),
       m_transitions_per_cycle(p->transitions_per_cycle),
       m_buffer_size(p->buffer_size), m_recycle_latency(p->recycle_latency),
@@ -311,6 +312,18 @@ AbstractController::functionalMemoryWrite(PacketPtr pkt)
     return num_functional_writes + 1;
 }
 
+void
+AbstractController::lineAllocated(Addr addr)
+{
+    params()->ruby_system->addLineHolder(addr, this);
+}
+
+void
+AbstractController::lineDeallocated(Addr addr)
+{
+    params()->ruby_system->removeLineHolder(addr, this);
+}
+
 void
 AbstractController::recvTimingResp(PacketPtr pkt)
 {
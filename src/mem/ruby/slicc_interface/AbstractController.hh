@@ -123,6 +123,18 @@ class AbstractController : public ClockedObject, public Consumer
     virtual int functionalWrite(const Addr &addr, PacketPtr) = 0;
     int functionalMemoryWrite(PacketPtr);
 
+    /**
+     * Whether the access permissions of the controller only depend on
+     * caches and TBE tables that report the lines they hold to the
+     * RubySystem. Functional accesses skip indexed controllers that do
+     * not hold the line.
+     */
+    bool isFunctionallyIndexed() const { return m_functional_indexed; }
+    //! Called by the caches and TBE tables of indexed controllers when
+    //! they allocate or deallocate a line.
+    void lineAllocated(Addr addr);
+    void lineDeallocated(Addr addr);
+
     //! Function for enqueuing a prefetch request
     virtual void enqueuePrefetch(const Addr &, const RubyRequestType&)
     { fatal("Prefetches not implemented!");}
@@ -190,6 +202,7 @@ class AbstractController : public ClockedObject, public Consumer
 
     Network *m_net_ptr;
     bool m_is_blocking;
+    bool m_functional_indexed;
     std::map<Addr, MessageBuffer*> m_block_map;
 
     typedef std::vector<MessageBuffer*> MsgVecType;
@@ -50,6 +50,7 @@
 #include "debug/RubyStats.hh"
 #include "mem/cache/replacement_policies/weighted_lru_rp.hh"
 #include "mem/ruby/protocol/AccessPermission.hh"
+#include "mem/ruby/slicc_interface/AbstractController.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 using namespace std;
@@ -300,6 +301,9 @@ CacheMemory::allocate(Addr address, AbstractCacheEntry *entry)
             // replacement policies.
             m_replacementPolicy_ptr->reset(entry->replacementData);
 
+            for (auto cntrl : m_line_holders)
+                cntrl->lineAllocated(address);
+
             return entry;
         }
     }
@@ -318,6 +322,25 @@ CacheMemory::deallocate(Addr address)
     delete entry;
     m_cache[cache_set][way] = NULL;
     m_tag_index.erase(address);
+
+    for (auto cntrl : m_line_holders)
+        cntrl->lineDeallocated(address);
+}
+
+bool
+CacheMemory::canIndexLines() const
+{
+    // The block size is only known to be the Ruby one if it was not set
+    // explicitly, as this may be called before init()
+    return m_block_size == 0 ||
+        m_block_size == (int)RubySystem::getBlockSizeBytes();
+}
+
+void
+CacheMemory::addLineHolder(AbstractController *cntrl)
+{
+    assert(canIndexLines());
+    m_line_holders.push_back(cntrl);
 }
 
 // Returns with the physical address of the conflicting cache line
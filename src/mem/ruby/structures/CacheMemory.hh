@@ -60,6 +60,8 @@
 #include "params/RubyCache.hh"
 #include "sim/sim_object.hh"
 
+class AbstractController;
+
 class CacheMemory : public SimObject
 {
   public:
@@ -104,6 +106,15 @@ class CacheMemory : public SimObject
     // Explicitly free up this address
     void deallocate(Addr address);
 
+    // Whether the lines of this cache can be reported to the line holder
+    // index of the RubySystem, i.e. whether they are Ruby cache lines.
+    bool canIndexLines() const;
+
+    // Report the lines allocated in this cache to the line holder index
+    // of the RubySystem on behalf of the given controller. The cache must
+    // be indexable.
+    void addLineHolder(AbstractController *cntrl);
+
     // Returns with the physical address of the conflicting cache line
     Addr cacheProbe(Addr address) const;
 
@@ -232,6 +243,9 @@ class CacheMemory : public SimObject
      * false.
      */
     bool m_use_occupancy;
+
+    // Controllers whose functional accesses are indexed with this cache
+    std::vector<AbstractController*> m_line_holders;
 };
 
 std::ostream& operator<<(std::ostream& out, const CacheMemory& obj);
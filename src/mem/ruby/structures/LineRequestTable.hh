@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2026 The gem-forge contributors
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_STRUCTURES_LINEREQUESTTABLE_HH__
+#define __MEM_RUBY_STRUCTURES_LINEREQUESTTABLE_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "base/open_hash_map.hh"
+#include "mem/ruby/common/Address.hh"
+
+/**
+ * Table of outstanding requests, kept in FIFO order per cache line.
+ *
+ * The requests live in a slab of slots that is sized up front for the
+ * expected number of outstanding requests, and the requests of a line
+ * are chained through the slots. The line index is an OpenHashMap, so
+ * inserting and retiring requests does not allocate memory unless the
+ * slab has to grow beyond its initial capacity.
+ *
+ * Entries must be default constructible; a freed slot is reset to a
+ * default constructed entry. References to entries are only valid
+ * until the next insertion, as the slab may grow. Callers that run
+ * callbacks which may issue new requests should copy the entry first.
+ */
+template <class Entry>
+class LineRequestTable
+{
+  public:
+    /**
+     * @param capacity Number of requests that can be outstanding
+     *                 before the table grows.
+     */
+    explicit LineRequestTable(int capacity)
+        : lines(capacity), freeHead(-1), numEntries(0)
+    {
+        grow(std::max(capacity, 1));
+    }
+
+    /** Total number of requests in the table. */
+    size_t size() const { return numEntries; }
+    bool empty() const { return numEntries == 0; }
+
+    /** Whether any request is outstanding for the given line. */
+    bool contains(Addr line) const { return lines.count(line); }
+
+    /** Number of requests outstanding for the given line. */
+    int
+    count(Addr line)
+    {
+        auto it = lines.find(line);
+        return it == lines.end() ? 0 : it->second.count;
+    }
+
+    /** Append a request to the list of the given line. */
+    template <typename... Args>
+    Entry &
+    emplace(Addr line, Args&&... args)
+    {
+        if (freeHead < 0)
+            grow(slots.size());
+
+        const int idx = freeHead;
+        Slot &slot = slots[idx];
+        freeHead = slot.next;
+        slot.entry = Entry(std::forward<Args>(args)...);
+        slot.line = line;
+        slot.next = -1;
+
+        auto res = lines.emplace(line, Chain());
+        Chain &chain = res.first->second;
+        if (res.second) {
+            chain.head = idx;
+            slot.head = true;
+        } else {
+            slots[chain.tail].next = idx;
+            slot.head = false;
+        }
+        chain.tail = idx;
+        ++chain.count;
+        ++numEntries;
+        return slot.entry;
+    }
+
+    /** Oldest request of a line that has outstanding requests. */
+    Entry &
+    front(Addr line)
+    {
+        auto it = lines.find(line);
+        assert(it != lines.end());
+        return slots[it->second.head].entry;
+    }
+
+    /** Retire the oldest request of a line. */
+    void
+    popFront(Addr line)
+    {
+        auto it = lines.find(line);
+        assert(it != lines.end());
+        Chain &chain = it->second;
+
+        const int idx = chain.head;
+        Slot &slot = slots[idx];
+        chain.head = slot.next;
+        if (--chain.count == 0)
+            lines.erase(it);
+        else
+            slots[chain.head].head = true;
+
+        slot.entry = Entry();
+        slot.head = false;
+        slot.next = freeHead;
+        freeHead = idx;
+        --numEntries;
+    }
+
+    /**
+     * Find the first request of a line for which the predicate holds.
+     *
+     * @return The request, or nullptr if there is none.
+     */
+    template <class Pred>
+    Entry *
+    findInLine(Addr line, Pred pred)
+    {
+        auto it = lines.find(line);
+        if (it == lines.end())
+            return nullptr;
+        for (int idx = it->second.head; idx >= 0; idx = slots[idx].next) {
+            if (pred(slots[idx].entry))
+                return &slots[idx].entry;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Visit all requests as (line, entry) pairs. The requests of a line
+     * are visited together and in order; lines are visited in no
+     * particular order. The table must not be changed while visiting.
+     */
+    template <class Visitor>
+    void
+    forEach(Visitor visit) const
+    {
+        for (const Slot &first : slots) {
+            if (!first.head)
+                continue;
+            for (const Slot *slot = &first; ;
+                 slot = &slots[slot->next]) {
+                visit(slot->line, slot->entry);
+                if (slot->next < 0)
+                    break;
+            }
+        }
+    }
+
+  private:
+    struct Slot
+    {
+        Entry entry;
+        Addr line = 0;
+        /** Next slot of the line, or of the free list. */
+        int next = -1;
+        /** Whether this is the oldest request of its line. */
+        bool head = false;
+    };
+
+    struct Chain
+    {
+        int head = -1;
+        int tail = -1;
+        int count = 0;
+    };
+
+    /** Add the given number of free slots to the slab. */
+    void
+    grow(size_t extra)
+    {
+        const size_t first = slots.size();
+        slots.resize(first + extra);
+        for (size_t i = slots.size(); i-- > first; ) {
+            slots[i].next = freeHead;
+            freeHead = i;
+        }
+    }
+
+    std::vector<Slot> slots;
+    OpenHashMap<Addr, Chain> lines;
+    /** First free slot, or -1 if the slab is full. */
+    int freeHead;
+    size_t numEntries;
+};
+
+#endif // __MEM_RUBY_STRUCTURES_LINEREQUESTTABLE_HH__
@@ -45,16 +45,21 @@
 #include <unordered_map>
 
 #include "mem/ruby/common/Address.hh"
+#include "mem/ruby/slicc_interface/AbstractController.hh"
 
 template<class ENTRY>
 class TBETable
 {
   public:
     TBETable(int number_of_TBEs)
-        : m_number_of_TBEs(number_of_TBEs)
+        : m_number_of_TBEs(number_of_TBEs), m_line_holder(nullptr)
     {
     }
 
+    // Report the allocated TBEs to the line holder index of the
+    // RubySystem on behalf of the given controller
+    void setLineHolder(AbstractController *cntrl) { m_line_holder = cntrl; }
+
     bool isPresent(Addr address) const;
     void allocate(Addr address);
     void deallocate(Addr address);
@@ -80,6 +85,7 @@ class TBETable
 
   private:
     int m_number_of_TBEs;
+    AbstractController *m_line_holder;
 };
 
 template<class ENTRY>
@@ -107,6 +113,8 @@ TBETable<ENTRY>::allocate(Addr address)
     assert(!isPresent(address));
     assert(m_map.size() < m_number_of_TBEs);
     m_map[address] = ENTRY();
+    if (m_line_holder)
+        m_line_holder->lineAllocated(address);
 }
 
 template<class ENTRY>
@@ -116,6 +124,8 @@ TBETable<ENTRY>::deallocate(Addr address)
     assert(isPresent(address));
     assert(m_map.size() > 0);
     m_map.erase(address);
+    if (m_line_holder)
+        m_line_holder->lineDeallocated(address);
 }
 
 template<class ENTRY>
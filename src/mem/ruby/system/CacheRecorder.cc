@@ -29,23 +29,50 @@
 
 #include "mem/ruby/system/CacheRecorder.hh"
 
+#include <algorithm>
+#include <numeric>
+
+#include "base/intmath.hh"
 #include "debug/RubyCacheTrace.hh"
 #include "mem/ruby/system/RubySystem.hh"
 #include "mem/ruby/system/Sequencer.hh"
 
 using namespace std;
 
-void
-TraceRecord::print(ostream& out) const
+// Blocks that were read only are refetched, all the others are written
+// with their recorded data.
+static bool
+isReadRecord(RubyRequestType type)
+{
+    return type == RubyRequestType_LD || type == RubyRequestType_IFETCH;
+}
+
+static void
+putVarint(vector<uint8_t> &out, uint64_t value)
 {
-    out << "[TraceRecord: Node, " << m_cntrl_id << ", "
-        << m_data_address << ", " << m_pc_address << ", "
-        << m_type << ", Time: " << m_time << "]";
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+static uint64_t
+getVarint(const uint8_t *trace, uint64_t trace_size, uint64_t &pos)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        fatal_if(pos >= trace_size || shift > 63,
+                 "Cache trace is truncated or corrupted\n");
+        uint8_t byte = trace[pos++];
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
 }
 
 CacheRecorder::CacheRecorder()
-    : m_uncompressed_trace(NULL),
-      m_uncompressed_trace_size(0),
+    : m_records_read(0), m_records_flushed(0),
       m_block_size_bytes(RubySystem::getBlockSizeBytes())
 {
 }
@@ -53,13 +80,12 @@ CacheRecorder::CacheRecorder()
 CacheRecorder::CacheRecorder(uint8_t* uncompressed_trace,
                              uint64_t uncompressed_trace_size,
                              std::vector<Sequencer*>& seq_map,
-                             uint64_t block_size_bytes)
-    : m_uncompressed_trace(uncompressed_trace),
-      m_uncompressed_trace_size(uncompressed_trace_size),
-      m_seq_map(seq_map),  m_bytes_read(0), m_records_read(0),
-      m_records_flushed(0), m_block_size_bytes(block_size_bytes)
+                             uint64_t block_size_bytes,
+                             unsigned trace_format)
+    : m_seq_map(seq_map), m_records_read(0), m_records_flushed(0),
+      m_block_size_bytes(block_size_bytes)
 {
-    if (m_uncompressed_trace != NULL) {
+    if (uncompressed_trace != NULL) {
         if (m_block_size_bytes < RubySystem::getBlockSizeBytes()) {
             // Block sizes larger than when the trace was recorded are not
             // supported, as we cannot reliably turn accesses to smaller blocks
@@ -67,138 +93,292 @@ CacheRecorder::CacheRecorder(uint8_t* uncompressed_trace,
             panic("Recorded cache block size (%d) < current block size (%d) !!",
                     m_block_size_bytes, RubySystem::getBlockSizeBytes());
         }
+
+        if (trace_format == 0) {
+            readLegacyTrace(uncompressed_trace, uncompressed_trace_size);
+        } else {
+            fatal_if(trace_format != TraceFormat,
+                     "Unsupported cache trace format %d\n", trace_format);
+            readTrace(uncompressed_trace, uncompressed_trace_size);
+        }
+
+        // The records are decoded, the trace is not needed anymore
+        delete [] uncompressed_trace;
     }
 }
 
 CacheRecorder::~CacheRecorder()
 {
-    if (m_uncompressed_trace != NULL) {
-        delete [] m_uncompressed_trace;
-        m_uncompressed_trace = NULL;
+}
+
+void
+CacheRecorder::appendRecord(int cntrl, Addr data_addr, RubyRequestType type,
+                            const uint8_t *data)
+{
+    m_cntrl_ids.push_back(cntrl);
+    m_addrs.push_back(data_addr);
+    m_types.push_back(type);
+    m_data_offsets.push_back(m_data.size());
+    if (!isReadRecord(type))
+        m_data.insert(m_data.end(), data, data + m_block_size_bytes);
+}
+
+void
+CacheRecorder::readTrace(const uint8_t *trace, uint64_t trace_size)
+{
+    if (trace_size == 0)
+        return;
+
+    uint64_t pos = 0;
+    const uint64_t num_records = getVarint(trace, trace_size, pos);
+    // Every record takes at least three bytes
+    fatal_if(num_records > trace_size / 3,
+             "Cache trace is truncated or corrupted\n");
+
+    vector<int> cntrl_ids(num_records);
+    for (auto &cntrl : cntrl_ids)
+        cntrl = getVarint(trace, trace_size, pos);
+
+    fatal_if(trace_size - pos < num_records,
+             "Cache trace is truncated or corrupted\n");
+    vector<RubyRequestType> types(num_records);
+    for (auto &type : types) {
+        fatal_if(trace[pos] >= RubyRequestType_NUM,
+                 "Invalid request type %d in cache trace\n", trace[pos]);
+        type = RubyRequestType(trace[pos++]);
+    }
+
+    const unsigned block_bits = floorLog2(m_block_size_bytes);
+    vector<Addr> addrs(num_records);
+    Addr block = 0;
+    for (auto &addr : addrs) {
+        // The deltas are zigzag encoded, so that small negative deltas
+        // are small numbers as well
+        const uint64_t value = getVarint(trace, trace_size, pos);
+        block += (value >> 1) ^ -(value & 1);
+        addr = block << block_bits;
+    }
+
+    for (uint64_t i = 0; i < num_records; ++i) {
+        const uint8_t *data = nullptr;
+        if (!isReadRecord(types[i])) {
+            fatal_if(trace_size - pos < m_block_size_bytes,
+                     "Cache trace is truncated or corrupted\n");
+            data = trace + pos;
+            pos += m_block_size_bytes;
+        }
+        appendRecord(cntrl_ids[i], addrs[i], types[i], data);
     }
-    m_seq_map.clear();
 }
 
 void
-CacheRecorder::enqueueNextFlushRequest()
-{
-    if (m_records_flushed < m_records.size()) {
-        TraceRecord* rec = m_records[m_records_flushed];
-        m_records_flushed++;
-        auto req = std::make_shared<Request>(rec->m_data_address,
-                                             m_block_size_bytes, 0,
-                                             Request::funcRequestorId);
-        MemCmd::Command requestType = MemCmd::FlushReq;
-        Packet *pkt = new Packet(req, requestType);
+CacheRecorder::readLegacyTrace(const uint8_t *trace, uint64_t trace_size)
+{
+    const uint64_t record_size = sizeof(TraceRecord) + m_block_size_bytes;
+    for (uint64_t pos = 0; pos + record_size <= trace_size;
+         pos += record_size) {
+        const TraceRecord *rec = (const TraceRecord *)(trace + pos);
+        appendRecord(rec->m_cntrl_id, rec->m_data_address, rec->m_type,
+                     rec->m_data);
+    }
+}
 
-        Sequencer* m_sequencer_ptr = m_seq_map[rec->m_cntrl_id];
-        assert(m_sequencer_ptr != NULL);
-        m_sequencer_ptr->makeRequest(pkt);
+void
+CacheRecorder::makeQueues()
+{
+    if (!m_queues.empty())
+        return;
+
+    // Sequencers stand in for the controllers without any, so several
+    // controllers may share a queue
+    for (auto seq : m_seq_map) {
+        if (m_seq_queues.count(seq))
+            continue;
+        m_seq_queues[seq] = nullptr;
+        m_queues.push_back(ReplayQueue());
+        m_queues.back().sequencer = seq;
+        m_queues.back().next = 0;
+        m_queues.back().outstanding = 0;
+        m_queues.back().buffer.resize(m_block_size_bytes);
+    }
+    for (auto &queue : m_queues)
+        m_seq_queues[queue.sequencer] = &queue;
 
-        DPRINTF(RubyCacheTrace, "Flushing %s\n", *rec);
-    } else {
-        DPRINTF(RubyCacheTrace, "Flushed all %d records\n", m_records_flushed);
+    for (uint64_t rec = 0; rec < m_addrs.size(); ++rec) {
+        fatal_if(m_cntrl_ids[rec] < 0 ||
+                 m_cntrl_ids[rec] >= (int)m_seq_map.size(),
+                 "Cache trace record of unknown controller %d\n",
+                 m_cntrl_ids[rec]);
+        m_seq_queues[m_seq_map[m_cntrl_ids[rec]]]->records.push_back(rec);
     }
 }
 
 void
-CacheRecorder::enqueueNextFetchRequest()
-{
-    if (m_bytes_read < m_uncompressed_trace_size) {
-        TraceRecord* traceRecord = (TraceRecord*) (m_uncompressed_trace +
-                                                                m_bytes_read);
-
-        DPRINTF(RubyCacheTrace, "Issuing %s\n", *traceRecord);
-
-        for (int rec_bytes_read = 0; rec_bytes_read < m_block_size_bytes;
-                rec_bytes_read += RubySystem::getBlockSizeBytes()) {
-            RequestPtr req;
-            MemCmd::Command requestType;
-
-            if (traceRecord->m_type == RubyRequestType_LD) {
-                requestType = MemCmd::ReadReq;
-                req = std::make_shared<Request>(
-                    traceRecord->m_data_address + rec_bytes_read,
-                    RubySystem::getBlockSizeBytes(), 0,
-                                    Request::funcRequestorId);
-            }   else if (traceRecord->m_type == RubyRequestType_IFETCH) {
-                requestType = MemCmd::ReadReq;
-                req = std::make_shared<Request>(
-                        traceRecord->m_data_address + rec_bytes_read,
-                        RubySystem::getBlockSizeBytes(),
-                        Request::INST_FETCH, Request::funcRequestorId);
-            }   else {
-                requestType = MemCmd::WriteReq;
-                req = std::make_shared<Request>(
-                    traceRecord->m_data_address + rec_bytes_read,
-                    RubySystem::getBlockSizeBytes(), 0,
-                                Request::funcRequestorId);
-            }
+CacheRecorder::enqueueNextFlushRequest(Sequencer *seq)
+{
+    if (seq == nullptr) {
+        makeQueues();
+        for (auto &queue : m_queues)
+            issueFlushRequest(queue);
+        return;
+    }
+
+    auto it = m_seq_queues.find(seq);
+    assert(it != m_seq_queues.end());
+    ReplayQueue &queue = *it->second;
+    assert(queue.outstanding > 0);
+    if (--queue.outstanding == 0)
+        issueFlushRequest(queue);
+}
+
+void
+CacheRecorder::issueFlushRequest(ReplayQueue &queue)
+{
+    if (queue.next == queue.records.size()) {
+        DPRINTF(RubyCacheTrace, "Flushed all %d records of %s, %d in "
+                "total\n", queue.records.size(), queue.sequencer->name(),
+                m_records_flushed);
+        return;
+    }
 
-            Packet *pkt = new Packet(req, requestType);
-            pkt->dataStatic(traceRecord->m_data + rec_bytes_read);
+    const uint64_t rec = queue.records[queue.next++];
+    auto req = std::make_shared<Request>(m_addrs[rec],
+                                         m_block_size_bytes, 0,
+                                         Request::funcRequestorId);
+    MemCmd::Command requestType = MemCmd::FlushReq;
+    Packet *pkt = new Packet(req, requestType);
 
-            Sequencer* m_sequencer_ptr = m_seq_map[traceRecord->m_cntrl_id];
-            assert(m_sequencer_ptr != NULL);
-            m_sequencer_ptr->makeRequest(pkt);
+    DPRINTF(RubyCacheTrace, "Flushing %#x of controller %d\n",
+            m_addrs[rec], m_cntrl_ids[rec]);
+
+    queue.outstanding++;
+    m_records_flushed++;
+    queue.sequencer->makeRequest(pkt);
+}
+
+void
+CacheRecorder::enqueueNextFetchRequest(Sequencer *seq)
+{
+    if (seq == nullptr) {
+        makeQueues();
+        for (auto &queue : m_queues)
+            issueFetchRequest(queue);
+        return;
+    }
+
+    auto it = m_seq_queues.find(seq);
+    assert(it != m_seq_queues.end());
+    ReplayQueue &queue = *it->second;
+    assert(queue.outstanding > 0);
+    if (--queue.outstanding == 0)
+        issueFetchRequest(queue);
+}
+
+void
+CacheRecorder::issueFetchRequest(ReplayQueue &queue)
+{
+    if (queue.next == queue.records.size()) {
+        DPRINTF(RubyCacheTrace, "Fetched all %d records of %s, %d in "
+                "total\n", queue.records.size(), queue.sequencer->name(),
+                m_records_read);
+        return;
+    }
+
+    const uint64_t rec = queue.records[queue.next++];
+    const RubyRequestType type = m_types[rec];
+
+    DPRINTF(RubyCacheTrace, "Issuing %s of %#x for controller %d\n",
+            RubyRequestType_to_string(type), m_addrs[rec],
+            m_cntrl_ids[rec]);
+
+    // Read requests only need somewhere to put their data, while write
+    // requests write back the recorded data
+    uint8_t *data = isReadRecord(type) ? queue.buffer.data() :
+                                         &m_data[m_data_offsets[rec]];
+
+    for (int rec_bytes_read = 0; rec_bytes_read < m_block_size_bytes;
+            rec_bytes_read += RubySystem::getBlockSizeBytes()) {
+        RequestPtr req;
+        MemCmd::Command requestType;
+
+        if (type == RubyRequestType_LD) {
+            requestType = MemCmd::ReadReq;
+            req = std::make_shared<Request>(
+                m_addrs[rec] + rec_bytes_read,
+                RubySystem::getBlockSizeBytes(), 0,
+                                Request::funcRequestorId);
+        }   else if (type == RubyRequestType_IFETCH) {
+            requestType = MemCmd::ReadReq;
+            req = std::make_shared<Request>(
+                    m_addrs[rec] + rec_bytes_read,
+                    RubySystem::getBlockSizeBytes(),
+                    Request::INST_FETCH, Request::funcRequestorId);
+        }   else {
+            requestType = MemCmd::WriteReq;
+            req = std::make_shared<Request>(
+                m_addrs[rec] + rec_bytes_read,
+                RubySystem::getBlockSizeBytes(), 0,
+                            Request::funcRequestorId);
         }
 
-        m_bytes_read += (sizeof(TraceRecord) + m_block_size_bytes);
-        m_records_read++;
-    } else {
-        DPRINTF(RubyCacheTrace, "Fetched all %d records\n", m_records_read);
+        Packet *pkt = new Packet(req, requestType);
+        pkt->dataStatic(data + rec_bytes_read);
+
+        queue.outstanding++;
+        queue.sequencer->makeRequest(pkt);
     }
+
+    m_records_read++;
 }
 
 void
 CacheRecorder::addRecord(int cntrl, Addr data_addr, Addr pc_addr,
                          RubyRequestType type, Tick time, DataBlock& data)
 {
-    TraceRecord* rec = (TraceRecord*)malloc(sizeof(TraceRecord) +
-                                            m_block_size_bytes);
-    rec->m_cntrl_id     = cntrl;
-    rec->m_time         = time;
-    rec->m_data_address = data_addr;
-    rec->m_pc_address   = pc_addr;
-    rec->m_type         = type;
-    memcpy(rec->m_data, data.getData(0, m_block_size_bytes),
-           m_block_size_bytes);
-
-    m_records.push_back(rec);
-}
-
-uint64_t
-CacheRecorder::aggregateRecords(uint8_t **buf, uint64_t total_size)
-{
-    std::sort(m_records.begin(), m_records.end(), compareTraceRecords);
-
-    int size = m_records.size();
-    uint64_t current_size = 0;
-    int record_size = sizeof(TraceRecord) + m_block_size_bytes;
-
-    for (int i = 0; i < size; ++i) {
-        // Determine if we need to expand the buffer size
-        if (current_size + record_size > total_size) {
-            uint8_t* new_buf = new (nothrow) uint8_t[total_size * 2];
-            if (new_buf == NULL) {
-                fatal("Unable to allocate buffer of size %s\n",
-                      total_size * 2);
-            }
-            total_size = total_size * 2;
-            uint8_t* old_buf = *buf;
-            memcpy(new_buf, old_buf, current_size);
-            *buf = new_buf;
-            delete [] old_buf;
-        }
+    appendRecord(cntrl, data_addr, type,
+                 data.getData(0, m_block_size_bytes));
+    m_times.push_back(time);
+}
 
-        // Copy the current record into the buffer
-        memcpy(&((*buf)[current_size]), m_records[i], record_size);
-        current_size += record_size;
+void
+CacheRecorder::aggregateRecords(std::vector<uint8_t> &trace)
+{
+    // Replay the most recently accessed blocks first
+    vector<uint64_t> order(m_addrs.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [this](uint64_t rec1, uint64_t rec2)
+                { return m_times[rec1] > m_times[rec2]; });
 
-        free(m_records[i]);
-        m_records[i] = NULL;
+    trace.clear();
+    putVarint(trace, order.size());
+    for (auto rec : order)
+        putVarint(trace, m_cntrl_ids[rec]);
+    for (auto rec : order)
+        trace.push_back(m_types[rec]);
+
+    const unsigned block_bits = floorLog2(m_block_size_bytes);
+    Addr prev_block = 0;
+    for (auto rec : order) {
+        const Addr block = m_addrs[rec] >> block_bits;
+        const int64_t delta = block - prev_block;
+        putVarint(trace, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+        prev_block = block;
+    }
+
+    for (auto rec : order) {
+        if (!isReadRecord(m_types[rec])) {
+            const uint8_t *data = &m_data[m_data_offsets[rec]];
+            trace.insert(trace.end(), data, data + m_block_size_bytes);
+        }
     }
 
-    m_records.clear();
-    return current_size;
+    m_cntrl_ids.clear();
+    m_addrs.clear();
+    m_types.clear();
+    m_times.clear();
+    m_data_offsets.clear();
+    m_data.clear();
+    m_queues.clear();
+    m_seq_queues.clear();
 }
@@ -35,6 +35,7 @@
 #ifndef __MEM_RUBY_SYSTEM_CACHERECORDER_HH__
 #define __MEM_RUBY_SYSTEM_CACHERECORDER_HH__
 
+#include <unordered_map>
 #include <vector>
 
 #include "base/types.hh"
@@ -46,10 +47,10 @@
 class Sequencer;
 
 /*!
- * Class for recording cache contents. Note that the last element of the
- * class is an array of length zero. It is used for creating variable
- * length object, so that while writing the data to a file one does not
- * need to copy the meta data and the actual data separately.
+ * Layout of the records in cache traces written before the columnar
+ * format was introduced. Note that the last element of the class is an
+ * array of length zero, holding the data of the block. These traces can
+ * still be read when restoring old checkpoints.
  */
 class TraceRecord {
   public:
@@ -59,71 +60,113 @@ class TraceRecord {
     Addr m_pc_address;
     RubyRequestType m_type;
     uint8_t m_data[0];
-
-    void print(std::ostream& out) const;
 };
 
+/*!
+ * Records the contents of the caches, to write them back to memory
+ * before taking a checkpoint and to warm up the caches when restoring
+ * it.
+ *
+ * The records are kept in columns, and are stored in the checkpoint
+ * the same way: the controllers, then the request types, then the block
+ * addresses as deltas to the previous one, and finally the data of the
+ * blocks that were writable. Read only blocks do not need any data, as
+ * they are refetched from memory anyway.
+ *
+ * Records of different sequencers are replayed in parallel, while the
+ * records of each sequencer are replayed one after the other.
+ */
 class CacheRecorder
 {
   public:
+    /** Version of the trace format written by aggregateRecords(). */
+    static const unsigned TraceFormat = 1;
+
     CacheRecorder();
     ~CacheRecorder();
 
     CacheRecorder(uint8_t* uncompressed_trace,
                   uint64_t uncompressed_trace_size,
                   std::vector<Sequencer*>& SequencerMap,
-                  uint64_t block_size_bytes);
+                  uint64_t block_size_bytes,
+                  unsigned trace_format = TraceFormat);
     void addRecord(int cntrl, Addr data_addr, Addr pc_addr,
                    RubyRequestType type, Tick time, DataBlock& data);
 
-    uint64_t aggregateRecords(uint8_t **data, uint64_t size);
+    /** Encode the records, from the most recently accessed one. */
+    void aggregateRecords(std::vector<uint8_t> &data);
 
     /*!
      * Function for flushing the memory contents of the caches to the
      * main memory. It goes through the recorded contents of the caches,
      * and issues flush requests. Except for the first one, a flush request
-     * is issued only after the previous one has completed. This currently
-     * requires use of MOESI Hammer protocol since only that protocol
-     * supports flush requests.
+     * of a sequencer is issued only after its previous one has completed.
+     * This currently requires use of MOESI Hammer protocol since only that
+     * protocol supports flush requests.
+     *
+     * @param seq Sequencer that completed its previous request, or
+     *            nullptr to start flushing on all the sequencers.
      */
-    void enqueueNextFlushRequest();
+    void enqueueNextFlushRequest(Sequencer *seq = nullptr);
 
     /*!
      * Function for fetching warming up the memory and the caches. It goes
      * through the recorded contents of the caches, as available in the
      * checkpoint and issues fetch requests. Except for the first one, a
-     * fetch request is issued only after the previous one has completed.
-     * It should be possible to use this with any protocol.
+     * fetch request of a sequencer is issued only after its previous one
+     * has completed. It should be possible to use this with any protocol.
+     *
+     * @param seq Sequencer that completed its previous request, or
+     *            nullptr to start fetching on all the sequencers.
      */
-    void enqueueNextFetchRequest();
+    void enqueueNextFetchRequest(Sequencer *seq = nullptr);
 
   private:
     // Private copy constructor and assignment operator
     CacheRecorder(const CacheRecorder& obj);
     CacheRecorder& operator=(const CacheRecorder& obj);
 
-    std::vector<TraceRecord*> m_records;
-    uint8_t* m_uncompressed_trace;
-    uint64_t m_uncompressed_trace_size;
+    /** Append a record, with the data of the block if it is written. */
+    void appendRecord(int cntrl, Addr data_addr, RubyRequestType type,
+                      const uint8_t *data);
+
+    void readTrace(const uint8_t *trace, uint64_t trace_size);
+    void readLegacyTrace(const uint8_t *trace, uint64_t trace_size);
+
+    /** Sort the records of each sequencer in their replay queue. */
+    void makeQueues();
+
+    /** Records of a sequencer, replayed one after the other. */
+    struct ReplayQueue
+    {
+        Sequencer *sequencer;
+        std::vector<uint64_t> records;
+        uint64_t next;
+        /** Requests of the record being replayed still outstanding. */
+        unsigned outstanding;
+        /** Where the data of read requests is stored. */
+        std::vector<uint8_t> buffer;
+    };
+
+    void issueFlushRequest(ReplayQueue &queue);
+    void issueFetchRequest(ReplayQueue &queue);
+
+    // Records, one entry per record in each column
+    std::vector<int> m_cntrl_ids;
+    std::vector<Addr> m_addrs;
+    std::vector<RubyRequestType> m_types;
+    /** Last access to the block, only known while recording. */
+    std::vector<Tick> m_times;
+    /** Offset of the data of writable blocks in m_data. */
+    std::vector<uint64_t> m_data_offsets;
+    std::vector<uint8_t> m_data;
+
     std::vector<Sequencer*> m_seq_map;
-    uint64_t m_bytes_read;
+    std::vector<ReplayQueue> m_queues;
+    std::unordered_map<Sequencer*, ReplayQueue*> m_seq_queues;
     uint64_t m_records_read;
     uint64_t m_records_flushed;
     uint64_t m_block_size_bytes;
 };
 
-inline bool
-compareTraceRecords(const TraceRecord* n1, const TraceRecord* n2)
-{
-    return n1->m_time > n2->m_time;
-}
-
-inline std::ostream&
-operator<<(std::ostream& out, const TraceRecord& obj)
-{
-    obj.print(out);
-    out << std::flush;
-    return out;
-}
-
 #endif //__MEM_RUBY_SYSTEM_CACHERECORDER_HH__
@@ -156,6 +156,7 @@ GPUCoalescer::GPUCoalescer(const Params *p)
       issueEvent([this]{ completeIssue(); }, "Issue coalesced request",
                  false, Event::Progress_Event_Pri),
       uncoalescedTable(this),
+      coalescedTable(p->max_outstanding_requests),
       deadlockCheckEvent([this]{ wakeup(); }, "GPUCoalescer deadlock check"),
       gmTokenPort(name() + ".gmTokenPort", this)
 {
@@ -204,17 +205,15 @@ void
 GPUCoalescer::wakeup()
 {
     Cycles current_time = curCycle();
-    for (auto& requestList : coalescedTable) {
-        for (auto& req : requestList.second) {
-            if (current_time - req->getIssueTime() > m_deadlock_threshold) {
-                std::stringstream ss;
-                printRequestTable(ss);
-                warn("GPUCoalescer %d Possible deadlock detected!\n%s\n",
-                     m_version, ss.str());
-                panic("Aborting due to deadlock!\n");
-            }
+    coalescedTable.forEach([&](Addr line, CoalescedRequest *req) {
+        if (current_time - req->getIssueTime() > m_deadlock_threshold) {
+            std::stringstream ss;
+            printRequestTable(ss);
+            warn("GPUCoalescer %d Possible deadlock detected!\n%s\n",
+                 m_version, ss.str());
+            panic("Aborting due to deadlock!\n");
         }
-    }
+    });
 
     Tick tick_threshold = cyclesToTicks(m_deadlock_threshold);
     uncoalescedTable.checkDeadlock(tick_threshold);
@@ -232,21 +231,19 @@ GPUCoalescer::printRequestTable(std::stringstream& ss)
     ss << "Printing out " << coalescedTable.size()
        << " outstanding requests in the coalesced table\n";
 
-    for (auto& requestList : coalescedTable) {
-        for (auto& request : requestList.second) {
-            ss << "\tAddr: " << printAddress(requestList.first) << "\n"
-               << "\tInstruction sequence number: "
-               << request->getSeqNum() << "\n"
-               << "\t\tType: "
-               << RubyRequestType_to_string(request->getRubyType()) << "\n"
-               << "\t\tNumber of associated packets: "
-               << request->getPackets().size() << "\n"
-               << "\t\tIssue time: "
-               << request->getIssueTime() * clockPeriod() << "\n"
-               << "\t\tDifference from current tick: "
-               << (curCycle() - request->getIssueTime()) * clockPeriod();
-        }
-    }
+    coalescedTable.forEach([&](Addr line, CoalescedRequest *request) {
+        ss << "\tAddr: " << printAddress(line) << "\n"
+           << "\tInstruction sequence number: "
+           << request->getSeqNum() << "\n"
+           << "\t\tType: "
+           << RubyRequestType_to_string(request->getRubyType()) << "\n"
+           << "\t\tNumber of associated packets: "
+           << request->getPackets().size() << "\n"
+           << "\t\tIssue time: "
+           << request->getIssueTime() * clockPeriod() << "\n"
+           << "\t\tDifference from current tick: "
+           << (curCycle() - request->getIssueTime()) * clockPeriod();
+    });
 
     // print out packets waiting to be issued in uncoalesced table
     uncoalescedTable.printRequestTable(ss);
@@ -332,21 +329,19 @@ GPUCoalescer::writeCallback(Addr address,
                          bool isRegion)
 {
     assert(address == makeLineAddress(address));
-    assert(coalescedTable.count(address));
+    assert(coalescedTable.contains(address));
 
-    auto crequest = coalescedTable.at(address).front();
+    auto crequest = coalescedTable.front(address);
 
     hitCallback(crequest, mach, data, true, crequest->getIssueTime(),
                 forwardRequestTime, firstResponseTime, isRegion);
 
     // remove this crequest in coalescedTable
     delete crequest;
-    coalescedTable.at(address).pop_front();
+    coalescedTable.popFront(address);
 
-    if (coalescedTable.at(address).empty()) {
-        coalescedTable.erase(address);
-    } else {
-        auto nextRequest = coalescedTable.at(address).front();
+    if (coalescedTable.contains(address)) {
+        auto nextRequest = coalescedTable.front(address);
         issueRequest(nextRequest);
     }
 }
@@ -419,9 +414,9 @@ GPUCoalescer::readCallback(Addr address,
                         bool isRegion)
 {
     assert(address == makeLineAddress(address));
-    assert(coalescedTable.count(address));
+    assert(coalescedTable.contains(address));
 
-    auto crequest = coalescedTable.at(address).front();
+    auto crequest = coalescedTable.front(address);
     fatal_if(crequest->getRubyType() != RubyRequestType_LD,
              "readCallback received non-read type response\n");
 
@@ -432,18 +427,16 @@ GPUCoalescer::readCallback(Addr address,
                     forwardRequestTime, firstResponseTime, isRegion);
 
         delete crequest;
-        coalescedTable.at(address).pop_front();
-        if (coalescedTable.at(address).empty()) {
+        coalescedTable.popFront(address);
+        if (!coalescedTable.contains(address)) {
             break;
         }
 
-        crequest = coalescedTable.at(address).front();
+        crequest = coalescedTable.front(address);
     }
 
-    if (coalescedTable.at(address).empty()) {
-        coalescedTable.erase(address);
-    } else {
-        auto nextRequest = coalescedTable.at(address).front();
+    if (coalescedTable.contains(address)) {
+        auto nextRequest = coalescedTable.front(address);
         issueRequest(nextRequest);
     }
 }
@@ -604,16 +597,12 @@ GPUCoalescer::coalescePacket(PacketPtr pkt)
 
     // If the packet has the same line address as a request already in the
     // coalescedTable and has the same sequence number, it can be coalesced.
-    if (coalescedTable.count(line_addr)) {
-        // Search for a previous coalesced request with the same seqNum.
-        auto& creqQueue = coalescedTable.at(line_addr);
-        auto citer = std::find_if(creqQueue.begin(), creqQueue.end(),
-            [&](CoalescedRequest* c) { return c->getSeqNum() == seqNum; }
-        );
-        if (citer != creqQueue.end()) {
-            (*citer)->insertPacket(pkt);
-            return true;
-        }
+    // Search for a previous coalesced request with the same seqNum.
+    CoalescedRequest **creq_ptr = coalescedTable.findInLine(line_addr,
+        [&](CoalescedRequest* c) { return c->getSeqNum() == seqNum; });
+    if (creq_ptr) {
+        (*creq_ptr)->insertPacket(pkt);
+        return true;
     }
 
     if (m_outstanding_count < m_max_outstanding_requests) {
@@ -627,11 +616,10 @@ GPUCoalescer::coalescePacket(PacketPtr pkt)
         creq->setRubyType(getRequestType(pkt));
         creq->setIssueTime(curCycle());
 
-        if (!coalescedTable.count(line_addr)) {
+        if (!coalescedTable.contains(line_addr)) {
             // If there is no outstanding request for this line address,
             // create a new coalecsed request and issue it immediately.
-            auto reqList = std::deque<CoalescedRequest*> { creq };
-            coalescedTable.insert(std::make_pair(line_addr, reqList));
+            coalescedTable.emplace(line_addr, creq);
 
             DPRINTF(GPUCoalescer, "Issued req type %s seqNum %d\n",
                     RubyRequestType_to_string(creq->getRubyType()), seqNum);
@@ -640,7 +628,7 @@ GPUCoalescer::coalescePacket(PacketPtr pkt)
             // The request is for a line address that is already outstanding
             // but for a different instruction. Add it as a new request to be
             // issued when the current outstanding request is completed.
-            coalescedTable.at(line_addr).push_back(creq);
+            coalescedTable.emplace(line_addr, creq);
             DPRINTF(GPUCoalescer, "found address 0x%X with new seqNum %d\n",
                     line_addr, seqNum);
         }
@@ -750,9 +738,9 @@ GPUCoalescer::atomicCallback(Addr address,
                              const DataBlock& data)
 {
     assert(address == makeLineAddress(address));
-    assert(coalescedTable.count(address));
+    assert(coalescedTable.contains(address));
 
-    auto crequest = coalescedTable.at(address).front();
+    auto crequest = coalescedTable.front(address);
 
     fatal_if((crequest->getRubyType() != RubyRequestType_ATOMIC &&
               crequest->getRubyType() != RubyRequestType_ATOMIC_RETURN &&
@@ -763,12 +751,10 @@ GPUCoalescer::atomicCallback(Addr address,
                 crequest->getIssueTime(), Cycles(0), Cycles(0), false);
 
     delete crequest;
-    coalescedTable.at(address).pop_front();
+    coalescedTable.popFront(address);
 
-    if (coalescedTable.at(address).empty()) {
-        coalescedTable.erase(address);
-    } else {
-        auto nextRequest = coalescedTable.at(address).front();
+    if (coalescedTable.contains(address)) {
+        auto nextRequest = coalescedTable.front(address);
         issueRequest(nextRequest);
     }
 }
@@ -47,6 +47,7 @@
 #include "mem/ruby/protocol/RubyAccessMode.hh"
 #include "mem/ruby/protocol/RubyRequestType.hh"
 #include "mem/ruby/protocol/SequencerRequestType.hh"
+#include "mem/ruby/structures/LineRequestTable.hh"
 #include "mem/ruby/system/Sequencer.hh"
 #include "mem/token_port.hh"
 
@@ -419,7 +420,7 @@ class GPUCoalescer : public RubyPort
     // maximum size is equal to the maximum outstanding requests for a CU
     // (typically the number of blocks in TCP). If there are duplicates of
     // an address, the are serviced in age order.
-    std::map<Addr, std::deque<CoalescedRequest*>> coalescedTable;
+    LineRequestTable<CoalescedRequest*> coalescedTable;
 
     // a map btw an instruction sequence number and PendingWriteInst
     // this is used to do a final call back for each write when it is
@@ -152,6 +152,9 @@ RubySystem::registerRequestorIDs()
 
         // Create helper vectors for each network to iterate over.
         netCntrls[network_id].push_back(cntrl);
+        cntrlToNetwork[cntrl] = network_id;
+        if (!cntrl->isFunctionallyIndexed())
+            netUnindexedCntrls[network_id].push_back(cntrl);
     }
 
     // Default all other requestor IDs to network 0
@@ -162,6 +165,67 @@ RubySystem::registerRequestorIDs()
     }
 }
 
+RubySystem::LineHolderSet::Holder *
+RubySystem::LineHolderSet::find(AbstractController *cntrl)
+{
+    for (size_t i = 0; i < numInline; ++i) {
+        if (inlineHolders[i].first == cntrl)
+            return &inlineHolders[i];
+    }
+    for (auto &holder : overflow) {
+        if (holder.first == cntrl)
+            return &holder;
+    }
+    return nullptr;
+}
+
+void
+RubySystem::LineHolderSet::add(AbstractController *cntrl)
+{
+    if (Holder *holder = find(cntrl)) {
+        ++holder->second;
+    } else if (numInline < NumInline) {
+        inlineHolders[numInline++] = Holder(cntrl, 1);
+    } else {
+        overflow.emplace_back(cntrl, 1);
+    }
+}
+
+bool
+RubySystem::LineHolderSet::remove(AbstractController *cntrl)
+{
+    Holder *holder = find(cntrl);
+    assert(holder && holder->second > 0);
+    if (--holder->second > 0)
+        return false;
+
+    // Keep the holders packed, filling the hole with the last one
+    if (!overflow.empty()) {
+        *holder = overflow.back();
+        overflow.pop_back();
+    } else {
+        *holder = inlineHolders[--numInline];
+        inlineHolders[numInline] = Holder();
+    }
+    return size() == 0;
+}
+
+void
+RubySystem::addLineHolder(Addr line_addr, AbstractController *cntrl)
+{
+    lineHolders[line_addr].add(cntrl);
+}
+
+void
+RubySystem::removeLineHolder(Addr line_addr, AbstractController *cntrl)
+{
+    auto it = lineHolders.find(line_addr);
+    assert(it != lineHolders.end());
+
+    if (it->second.remove(cntrl))
+        lineHolders.erase(it);
+}
+
 RubySystem::~RubySystem()
 {
     delete m_profiler;
@@ -170,7 +234,8 @@ RubySystem::~RubySystem()
 void
 RubySystem::makeCacheRecorder(uint8_t *uncompressed_trace,
                               uint64_t cache_trace_size,
-                              uint64_t block_size_bytes)
+                              uint64_t block_size_bytes,
+                              unsigned cache_trace_format)
 {
     vector<Sequencer*> sequencer_map;
     Sequencer* sequencer_ptr = NULL;
@@ -197,7 +262,8 @@ RubySystem::makeCacheRecorder(uint8_t *uncompressed_trace,
 
     // Create the CacheRecorder and record the cache trace
     m_cache_recorder = new CacheRecorder(uncompressed_trace, cache_trace_size,
-                                         sequencer_map, block_size_bytes);
+                                         sequencer_map, block_size_bytes,
+                                         cache_trace_format);
 }
 
 void
@@ -207,7 +273,8 @@ RubySystem::memWriteback()
 
     // Make the trace so we know what to write back.
     DPRINTF(RubyCacheTrace, "Recording Cache Trace\n");
-    makeCacheRecorder(NULL, 0, getBlockSizeBytes());
+    makeCacheRecorder(NULL, 0, getBlockSizeBytes(),
+                      CacheRecorder::TraceFormat);
     for (int cntrl = 0; cntrl < m_abs_cntrl_vec.size(); cntrl++) {
         m_abs_cntrl_vec[cntrl]->recordCacheTrace(cntrl, m_cache_recorder);
     }
@@ -273,7 +340,7 @@ RubySystem::memWriteback()
 }
 
 void
-RubySystem::writeCompressedTrace(uint8_t *raw_data, string filename,
+RubySystem::writeCompressedTrace(const uint8_t *raw_data, string filename,
                                  uint64_t uncompressed_trace_size)
 {
     // Create the checkpoint file for the memory
@@ -298,7 +365,6 @@ RubySystem::writeCompressedTrace(uint8_t *raw_data, string filename,
     if (gzclose(compressedMemory)) {
         fatal("Close failed on memory trace file '%s'\n", filename);
     }
-    delete[] raw_data;
 }
 
 void
@@ -318,14 +384,16 @@ RubySystem::serialize(CheckpointOut &cp) const
     }
 
     // Aggregate the trace entries together into a single array
-    uint8_t *raw_data = new uint8_t[4096];
-    uint64_t cache_trace_size = m_cache_recorder->aggregateRecords(&raw_data,
-                                                                 4096);
+    vector<uint8_t> raw_data;
+    m_cache_recorder->aggregateRecords(raw_data);
+    uint64_t cache_trace_size = raw_data.size();
     string cache_trace_file = name() + ".cache.gz";
-    writeCompressedTrace(raw_data, cache_trace_file, cache_trace_size);
+    writeCompressedTrace(raw_data.data(), cache_trace_file, cache_trace_size);
 
+    unsigned cache_trace_format = CacheRecorder::TraceFormat;
     SERIALIZE_SCALAR(cache_trace_file);
     SERIALIZE_SCALAR(cache_trace_size);
+    SERIALIZE_SCALAR(cache_trace_format);
 }
 
 void
@@ -386,6 +454,9 @@ RubySystem::unserialize(CheckpointIn &cp)
 
     UNSERIALIZE_SCALAR(cache_trace_file);
     UNSERIALIZE_SCALAR(cache_trace_size);
+    // Checkpoints without a format use the original trace records
+    unsigned cache_trace_format = 0;
+    UNSERIALIZE_OPT_SCALAR(cache_trace_format);
     cache_trace_file = cp.getCptDir() + "/" + cache_trace_file;
 
     readCompressedTrace(cache_trace_file, uncompressed_trace,
@@ -394,7 +465,8 @@ RubySystem::unserialize(CheckpointIn &cp)
     m_systems_to_warmup++;
 
     // Create the cache recorder that will hang around until startup.
-    makeCacheRecorder(uncompressed_trace, cache_trace_size, block_size_bytes);
+    makeCacheRecorder(uncompressed_trace, cache_trace_size, block_size_bytes,
+                      cache_trace_format);
 }
 
 void
@@ -499,9 +571,17 @@ RubySystem::functionalRead(PacketPtr pkt)
     AbstractController *ctrl_rw = nullptr;
     AbstractController *ctrl_backing_store = nullptr;
 
+    // Only the controllers that may hold the line have to be asked for
+    // their permissions, all the others do not have it. They all start
+    // out as invalid, and the ones asked are counted by their answer.
+    int num_controllers = netCntrls[request_net_id].size();
+    num_invalid += num_controllers;
+
     // In this loop we count the number of controllers that have the given
     // address in read only, read write and busy states.
-    for (auto& cntrl : netCntrls[request_net_id]) {
+    forEachFunctionalCntrl(line_address, request_net_id,
+                           [&](AbstractController *cntrl) {
+        num_invalid--;
         access_perm = cntrl-> getAccessPermission(line_address);
         if (access_perm == AccessPermission_Read_Only){
             num_ro++;
@@ -527,7 +607,7 @@ RubySystem::functionalRead(PacketPtr pkt)
         else if (access_perm == AccessPermission_Invalid ||
                  access_perm == AccessPermission_NotPresent)
             num_invalid++;
-    }
+    });
 
     // This if case is meant to capture what happens in a Broadcast/Snoop
     // protocol where the block does not exist in the cache hierarchy. You
@@ -537,7 +617,6 @@ RubySystem::functionalRead(PacketPtr pkt)
     // The reason is because the Backing_Store memory could easily be stale, if
     // there are copies floating around the cache hierarchy, so you want to read
     // it only if it's not in the cache hierarchy at all.
-    int num_controllers = netCntrls[request_net_id].size();
     if (num_invalid == (num_controllers - 1) && num_backing_store == 1) {
         DPRINTF(RubySystem, "only copy in Backing_Store memory, read from it\n");
         ctrl_backing_store->functionalRead(line_address, pkt);
@@ -609,15 +688,25 @@ RubySystem::functionalWrite(PacketPtr pkt)
     int request_net_id = requestorToNetwork[pkt->requestorId()];
     assert(netCntrls.count(request_net_id));
 
-    for (auto& cntrl : netCntrls[request_net_id]) {
-        num_functional_writes += cntrl->functionalWriteBuffers(pkt);
-
+    // Only the controllers that may hold the line can have it in a
+    // valid state.
+    forEachFunctionalCntrl(line_addr, request_net_id,
+                           [&](AbstractController *cntrl) {
         access_perm = cntrl->getAccessPermission(line_addr);
         if (access_perm != AccessPermission_Invalid &&
             access_perm != AccessPermission_NotPresent) {
             num_functional_writes +=
                 cntrl->functionalWrite(line_addr, pkt);
         }
+    });
+
+    // Messages in flight and pending sequencer requests are not indexed,
+    // so this part of a functional write still visits every controller of
+    // the network. Protocol messages do not expose a generic address, and
+    // DMA messages and requests may cover several lines, so they cannot be
+    // filed under a single line.
+    for (auto& cntrl : netCntrls[request_net_id]) {
+        num_functional_writes += cntrl->functionalWriteBuffers(pkt);
 
         // Also updates requests pending in any sequencer associated
         // with the controller
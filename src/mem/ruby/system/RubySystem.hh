@@ -35,9 +35,13 @@
 #ifndef __MEM_RUBY_SYSTEM_RUBYSYSTEM_HH__
 #define __MEM_RUBY_SYSTEM_RUBYSYSTEM_HH__
 
+#include <array>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "base/callback.hh"
+#include "base/open_hash_map.hh"
 #include "base/output.hh"
 #include "mem/packet.hh"
 #include "mem/ruby/profiler/Profiler.hh"
@@ -99,6 +103,17 @@ class RubySystem : public ClockedObject
     void registerMachineID(const MachineID& mach_id, Network* network);
     void registerRequestorIDs();
 
+    /**
+     * Track which controllers may hold a line. Caches and TBE tables of
+     * controllers that are functionally indexed report their allocations
+     * here, so that functional accesses only have to query the holders
+     * of a line and the controllers that are not indexed. A controller
+     * is added once per structure allocating the line, and removed as
+     * many times.
+     */
+    void addLineHolder(Addr line_addr, AbstractController *cntrl);
+    void removeLineHolder(Addr line_addr, AbstractController *cntrl);
+
     bool eventQueueEmpty() { return eventq->empty(); }
     void enqueueRubyEvent(Tick tick)
     {
@@ -114,15 +129,48 @@ class RubySystem : public ClockedObject
 
     void makeCacheRecorder(uint8_t *uncompressed_trace,
                            uint64_t cache_trace_size,
-                           uint64_t block_size_bytes);
+                           uint64_t block_size_bytes,
+                           unsigned cache_trace_format);
 
     static void readCompressedTrace(std::string filename,
                                     uint8_t *&raw_data,
                                     uint64_t &uncompressed_trace_size);
-    static void writeCompressedTrace(uint8_t *raw_data, std::string file,
+    static void writeCompressedTrace(const uint8_t *raw_data,
+                                     std::string file,
                                      uint64_t uncompressed_trace_size);
 
     void processRubyEvent();
+
+    /**
+     * Call a function on each controller of a network that has to be
+     * queried by a functional access to a line, once per controller.
+     * These are the controllers that are not indexed, and the indexed
+     * ones holding the line. The function must not change the index.
+     */
+    template <typename F>
+    void
+    forEachFunctionalCntrl(Addr line_addr, unsigned network_id, F f)
+    {
+        auto unindexed = netUnindexedCntrls.find(network_id);
+        if (unindexed != netUnindexedCntrls.end()) {
+            for (auto cntrl : unindexed->second)
+                f(cntrl);
+        }
+
+        auto it = lineHolders.find(line_addr);
+        if (it == lineHolders.end())
+            return;
+
+        const LineHolderSet &holders = it->second;
+        for (size_t i = 0; i < holders.size(); ++i) {
+            AbstractController *cntrl = holders[i].first;
+            auto net = cntrlToNetwork.find(cntrl);
+            assert(net != cntrlToNetwork.end());
+            if (net->second == network_id)
+                f(cntrl);
+        }
+    }
+
   private:
     // configuration parameters
     static bool m_randomization;
@@ -145,6 +193,48 @@ class RubySystem : public ClockedObject
     std::unordered_map<RequestorID, unsigned> requestorToNetwork;
     std::unordered_map<unsigned, std::vector<AbstractController*>> netCntrls;
 
+    /** Controllers of each network that are not functionally indexed. */
+    std::unordered_map<unsigned, std::vector<AbstractController*>>
+        netUnindexedCntrls;
+    std::unordered_map<AbstractController*, unsigned> cntrlToNetwork;
+
+    /**
+     * The controllers holding a line, each with the number of its
+     * structures allocating the line. The first few holders are stored
+     * inline, so that tracking a line does not allocate memory.
+     */
+    class LineHolderSet
+    {
+      public:
+        typedef std::pair<AbstractController*, unsigned> Holder;
+
+        void add(AbstractController *cntrl);
+
+        /** @return Whether no controller holds the line anymore. */
+        bool remove(AbstractController *cntrl);
+
+        size_t size() const { return numInline + overflow.size(); }
+
+        const Holder &
+        operator[](size_t idx) const
+        {
+            return idx < NumInline ? inlineHolders[idx]
+                                   : overflow[idx - NumInline];
+        }
+
+      private:
+        static const size_t NumInline = 4;
+
+        Holder *find(AbstractController *cntrl);
+
+        std::array<Holder, NumInline> inlineHolders;
+        size_t numInline = 0;
+        std::vector<Holder> overflow;
+    };
+
+    /** Controllers that may hold each line, see addLineHolder(). */
+    OpenHashMap<Addr, LineHolderSet> lineHolders;
+
   public:
     Profiler* m_profiler;
     CacheRecorder* m_cache_recorder;
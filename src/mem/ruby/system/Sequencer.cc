@@ -68,7 +68,8 @@ RubySequencerParams::create()
 }
 
 Sequencer::Sequencer(const Params *p)
-    : RubyPort(p), m_IncompleteTimes(MachineType_NUM),
+    : RubyPort(p), m_RequestTable(p->max_outstanding_requests),
+      m_IncompleteTimes(MachineType_NUM),
       deadlockCheckEvent([this]{ wakeup(); }, "Sequencer deadlock check")
 {
     m_outstanding_count = 0;
@@ -164,25 +165,20 @@ Sequencer::wakeup()
     Cycles current_time = curCycle();
 
     // Check across all outstanding requests
-    int total_outstanding = 0;
-
-    for (const auto &table_entry : m_RequestTable) {
-        for (const auto &seq_req : table_entry.second) {
-            if (current_time - seq_req.issue_time < m_deadlock_threshold)
-                continue;
-
-            panic("Possible Deadlock detected. Aborting!\n version: %d "
-                  "request.paddr: 0x%x m_readRequestTable: %d current time: "
-                  "%u issue_time: %d difference: %d\n", m_version,
-                  seq_req.pkt->getAddr(), table_entry.second.size(),
-                  current_time * clockPeriod(), seq_req.issue_time
-                  * clockPeriod(), (current_time * clockPeriod())
-                  - (seq_req.issue_time * clockPeriod()));
-        }
-        total_outstanding += table_entry.second.size();
-    }
+    m_RequestTable.forEach([&](Addr line, const SequencerRequest &seq_req) {
+        if (current_time - seq_req.issue_time < m_deadlock_threshold)
+            return;
+
+        panic("Possible Deadlock detected. Aborting!\n version: %d "
+              "request.paddr: 0x%x m_readRequestTable: %d current time: "
+              "%u issue_time: %d difference: %d\n", m_version,
+              seq_req.pkt->getAddr(), m_RequestTable.count(line),
+              current_time * clockPeriod(), seq_req.issue_time
+              * clockPeriod(), (current_time * clockPeriod())
+              - (seq_req.issue_time * clockPeriod()));
+    });
 
-    assert(m_outstanding_count == total_outstanding);
+    assert(m_outstanding_count == (int)m_RequestTable.size());
 
     if (m_outstanding_count > 0) {
         // If there are still outstanding requests, keep checking
@@ -195,12 +191,10 @@ Sequencer::functionalWrite(Packet *func_pkt)
 {
     int num_written = RubyPort::functionalWrite(func_pkt);
 
-    for (const auto &table_entry : m_RequestTable) {
-        for (const auto& seq_req : table_entry.second) {
-            if (seq_req.functionalWrite(func_pkt))
-                ++num_written;
-        }
-    }
+    m_RequestTable.forEach([&](Addr line, const SequencerRequest &seq_req) {
+        if (seq_req.functionalWrite(func_pkt))
+            ++num_written;
+    });
 
     return num_written;
 }
@@ -248,13 +242,13 @@ Sequencer::insertRequest(PacketPtr pkt, RubyRequestType primary_type,
 
     Addr line_addr = makeLineAddress(pkt->getAddr());
     // Check if there is any outstanding request for the same cache line.
-    auto &seq_req_list = m_RequestTable[line_addr];
+    bool aliased = m_RequestTable.contains(line_addr);
     // Create a default entry
-    seq_req_list.emplace_back(pkt, primary_type,
+    m_RequestTable.emplace(line_addr, pkt, primary_type,
         secondary_type, curCycle());
     m_outstanding_count++;
 
-    if (seq_req_list.size() > 1) {
+    if (aliased) {
         return RequestStatus_Aliased;
     }
 
@@ -354,8 +348,7 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
     // to this cache line when response for the write comes back
     //
     assert(address == makeLineAddress(address));
-    assert(m_RequestTable.find(address) != m_RequestTable.end());
-    auto &seq_req_list = m_RequestTable[address];
+    assert(m_RequestTable.contains(address));
 
     // Perform hitCallback on every cpu request made to this cache block while
     // ruby request was outstanding. Since only 1 ruby request was made,
@@ -363,8 +356,10 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
     bool ruby_request = true;
     int aliased_stores = 0;
     int aliased_loads = 0;
-    while (!seq_req_list.empty()) {
-        SequencerRequest &seq_req = seq_req_list.front();
+    while (m_RequestTable.contains(address)) {
+        // Copy the request, the callbacks may issue new requests that
+        // grow the table and invalidate references into it
+        SequencerRequest seq_req = m_RequestTable.front(address);
         if (ruby_request) {
             assert(seq_req.m_type != RubyRequestType_LD);
             assert(seq_req.m_type != RubyRequestType_Load_Linked);
@@ -426,12 +421,7 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
                         initialRequestTime, forwardRequestTime,
                         firstResponseTime);
         }
-        seq_req_list.pop_front();
-    }
-
-    // free all outstanding requests corresponding to this address
-    if (seq_req_list.empty()) {
-        m_RequestTable.erase(address);
+        m_RequestTable.popFront(address);
     }
 }
 
@@ -447,16 +437,17 @@ Sequencer::readCallback(Addr address, DataBlock& data,
     // or end of the corresponding list.
     //
     assert(address == makeLineAddress(address));
-    assert(m_RequestTable.find(address) != m_RequestTable.end());
-    auto &seq_req_list = m_RequestTable[address];
+    assert(m_RequestTable.contains(address));
 
     // Perform hitCallback on every cpu request made to this cache block while
     // ruby request was outstanding. Since only 1 ruby request was made,
     // profile the ruby latency once.
     bool ruby_request = true;
     int aliased_loads = 0;
-    while (!seq_req_list.empty()) {
-        SequencerRequest &seq_req = seq_req_list.front();
+    while (m_RequestTable.contains(address)) {
+        // Copy the request, the callbacks may issue new requests that
+        // grow the table and invalidate references into it
+        SequencerRequest seq_req = m_RequestTable.front(address);
         if (ruby_request) {
             assert((seq_req.m_type == RubyRequestType_LD) ||
                    (seq_req.m_type == RubyRequestType_Load_Linked) ||
@@ -481,12 +472,7 @@ Sequencer::readCallback(Addr address, DataBlock& data,
         hitCallback(&seq_req, data, true, mach, externalHit,
                     initialRequestTime, forwardRequestTime,
                     firstResponseTime);
-        seq_req_list.pop_front();
-    }
-
-    // free all outstanding requests corresponding to this address
-    if (seq_req_list.empty()) {
-        m_RequestTable.erase(address);
+        m_RequestTable.popFront(address);
     }
 }
 
@@ -558,10 +544,10 @@ Sequencer::hitCallback(SequencerRequest* srequest, DataBlock& data,
     if (RubySystem::getWarmupEnabled()) {
         assert(pkt->req);
         delete pkt;
-        rs->m_cache_recorder->enqueueNextFetchRequest();
+        rs->m_cache_recorder->enqueueNextFetchRequest(this);
     } else if (RubySystem::getCooldownEnabled()) {
         delete pkt;
-        rs->m_cache_recorder->enqueueNextFlushRequest();
+        rs->m_cache_recorder->enqueueNextFlushRequest(this);
     } else {
         ruby_hit_callback(pkt);
         testDrainComplete();
@@ -736,16 +722,18 @@ Sequencer::issueRequest(PacketPtr pkt, RubyRequestType secondary_type)
     m_mandatory_q_ptr->enqueue(msg, clockEdge(), latency);
 }
 
-template <class KEY, class VALUE>
 std::ostream &
-operator<<(ostream &out, const std::unordered_map<KEY, VALUE> &map)
+operator<<(ostream &out, const LineRequestTable<SequencerRequest> &table)
 {
-    for (const auto &table_entry : map) {
-        out << "[ " << table_entry.first << " =";
-        for (const auto &seq_req : table_entry.second) {
-            out << " " << RubyRequestType_to_string(seq_req.m_second_type);
-        }
-    }
+    bool first = true;
+    Addr prev_line = 0;
+    table.forEach([&](Addr line, const SequencerRequest &seq_req) {
+        if (first || line != prev_line)
+            out << "[ " << line << " =";
+        out << " " << RubyRequestType_to_string(seq_req.m_second_type);
+        first = false;
+        prev_line = line;
+    });
     out << " ]";
 
     return out;
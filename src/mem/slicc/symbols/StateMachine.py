@@ -66,6 +66,15 @@ python_class_map = {
                     "Cycles":"Cycles",
                    }
 
+# Types of machine members that either report the lines they hold to the
+# RubySystem, or that the access permissions of a machine cannot depend
+# on. Machines with members of any other type are queried by every
+# functional access.
+functionally_indexed_types = ("CacheMemory", "TBETable", "MessageBuffer",
+                              "Sequencer", "HTMSequencer", "GPUCoalescer",
+                              "VIPERCoalescer", "DMASequencer",
+                              "RubyPrefetcher", "TimerTable")
+
 class StateMachine(Symbol):
     def __init__(self, symtab, ident, location, pairs, config_parameters):
         super(StateMachine, self).__init__(symtab, ident, location, pairs)
@@ -155,6 +164,15 @@ class StateMachine(Symbol):
         self.symtab.registerSym(str(func), func)
         self.functions.append(func)
 
+    def isFunctionallyIndexed(self):
+        types = [ param.type_ast.type for param in self.config_parameters ]
+        types += [ var.type for var in self.objects ]
+        for type in types:
+            if not type.isPrimitive and not type.isEnumeration and \
+               type.ident not in functionally_indexed_types:
+                return False
+        return True
+
     def addObject(self, obj):
         self.symtab.registerSym(str(obj), obj)
         self.objects.append(obj)
@@ -226,7 +244,7 @@ class StateMachine(Symbol):
         self.printControllerPython(path)
         self.printControllerHH(path)
         self.printControllerCC(path, includes)
-        self.printCSwitch(path)
+        self.printCSwitch(path, includes)
         self.printCWakeup(path, includes)
 
     def printControllerPython(self, path):
@@ -585,6 +603,29 @@ if (m_${{param.ident}}_ptr != NULL) {
 }
 ''')
 
+        #
+        # Register the caches with the line holder index of the RubySystem
+        # if the access permissions only depend on caches and TBEs.
+        # Only register them once all of them are known to be indexable,
+        # as the controller falls back to being queried otherwise.
+        #
+        if self.isFunctionallyIndexed():
+            caches = [ param for param in self.config_parameters
+                       if param.type_ast.type.ident == "CacheMemory" ]
+            code('m_functional_indexed = true;')
+            for param in caches:
+                code('''
+if (!m_${{param.ident}}_ptr->canIndexLines()) {
+    m_functional_indexed = false;
+}''')
+            if caches:
+                code('if (m_functional_indexed) {')
+                code.indent()
+                for param in caches:
+                    code('m_${{param.ident}}_ptr->addLineHolder(this);')
+                code.dedent()
+                code('}')
+
         code('''
 
 for (int state = 0; state < ${ident}_State_NUM; state++) {
@@ -677,6 +718,13 @@ $c_ident::init()
                         comment = "Type %s default" % vtype.ident
                         code('*$vid = ${{vtype["default"]}}; // $comment')
 
+                    if vtype.ident == "TBETable" and \
+                       self.isFunctionallyIndexed():
+                        code('''
+if (m_functional_indexed) {
+    $vid->setLineHolder(this);
+}''')
+
         # Set the prefetchers
         code()
         for prefetcher in self.prefetchers:
@@ -1014,74 +1062,6 @@ $c_ident::recordCacheTrace(int cntrl, CacheRecorder* tr)
         code.dedent()
         code('''
 }
-
-// Actions
-''')
-        if self.TBEType != None and self.EntryType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                 continue
-
-                code('''
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    try {
-       ${{action["c_code"]}}
-    } catch (const RejectException & e) {
-       fatal("Error in action ${{ident}}:${{action.ident}}: "
-             "executed a peek statement with the wrong message "
-             "type specified. ");
-    }
-}
-
-''')
-        elif self.TBEType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                 continue
-
-                code('''
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
-}
-
-''')
-        elif self.EntryType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                 continue
-
-                code('''
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
-}
-
-''')
-        else:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                 continue
-
-                code('''
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
-}
-
 ''')
         for func in self.functions:
             code(func.generateCode())
@@ -1264,7 +1244,84 @@ ${ident}_Controller::wakeup()
 
         code.write(path, "%s_Wakeup.cc" % self.ident)
 
-    def printCSwitch(self, path):
+    def printActions(self, code):
+        '''Output the actions, in the same file as the transitions so
+        that they can be inlined into the transitions using them'''
+
+        ident = self.ident
+        c_ident = "%s_Controller" % self.ident
+
+        code('''
+// Actions
+''')
+        if self.TBEType != None and self.EntryType != None:
+            for action in self.actions.values():
+                if "c_code" not in action:
+                 continue
+
+                code('''
+/** \\brief ${{action.desc}} */
+void
+$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
+{
+    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
+    try {
+       ${{action["c_code"]}}
+    } catch (const RejectException & e) {
+       fatal("Error in action ${{ident}}:${{action.ident}}: "
+             "executed a peek statement with the wrong message "
+             "type specified. ");
+    }
+}
+
+''')
+        elif self.TBEType != None:
+            for action in self.actions.values():
+                if "c_code" not in action:
+                 continue
+
+                code('''
+/** \\brief ${{action.desc}} */
+void
+$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, Addr addr)
+{
+    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
+    ${{action["c_code"]}}
+}
+
+''')
+        elif self.EntryType != None:
+            for action in self.actions.values():
+                if "c_code" not in action:
+                 continue
+
+                code('''
+/** \\brief ${{action.desc}} */
+void
+$c_ident::${{action.ident}}(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
+{
+    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
+    ${{action["c_code"]}}
+}
+
+''')
+        else:
+            for action in self.actions.values():
+                if "c_code" not in action:
+                 continue
+
+                code('''
+/** \\brief ${{action.desc}} */
+void
+$c_ident::${{action.ident}}(Addr addr)
+{
+    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
+    ${{action["c_code"]}}
+}
+
+''')
+
+    def printCSwitch(self, path, includes):
         '''Output switch statement for transition table'''
 
         code = self.symtab.codeFormatter()
@@ -1274,23 +1331,73 @@ ${ident}_Controller::wakeup()
 // Auto generated C++ code started by $__file__:$__line__
 // ${ident}: ${{self.short}}
 
+#include <sys/types.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+
+''')
+
+        # See printControllerCC() for why BoolVec.hh comes first
+        code('''
+#include "mem/ruby/common/BoolVec.hh"
 
+''')
+        code('''
+#include "base/compiler.hh"
+#include "base/cprintf.hh"
 #include "base/logging.hh"
 #include "base/trace.hh"
-#include "debug/ProtocolTrace.hh"
-#include "debug/RubyGenerated.hh"
+
+''')
+        # The actions are in this file as well, see printActions()
+        for f in sorted(self.debug_flags | set(['ProtocolTrace'])):
+            code('#include "debug/${{f}}.hh"')
+        code('''
+#include "mem/ruby/network/Network.hh"
 #include "mem/ruby/protocol/${ident}_Controller.hh"
 #include "mem/ruby/protocol/${ident}_Event.hh"
 #include "mem/ruby/protocol/${ident}_State.hh"
 #include "mem/ruby/protocol/Types.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
+''')
+        for include_path in includes:
+            code('#include "${{include_path}}"')
+
+        code('''
+
+using namespace std;
+''')
+
+        seen_types = set()
+        for var in self.objects:
+            if var.type.ident not in seen_types and not var.type.isPrimitive:
+                code('#include "mem/ruby/protocol/${{var.type.c_ident}}.hh"')
+            seen_types.add(var.type.ident)
+
+        code('''
+
 #define HASH_FUN(state, event)  ((int(state)*${ident}_Event_NUM)+int(event))
 
 #define GET_TRANSITION_COMMENT() (${ident}_transitionComment.str())
 #define CLEAR_TRANSITION_COMMENT() (${ident}_transitionComment.str(""))
 
+#ifndef NDEBUG
+#define APPEND_TRANSITION_COMMENT(str) (${ident}_transitionComment << str)
+#else
+#define APPEND_TRANSITION_COMMENT(str) do {} while (0)
+#endif
+''')
+
+        self.printActions(code)
+
+        code('''
+
 TransitionResult
 ${ident}_Controller::doTransition(${ident}_Event event,
 ''')
@@ -1407,7 +1514,6 @@ ${ident}_Controller::doTransitionWorker(${ident}_Event event,
         code('''
                                         Addr addr)
 {
-    switch(HASH_FUN(state, event)) {
 ''')
 
         # This map will allow suppress generating duplicate code
@@ -1496,21 +1602,56 @@ if (!checkResourceAvailable(%s_RequestType_%s, addr)) {
 
             cases[case].append(case_string)
 
+        # Dispatch through a table mapping each state and event to the
+        # unique code block of the transition, with 0 for the invalid
+        # ones. The table is much smaller than the code of all the
+        # transitions, and the switch only has one case per code block.
+        case_ids = {}
+        for case_id,transitions in enumerate(cases.values()):
+            for trans in transitions:
+                case_ids[trans] = case_id + 1
+
+        case_type = "uint8_t" if len(cases) < 256 else "uint16_t"
+        code('''
+    static constexpr $case_type
+    transitionCases[${ident}_State_NUM * ${ident}_Event_NUM] = {
+''')
+        code.indent()
+        code.indent()
+        for state in self.states.values():
+            row = []
+            for event in self.events.values():
+                trans = "%s_State_%s, %s_Event_%s" % \
+                    (self.ident, state.ident, self.ident, event.ident)
+                row.append(str(case_ids.get(trans, 0)))
+            code('// ${{state.ident}}')
+            for i in range(0, len(row), 16):
+                code('${{", ".join(row[i:i + 16])}},')
+        code.dedent()
+        code('''
+};
+
+switch (transitionCases[HASH_FUN(state, event)]) {
+''')
+
         # Walk through all of the unique code blocks and spit out the
         # corresponding case statement elements
         for case,transitions in cases.items():
-            # Iterative over all the multiple transitions that share
-            # the same code
+            # Name the transitions that share the same code
             for trans in transitions:
-                code('  case HASH_FUN($trans):')
+                code('  // $trans')
+            code('  case ${{case_ids[transitions[0]]}}:')
             code('    $case\n')
 
         code('''
-      default:
-        panic("Invalid transition\\n"
-              "%s time: %d addr: %#x event: %s state: %s\\n",
-              name(), curCycle(), addr, event, state);
-    }
+  default:
+    panic("Invalid transition\\n"
+          "%s time: %d addr: %#x event: %s state: %s\\n",
+          name(), curCycle(), addr, event, state);
+}
+''')
+        code.dedent()
+        code('''
 
     return TransitionResult_Valid;
 }
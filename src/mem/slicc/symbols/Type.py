@@ -242,29 +242,37 @@ $klass ${{self.c_ident}}$parent
             code.dedent()
         code('}')
 
-        # ******** Copy constructor ********
+        # ******** Copy and move constructors ********
+        # Construct the members directly from the ones of the other
+        # object, rather than default constructing and then assigning
+        # them, so that copying a message costs a single copy of each
+        # field
         if not self.isGlobal:
             code('${{self.c_ident}}(const ${{self.c_ident}}&other)')
 
+            inits = []
             # Call superclass constructor
             if "interface" in self:
-                code('    : ${{self["interface"]}}(other)')
-
-            code('{')
-            code.indent()
-
+                inits.append('%s(other)' % self["interface"])
             for dm in self.data_members.values():
-                code('m_${{dm.ident}} = other.m_${{dm.ident}};')
+                inits.append('m_%s(other.m_%s)' % (dm.ident, dm.ident))
 
-            code.dedent()
+            if inits:
+                code('    : ' + (',\n      '.join(inits)))
+
+            code('{')
             code('}')
         else:
             code('${{self.c_ident}}(const ${{self.c_ident}}&) = default;')
 
-        # ******** Assignment operator ********
+        code('${{self.c_ident}}(${{self.c_ident}}&&) = default;')
+
+        # ******** Assignment operators ********
 
         code('${{self.c_ident}}')
         code('&operator=(const ${{self.c_ident}}&) = default;')
+        code('${{self.c_ident}}')
+        code('&operator=(${{self.c_ident}}&&) = default;')
 
         # ******** Full init constructor ********
         if not self.isGlobal:
@@ -42,6 +42,8 @@
 
 #include "mem/snoop_filter.hh"
 
+#include <algorithm>
+
 #include "base/logging.hh"
 #include "base/trace.hh"
 #include "debug/SnoopFilter.hh"
@@ -49,12 +51,100 @@
 
 const int SnoopFilter::SNOOP_MASK_SIZE;
 
+SnoopFilter::SnoopFilter(const SnoopFilterParams *p)
+    : SimObject(p),
+      assoc(p->assoc),
+      numSets(std::max<unsigned>(1, p->max_capacity /
+                                 p->system->cacheLineSize() / p->assoc)),
+      sets(numSets), numEntries(0),
+      linesize(p->system->cacheLineSize()), lookupLatency(p->lookup_latency),
+      maxEntryCount(p->max_capacity / p->system->cacheLineSize())
+{
+    fatal_if(assoc == 0, "The snoop filter associativity must be positive");
+}
+
+Addr
+SnoopFilter::getLineAddr(const Packet* cpkt) const
+{
+    Addr line_addr = cpkt->getBlockAddr(linesize);
+    if (cpkt->isSecure()) {
+        line_addr |= LineSecure;
+    }
+    return line_addr;
+}
+
+SnoopFilter::SnoopEntry*
+SnoopFilter::findEntry(Addr line_addr)
+{
+    const Addr blk_addr = line_addr / linesize;
+    SnoopEntry* set = sets[blk_addr % numSets].get();
+    if (set) {
+        for (unsigned way = 0; way < assoc; ++way) {
+            if (set[way].valid && set[way].lineAddr == line_addr)
+                return &set[way];
+        }
+    }
+
+    if (!overflowEntries.empty()) {
+        auto it = overflowEntries.find(line_addr);
+        if (it != overflowEntries.end())
+            return &it->second;
+    }
+
+    return nullptr;
+}
+
+SnoopFilter::SnoopEntry*
+SnoopFilter::allocateEntry(Addr line_addr)
+{
+    assert(!findEntry(line_addr));
+    ++numEntries;
+
+    const Addr blk_addr = line_addr / linesize;
+    std::unique_ptr<SnoopEntry[]>& set = sets[blk_addr % numSets];
+    if (!set) {
+        set.reset(new SnoopEntry[assoc]());
+    }
+
+    SnoopEntry* sf_entry = nullptr;
+    for (unsigned way = 0; way < assoc; ++way) {
+        if (!set[way].valid) {
+            sf_entry = &set[way];
+            break;
+        }
+    }
+
+    if (!sf_entry) {
+        // A sparse directory would have to back-invalidate one of the
+        // lines in the set here. Until the caches above can take such an
+        // invalidation, keep the line on the side. The total number of
+        // lines is still bounded by max_capacity.
+        setOverflows++;
+        DPRINTF(SnoopFilter, "%s:   Set full, overflowing %#x\n",
+                __func__, line_addr);
+        sf_entry = &overflowEntries[line_addr];
+    }
+
+    sf_entry->lineAddr = line_addr;
+    sf_entry->valid = true;
+    sf_entry->item = SnoopItem();
+    return sf_entry;
+}
+
 void
-SnoopFilter::eraseIfNullEntry(SnoopFilterCache::iterator& sf_it)
+SnoopFilter::eraseIfNullEntry(SnoopEntry* sf_entry)
 {
-    SnoopItem& sf_item = sf_it->second;
+    SnoopItem& sf_item = sf_entry->item;
     if ((sf_item.requested | sf_item.holder).none()) {
-        cachedLocations.erase(sf_it);
+        assert(numEntries > 0);
+        --numEntries;
+        const Addr blk_addr = sf_entry->lineAddr / linesize;
+        const SnoopEntry* set = sets[blk_addr % numSets].get();
+        if (set && sf_entry >= set && sf_entry < set + assoc) {
+            sf_entry->valid = false;
+        } else {
+            overflowEntries.erase(sf_entry->lineAddr);
+        }
         DPRINTF(SnoopFilter, "%s:   Removed SF entry.\n",
                 __func__);
     }
@@ -70,13 +160,10 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const ResponsePort&
     // check if the packet came from a cache
     bool allocate = !cpkt->req->isUncacheable() && cpu_side_port.isSnooping()
         && cpkt->fromCache();
-    Addr line_addr = cpkt->getBlockAddr(linesize);
-    if (cpkt->isSecure()) {
-        line_addr |= LineSecure;
-    }
+    Addr line_addr = getLineAddr(cpkt);
     SnoopMask req_port = portToMask(cpu_side_port);
-    reqLookupResult.it = cachedLocations.find(line_addr);
-    bool is_hit = (reqLookupResult.it != cachedLocations.end());
+    reqLookupResult.entry = findEntry(line_addr);
+    bool is_hit = (reqLookupResult.entry != nullptr);
 
     // If the snoop filter has no entry, and we should not allocate,
     // do not create a new snoop filter entry, simply return a NULL
@@ -84,12 +171,11 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const ResponsePort&
     if (!is_hit && !allocate)
         return snoopDown(lookupLatency);
 
-    // If no hit in snoop filter create a new element and update iterator
+    // If no hit in snoop filter create a new element and update the entry
     if (!is_hit) {
-        reqLookupResult.it =
-            cachedLocations.emplace(line_addr, SnoopItem()).first;
+        reqLookupResult.entry = allocateEntry(line_addr);
     }
-    SnoopItem& sf_item = reqLookupResult.it->second;
+    SnoopItem& sf_item = reqLookupResult.entry->item;
     SnoopMask interested = sf_item.holder | sf_item.requested;
 
     // Store unmodified value of snoop filter item in temp storage in
@@ -110,8 +196,7 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const ResponsePort&
 
     // If we are not allocating, we are done
     if (!allocate)
-        return snoopSelected(maskToPortList(interested & ~req_port),
-                             lookupLatency);
+        return snoopSelected(interested & ~req_port, lookupLatency);
 
     if (cpkt->needsResponse()) {
         if (!cpkt->cacheResponding()) {
@@ -150,32 +235,33 @@ SnoopFilter::lookupRequest(const Packet* cpkt, const ResponsePort&
         }
     }
 
-    return snoopSelected(maskToPortList(interested & ~req_port), lookupLatency);
+    return snoopSelected(interested & ~req_port, lookupLatency);
 }
 
 void
 SnoopFilter::finishRequest(bool will_retry, Addr addr, bool is_secure)
 {
-    if (reqLookupResult.it != cachedLocations.end()) {
+    if (reqLookupResult.entry) {
         // since we rely on the caller, do a basic check to ensure
         // that finishRequest is being called following lookupRequest
         Addr line_addr = (addr & ~(Addr(linesize - 1)));
         if (is_secure) {
             line_addr |= LineSecure;
         }
-        assert(reqLookupResult.it->first == line_addr);
+        assert(reqLookupResult.entry->lineAddr == line_addr);
         if (will_retry) {
             SnoopItem retry_item = reqLookupResult.retryItem;
             // Undo any changes made in lookupRequest to the snoop filter
             // entry if the request will come again. retryItem holds
             // the previous value of the snoopfilter entry.
-            reqLookupResult.it->second = retry_item;
+            reqLookupResult.entry->item = retry_item;
 
             DPRINTF(SnoopFilter, "%s:   restored SF value %x.%x\n",
                     __func__,  retry_item.requested, retry_item.holder);
         }
 
-        eraseIfNullEntry(reqLookupResult.it);
+        eraseIfNullEntry(reqLookupResult.entry);
+        reqLookupResult.entry = nullptr;
     }
 }
 
@@ -186,14 +272,11 @@ SnoopFilter::lookupSnoop(const Packet* cpkt)
 
     assert(cpkt->isRequest());
 
-    Addr line_addr = cpkt->getBlockAddr(linesize);
-    if (cpkt->isSecure()) {
-        line_addr |= LineSecure;
-    }
-    auto sf_it = cachedLocations.find(line_addr);
-    bool is_hit = (sf_it != cachedLocations.end());
+    Addr line_addr = getLineAddr(cpkt);
+    SnoopEntry* sf_entry = findEntry(line_addr);
+    bool is_hit = (sf_entry != nullptr);
 
-    panic_if(!is_hit && (cachedLocations.size() >= maxEntryCount),
+    panic_if(!is_hit && (numEntries >= maxEntryCount),
              "snoop filter exceeded capacity of %d cache blocks\n",
              maxEntryCount);
 
@@ -203,7 +286,7 @@ SnoopFilter::lookupSnoop(const Packet* cpkt)
     if (!is_hit)
         return snoopDown(lookupLatency);
 
-    SnoopItem& sf_item = sf_it->second;
+    SnoopItem& sf_item = sf_entry->item;
 
     SnoopMask interested = (sf_item.holder | sf_item.requested);
 
@@ -233,10 +316,10 @@ SnoopFilter::lookupSnoop(const Packet* cpkt)
         sf_item.holder = 0;
         DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
                 __func__, sf_item.requested, sf_item.holder);
-        eraseIfNullEntry(sf_it);
+        eraseIfNullEntry(sf_entry);
     }
 
-    return snoopSelected(maskToPortList(interested), lookupLatency);
+    return snoopSelected(interested, lookupLatency);
 }
 
 void
@@ -257,13 +340,14 @@ SnoopFilter::updateSnoopResponse(const Packet* cpkt,
         return;
     }
 
-    Addr line_addr = cpkt->getBlockAddr(linesize);
-    if (cpkt->isSecure()) {
-        line_addr |= LineSecure;
-    }
+    Addr line_addr = getLineAddr(cpkt);
     SnoopMask rsp_mask = portToMask(rsp_port);
     SnoopMask req_mask = portToMask(req_port);
-    SnoopItem& sf_item = cachedLocations[line_addr];
+    SnoopEntry* sf_entry = findEntry(line_addr);
+    if (!sf_entry) {
+        sf_entry = allocateEntry(line_addr);
+    }
+    SnoopItem& sf_item = sf_entry->item;
 
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
             __func__,  sf_item.requested, sf_item.holder);
@@ -306,12 +390,9 @@ SnoopFilter::updateSnoopForward(const Packet* cpkt,
     assert(cpkt->isResponse());
     assert(cpkt->cacheResponding());
 
-    Addr line_addr = cpkt->getBlockAddr(linesize);
-    if (cpkt->isSecure()) {
-        line_addr |= LineSecure;
-    }
-    auto sf_it = cachedLocations.find(line_addr);
-    bool is_hit = sf_it != cachedLocations.end();
+    Addr line_addr = getLineAddr(cpkt);
+    SnoopEntry* sf_entry = findEntry(line_addr);
+    bool is_hit = (sf_entry != nullptr);
 
     // Nothing to do if it is not a hit
     if (!is_hit)
@@ -321,7 +402,7 @@ SnoopFilter::updateSnoopForward(const Packet* cpkt,
     // Modified state, and we know that there are no other copies, or
     // they will all be invalidated imminently
     if (!cpkt->hasSharers()) {
-        SnoopItem& sf_item = sf_it->second;
+        SnoopItem& sf_item = sf_entry->item;
 
         DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
                 __func__, sf_item.requested, sf_item.holder);
@@ -329,7 +410,7 @@ SnoopFilter::updateSnoopForward(const Packet* cpkt,
         DPRINTF(SnoopFilter, "%s:   new SF value %x.%x\n",
                 __func__, sf_item.requested, sf_item.holder);
 
-        eraseIfNullEntry(sf_it);
+        eraseIfNullEntry(sf_entry);
     }
 }
 
@@ -348,16 +429,13 @@ SnoopFilter::updateResponse(const Packet* cpkt, const ResponsePort&
         return;
 
     // next check if we actually allocated an entry
-    Addr line_addr = cpkt->getBlockAddr(linesize);
-    if (cpkt->isSecure()) {
-        line_addr |= LineSecure;
-    }
-    auto sf_it = cachedLocations.find(line_addr);
-    if (sf_it == cachedLocations.end())
+    Addr line_addr = getLineAddr(cpkt);
+    SnoopEntry* sf_entry = findEntry(line_addr);
+    if (!sf_entry)
         return;
 
     SnoopMask response_mask = portToMask(cpu_side_port);
-    SnoopItem& sf_item = sf_it->second;
+    SnoopItem& sf_item = sf_entry->item;
 
     DPRINTF(SnoopFilter, "%s:   old SF value %x.%x\n",
             __func__,  sf_item.requested, sf_item.holder);
@@ -376,7 +454,7 @@ SnoopFilter::updateResponse(const Packet* cpkt, const ResponsePort&
         if (cpkt->isInvalidate()) {
             sf_item.holder &= ~response_mask;
         }
-        eraseIfNullEntry(sf_it);
+        eraseIfNullEntry(sf_entry);
     } else {
         // Any other response implies that a cache above will have the
         // block.
@@ -419,6 +497,11 @@ SnoopFilter::regStats()
         .name(name() + ".hit_multi_snoops")
         .desc("Number of snoops hitting in the snoop filter with multiple "\
               "(>1) holders of the requested data.");
+
+    setOverflows
+        .name(name() + ".set_overflows")
+        .desc("Number of lines allocated in the overflow table because "\
+              "their set of the snoop filter was full.");
 }
 
 SnoopFilter *
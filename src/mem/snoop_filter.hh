@@ -44,8 +44,10 @@
 #define __MEM_SNOOP_FILTER_HH__
 
 #include <bitset>
+#include <memory>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "mem/packet.hh"
 #include "mem/port.hh"
@@ -82,6 +84,14 @@
  *     upper cache dropped a line, making the snoop filter pessimistic for now
  * (4) ordering: there is no single point of order in the system.  Instead,
  *     requesting MSHRs track order between local requests and remote snoops
+ *
+ * The tracked lines are kept in a set-associative table, sized by the
+ * maximum capacity of the filter, whose sets are allocated on first
+ * use. A real sparse directory would have to back-invalidate one of the
+ * lines of a full set to make room for a new one. Since the caches
+ * above do not support unsolicited invalidations, the new line is
+ * instead kept in an overflow table. Only the total number of tracked
+ * lines is limited, by the maximum capacity of the filter.
  */
 class SnoopFilter : public SimObject {
   public:
@@ -89,14 +99,106 @@ class SnoopFilter : public SimObject {
     // Change for systems with more than 256 ports tracked by this object
     static const int SNOOP_MASK_SIZE = 256;
 
-    typedef std::vector<QueuedResponsePort*> SnoopList;
+    /**
+     * The underlying type for the bitmask we use for tracking. This
+     * limits the number of snooping ports supported per crossbar.
+     */
+    typedef std::bitset<SNOOP_MASK_SIZE> SnoopMask;
 
-    SnoopFilter (const SnoopFilterParams *p) :
-        SimObject(p), reqLookupResult(cachedLocations.end()),
-        linesize(p->system->cacheLineSize()), lookupLatency(p->lookup_latency),
-        maxEntryCount(p->max_capacity / p->system->cacheLineSize())
+    /**
+     * A list of snooping ports, represented by a bitmask over a vector
+     * of ports, so that lookups do not have to allocate their results.
+     * The list does not own the ports' vector, which must outlive it.
+     */
+    class SnoopList
     {
-    }
+      public:
+        class const_iterator
+        {
+          public:
+            const_iterator(const SnoopList &_list, size_t _index)
+                : list(_list), index(_index)
+            {
+                skipUnselected();
+            }
+
+            QueuedResponsePort *operator*() const
+            {
+                return (*list.ports)[index];
+            }
+
+            const_iterator &
+            operator++()
+            {
+                ++index;
+                skipUnselected();
+                return *this;
+            }
+
+            bool
+            operator!=(const const_iterator &other) const
+            {
+                return index != other.index;
+            }
+
+          private:
+            void
+            skipUnselected()
+            {
+                while (index < list.ports->size() && !list.selected(index))
+                    ++index;
+            }
+
+            const SnoopList &list;
+            size_t index;
+        };
+
+        /**
+         * Create a list of all the given ports.
+         *
+         * @param _ports The ports in the list.
+         */
+        SnoopList(const std::vector<QueuedResponsePort*> &_ports)
+            : ports(&_ports), mask(0), all(true)
+        {
+        }
+
+        /**
+         * Create a list of a subset of the given ports.
+         *
+         * @param _ports The ports that can be selected.
+         * @param _mask Bitmask of the selected ports' indices.
+         */
+        SnoopList(const std::vector<QueuedResponsePort*> &_ports,
+                  SnoopMask _mask)
+            : ports(&_ports), mask(_mask), all(false)
+        {
+        }
+
+        const_iterator begin() const { return const_iterator(*this, 0); }
+        const_iterator
+        end() const
+        {
+            return const_iterator(*this, ports->size());
+        }
+
+        size_t size() const { return all ? ports->size() : mask.count(); }
+        bool empty() const { return size() == 0; }
+
+      private:
+        bool selected(size_t index) const { return all || mask[index]; }
+
+        /** All ports that can be selected. */
+        const std::vector<QueuedResponsePort*> *ports;
+
+        /** The selected ports, unless all of them are. */
+        SnoopMask mask;
+
+        /** Whether all the ports are selected. */
+        bool all;
+    };
+
+    SnoopFilter(const SnoopFilterParams *p);
 
     /**
      * Init a new snoop filter and tell it about all the cpu_sideports
@@ -104,7 +206,8 @@ class SnoopFilter : public SimObject {
      *
      * @param _cpu_side_ports Response ports that the bus is attached to.
      */
-    void setCPUSidePorts(const SnoopList& _cpu_side_ports) {
+    void setCPUSidePorts(
+            const std::vector<QueuedResponsePort*>& _cpu_side_ports) {
         localResponsePortIds.resize(_cpu_side_ports.size(), InvalidPortID);
 
         PortID id = 0;
@@ -199,12 +302,6 @@ class SnoopFilter : public SimObject {
 
   protected:
 
-    /**
-     * The underlying type for the bitmask we use for tracking. This
-     * limits the number of snooping ports supported per crossbar.
-     */
-    typedef std::bitset<SNOOP_MASK_SIZE> SnoopMask;
-
     /**
     * Per cache line item tracking a bitmask of ResponsePorts who have an
     * outstanding request to this line (requested) or already share a
@@ -214,27 +311,33 @@ class SnoopFilter : public SimObject {
         SnoopMask requested;
         SnoopMask holder;
     };
+
     /**
-     * HashMap of SnoopItems indexed by line address
+     * Entry of the table of tracked lines.
      */
-    typedef std::unordered_map<Addr, SnoopItem> SnoopFilterCache;
+    struct SnoopEntry {
+        /** Line address, including the line status bits. */
+        Addr lineAddr;
+        /** Whether this entry is tracking a line. */
+        bool valid;
+        SnoopItem item;
+    };
 
     /**
      * Simple factory methods for standard return values.
      */
     std::pair<SnoopList, Cycles> snoopAll(Cycles latency) const
     {
-        return std::make_pair(cpuSidePorts, latency);
+        return std::make_pair(SnoopList(cpuSidePorts), latency);
     }
-    std::pair<SnoopList, Cycles> snoopSelected(const SnoopList&
-                                _cpu_side_ports, Cycles latency) const
+    std::pair<SnoopList, Cycles> snoopSelected(SnoopMask ports,
+                                               Cycles latency) const
     {
-        return std::make_pair(_cpu_side_ports, latency);
+        return std::make_pair(maskToPortList(ports), latency);
     }
     std::pair<SnoopList, Cycles> snoopDown(Cycles latency) const
     {
-        SnoopList empty;
-        return std::make_pair(empty , latency);
+        return std::make_pair(maskToPortList(0), latency);
     }
 
     /**
@@ -252,13 +355,47 @@ class SnoopFilter : public SimObject {
 
   private:
 
+    /**
+     * Get the line address, including the status bits, of a packet.
+     */
+    Addr getLineAddr(const Packet* cpkt) const;
+
+    /**
+     * Find the entry tracking a line.
+     *
+     * @param line_addr Line address, including the status bits.
+     * @return The entry, or nullptr if the line is not tracked.
+     */
+    SnoopEntry* findEntry(Addr line_addr);
+
+    /**
+     * Start tracking a line that is not tracked yet. If its set is
+     * full, the line is tracked in the overflow table instead.
+     *
+     * @param line_addr Line address, including the status bits.
+     * @return The new, empty, entry.
+     */
+    SnoopEntry* allocateEntry(Addr line_addr);
+
     /**
      * Removes snoop filter items which have no requestors and no holders.
      */
-    void eraseIfNullEntry(SnoopFilterCache::iterator& sf_it);
+    void eraseIfNullEntry(SnoopEntry* sf_entry);
 
-    /** Simple hash set of cached addresses. */
-    SnoopFilterCache cachedLocations;
+    /** Associativity of the table of tracked lines. */
+    const unsigned assoc;
+
+    /** Number of sets in the table of tracked lines. */
+    const unsigned numSets;
+
+    /** Sets of the table of tracked lines, allocated on first use. */
+    std::vector<std::unique_ptr<SnoopEntry[]>> sets;
+
+    /** Lines that did not fit in their set. */
+    std::unordered_map<Addr, SnoopEntry> overflowEntries;
+
+    /** Number of tracked lines, including the overflowing ones. */
+    unsigned numEntries;
 
     /**
      * A request lookup must be followed by a call to finishRequest to inform
@@ -267,8 +404,8 @@ class SnoopFilter : public SimObject {
      * This structure keeps track of the state previous to such changes.
      */
     struct ReqLookupResult {
-        /** Iterator used to store the result from lookupRequest. */
-        SnoopFilterCache::iterator it;
+        /** Entry used to store the result from lookupRequest. */
+        SnoopEntry* entry;
 
         /**
          * Variable to temporarily store value of snoopfilter entry
@@ -277,21 +414,14 @@ class SnoopFilter : public SimObject {
          */
         SnoopItem retryItem;
 
-        /**
-         * The constructor must be informed of the internal cache's end
-         * iterator, so do not allow the compiler to implictly define it.
-         *
-         * @param end_it Iterator to the end of the internal cache.
-         */
-        ReqLookupResult(SnoopFilterCache::iterator end_it)
-            : it(end_it), retryItem{0, 0}
+        ReqLookupResult()
+            : entry(nullptr), retryItem{0, 0}
         {
         }
-        ReqLookupResult() = delete;
     } reqLookupResult;
 
     /** List of all attached snooping CPU-side ports. */
-    SnoopList cpuSidePorts;
+    std::vector<QueuedResponsePort*> cpuSidePorts;
     /** Track the mapping from port ids to the local mask ids. */
     std::vector<PortID> localResponsePortIds;
     /** Cache line size. */
@@ -317,6 +447,8 @@ class SnoopFilter : public SimObject {
     Stats::Scalar totSnoops;
     Stats::Scalar hitSingleSnoops;
     Stats::Scalar hitMultiSnoops;
+
+    Stats::Scalar setOverflows;
 };
 
 inline SnoopFilter::SnoopMask
@@ -331,11 +463,9 @@ SnoopFilter::portToMask(const ResponsePort& port) const
 inline SnoopFilter::SnoopList
 SnoopFilter::maskToPortList(SnoopMask port_mask) const
 {
-    SnoopList res;
-    for (const auto& p : cpuSidePorts)
-        if ((port_mask & portToMask(*p)).any())
-            res.push_back(p);
-    return res;
+    // The local ids of the snooping ports are their indices in
+    // cpuSidePorts, so the mask can be used as is
+    return SnoopList(cpuSidePorts, port_mask);
 }
 
 #endif // __MEM_SNOOP_FILTER_HH__
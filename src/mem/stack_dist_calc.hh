@@ -39,7 +39,7 @@
 #define __MEM_STACK_DIST_CALC_HH__
 
 #include <limits>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "base/types.hh"
@@ -47,29 +47,31 @@
 /**
   * The stack distance calculator is a passive object that merely
   * observes the addresses pass to it. It calculates stack distances
-  * of incoming addresses based on the partial sum hierarchy tree
-  * algorithm described by Alamasi et al.
-  * http://doi.acm.org/10.1145/773039.773043.
+  * of incoming addresses, i.e., the number of unique addresses that
+  * were accessed since the last access to the same address.
   *
-  * A tree structure is maintained and updated at each transaction
-  * (unique or non-unique). The tree is implemented as an STL vector
-  * with layers of the form <map> Each layer in this tree is an
-  * ordered map <uint64_t, Node*>. Nodes are structs which take form
-  * of leaf, intermediate and root nodes. For example, in a tree with 3
-  * layers, tree[0][5] gives a leaf node pointer for key=5 tree[1][1]
-  * gives an intermediate node pointer for key=1 tree[2][0] gives the
-  * root node in the tree.
+  * Every access is assigned a slot in a timeline of accesses, and
+  * the slot of the last access to each address is kept in a hash map
+  * (aiMap). A slot is valid while it holds the most recent access to
+  * its address. The stack distance of an address is therefore the
+  * number of valid slots after the slot of its last access. The
+  * valid slots are counted with a binary indexed (Fenwick) tree of
+  * partial sums, so that every lookup and update takes logarithmic
+  * time in the number of slots, and no memory is allocated per
+  * access.
   *
-  * At every transaction a hash-map (aiMap) is looked up to check if
-  * the address was already encountered before. Based on this lookup a
-  * transaction can be termed as unique or non-unique.
+  * The timeline has a fixed capacity. When it is full, the valid
+  * slots are compacted to the beginning of the timeline, preserving
+  * their order, and the capacity is grown if needed so that at least
+  * half of it is free. This keeps the timeline proportional to the
+  * number of unique addresses, and the cost of the compaction is
+  * amortized over the accesses that filled the timeline.
   *
   * In addition to the normal stack distance calculation, a feature to
-  * mark an old node in the tree is added. This is useful if it is
-  * required to see the reuse pattern. For example, BackInvalidates
-  * from a lower level (e.g. membus to L2), can be marked (isMarked
-  * flag of Node set to True). Then later if this same address is
-  * accessed (by L1), the value of the isMarked flag would be
+  * mark an old access is provided. This is useful if it is required
+  * to see the reuse pattern. For example, BackInvalidates from a lower
+  * level (e.g. membus to L2), can be marked. Then later if this same
+  * address is accessed (by L1), the value of the mark flag would be
   * True. This would give some insight on how the BackInvalidates
   * policy of the lower level affect the read/write accesses in an
   * application.
@@ -77,41 +79,33 @@
   * There are two functions provided to interface with the calculator:
   * 1. pair<uint64_t, bool> calcStackDistAndUpdate(Addr r_address,
   *                                                bool addNewNode)
-  * At every unique transaction a new leaf node is added at tree[0](leaf layer)
-  * and linked to the layer above (if addNewNode is True). The sums of all
-  * the intermediate nodes is updated till the root. The stack-distance is
-  * returned as a Constant representing INFINITY.
+  * At every unique transaction a new slot is used (if addNewNode is
+  * True) and the stack-distance is returned as a Constant
+  * representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, the old node is deleted
-  * from the tree, and the sums (to the right are collected) and
-  * decremented. The collected sum represets the stack distance of the
-  * found node. If this node was marked then a bool flag set to True
-  * is returned with the stack_distance. During this operation a node
-  * is discarded at the leaf layer always. Moreover during the
-  * traversal upwards using the updateSum() method, if an intermediate
-  * node is found with no children connected to it, then that is
-  * discarded too.
+  * At every non-unique transaction the old slot of the address is
+  * invalidated, and the number of valid slots after it is returned as
+  * the stack distance. If the old access was marked then a bool flag
+  * set to True is returned with the stack_distance. A new slot is
+  * then used for the address if addNewNode is True.
   *
   * The return value of this function is a pair representing the
   * stack_distance and the value of the marked flag.
   *
   * 2. pair<uint64_t , bool> calcStackDist(Addr r_address, bool mark)
   * This is a stripped down version of the above function which is used to
-  * just inspect the tree, and mark a leaf node (if mark flag is set). The
-  * functionality to add a new node is removed.
+  * just inspect the stack, and mark an access (if mark flag is set). The
+  * functionality to add a new access is removed.
   *
   * At every unique transaction the stack-distance is returned as a constant
   * representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, and the sums (to the right)
-  * are collected. The collected sum represets the stack distance of
-  * the found node.
+  * At every non-unique transaction the number of valid slots after
+  * the last access to the address is returned as the stack distance.
   *
-  * This function does NOT Modify the stack. (No node is added or
-  * deleted).  It is just used to mark a node already created and get
-  * its stack distance.
+  * This function does NOT Modify the stack. (No slot is added or
+  * invalidated).  It is just used to mark an access already seen and
+  * get its stack distance.
   *
   * The return value of this function is a pair representing the stack
   * distance and the value of the marked flag.
@@ -136,7 +130,7 @@
   *  *I: stack-distance = infinity,
   *  *SD: Stack Distance
   *  *r_address: address to be added, *prevMark: value of isMarked flag
-  *                                                              of the Node)
+  *                                                      of the last access)
   *
   * Invalidates refer to a type of packet that removes something from
   * a cache, either autonoumously (due-to cache's own replacement
@@ -148,15 +142,6 @@
   * Delete Old Entry |calcStackDistAndUpdate|Writebacks/Cleanevicts|
   * Dist.of Old entry|calcStackDist         |Cleanevicts/Invalidate|
   *
-  * Node Balancing: The tree structure is maintained by an
-  * updateTree() operation called when an intermediate node is
-  * required. The update operation is roughly categorized as a root
-  * update or intermediate layer update. When number of leaf nodes
-  * grow over a power of 2 then a new layer is added at the top of the
-  * tree and a new root node is initialized. The old node at the lower
-  * layer is connected to this.  In an intermediate node update
-  * operation a new intermediate node is added to the required layer.
-  *
   * Debugging: Debugging can be enabled by setting the verifyStack flag
   * true. Debugging is implemented using a dummy stack that behaves in
   * a naive way, using STL vectors (i.e each unique address is pushed
@@ -166,99 +151,63 @@
   * pushed down, and the address is pushed at the top of the stack).
   *
   * A printStack(int numOfEntitiesToPrint) is provided to print top n entities
-  * in both (tree and STL based dummy stack).
+  * in both (timeline and STL based dummy stack).
   */
 class StackDistCalc
 {
 
   private:
 
-    struct Node;
-
-    typedef std::map<uint64_t, Node*> IndexNodeMap;
-    typedef std::map<Addr, uint64_t> AddressIndexMap;
-    typedef std::vector<IndexNodeMap> TreeType;
-
     /**
-     * Gets sum from the node upwards recursively till the root.  This
-     * function is called first by getSumsLeavesToRoot, and then
-     * recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     *        from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @return The stack distance of the current address.
-     *
+     * Information about the last access to an address.
      */
-    uint64_t getSum(Node* node, bool from_left, uint64_t sum_from_below,
-                    uint64_t stack_dist, uint64_t level) const;
+    struct AccessInfo
+    {
+        // Slot of the last access in the timeline
+        uint64_t slot;
+
+        /**
+         * Flag to indicate if this address is marked. Used in case
+         * where stack distance of a touched address is required.
+         */
+        bool isMarked;
+    };
+
+    typedef std::unordered_map<Addr, AccessInfo> AddressInfoMap;
 
     /**
-     * Gets the sum from the leaf node specified. This function
-     * is called by calcStackDist.
-     *
-     * @param node pointer to the node which is updated
-     * @return The stack distance of the current address.
+     * Add a value to the given slot's counter in the tree of partial
+     * sums.
      *
+     * @param slot The slot to update
+     * @param value The value to be added (either 1 or -1)
      */
-    uint64_t getSumsLeavesToRoot(Node* node) const;
+    void updateSlot(uint64_t slot, int64_t value);
 
     /**
-     * Updates the nodes upwards recursively till the root.
-     * This function is first called by updateSumsLeavesToRoot,
-     * and then it recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     * from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @param discard_node whether the calling node was discarded or not
-     * @return The stack distance of the current address.
+     * Count the number of valid slots up to, and including, the given
+     * slot.
      *
+     * @param slot The last slot to be counted
+     * @return The number of valid slots in [0, slot]
      */
-    uint64_t updateSum(Node* node,
-                       bool from_left, uint64_t sum_from_below, uint64_t level,
-                       uint64_t stack_dist, bool discard_node);
+    uint64_t countValidSlots(uint64_t slot) const;
 
     /**
-     * Updates the leaf nodes and nodes above. This function is
-     * called by the calcStackDistAndUpdate.
-     *
-     * @param node pointer to the node which is updated
-     * @param is_new_leaf is true if this is a newly added node
-     * @return The stack distance of the current address.
+     * Get the stack distance of an access, that is, the number of
+     * valid slots after it.
      *
+     * @param slot The slot of the access
+     * @return The stack distance of the access
      */
-    uint64_t updateSumsLeavesToRoot(Node* node, bool is_new_leaf);
+    uint64_t getStackDist(uint64_t slot) const;
 
     /**
-     * updateTree is a tree balancing operation, which maintains the
-     * binary tree structure.
-     * This method is called whenever index%2 == 0 (i.e. every
-     * alternate cycle) The two main operation are :
-     * OP1. Moving the root node one layer up if index counter
-     *       crosses power of 2
-     * OP2. Addition of intermediate nodes as and when required
-     *      and linking them to their parents in the layer above.
+     * Move all valid slots to the beginning of the timeline, preserving
+     * their order, and rebuild the tree of partial sums. The timeline
+     * is grown if less than half of it would be free afterwards.
      */
-    void updateTree();
-
-    /**
-     * This method is used for verification purposes
-     * It recursively traverses upwards from the given node till
-     * the root to check if the ultimate parent node (root-node) points
-     * to null.
-     *
-     * @param node pointer to the node whose sanity is being checked
-     * @param level the level at which this node is located in the tree
-     *
-     */
-    void sanityCheckTree(const Node* node, uint64_t level = 0) const;
+    void compact();
 
     /**
      * Return the counter for address accesses (unique and
@@ -269,19 +218,10 @@ class StackDistCalc
      */
     uint64_t getIndex() const { return index; }
 
-    /**
-     * Query depth of the tree (tree[0] represents leaf layer while
-     * tree[treeDepth] represents the root layer, all layers in
-     * between contain intermediate nodes)
-     *
-     * @return Tree depth
-     */
-    uint64_t getTreeDepth() const { return tree.size() - 1; }
-
     /**
      * Print the last n items on the stack.
-     * This method prints top n entries in the tree based implementation as
-     * well as dummy stack.
+     * This method prints top n entries in the timeline based
+     * implementation as well as dummy stack.
      * @param n Number of entries to print
      */
     void printStack(int n = 5) const;
@@ -290,7 +230,6 @@ class StackDistCalc
      * This is an alternative implementation of the stack-distance
      * in a naive way. It uses simple STL vector to represent the stack.
      * It can be used in parallel for debugging purposes.
-     * It is 10x slower than the tree based implemenation.
      *
      * @param r_address The current address to process
      * @param update_stack Flag to indicate if stack should be updated
@@ -314,7 +253,7 @@ class StackDistCalc
 
     /**
      * Process the given address. If Mark is true then set the
-     * mark flag of the leaf node.
+     * mark flag of the last access.
      * This function returns the stack distance of the incoming
      * address and the previous status of the mark flag.
      *
@@ -327,14 +266,14 @@ class StackDistCalc
 
     /**
      * Process the given address:
-     *  - Lookup the tree for the given address
-     *  - delete old node if found in tree
-     *  - add a new node (if addNewNode flag is set)
+     *  - Lookup the last access to the given address
+     *  - invalidate the old access if found
+     *  - add a new access (if addNewNode flag is set)
      * This function returns the stack distance of the incoming
      * address and the status of the mark flag.
      *
      * @param r_address The current address to process
-     * @param addNewNode If true, a new node is added to the tree
+     * @param addNewNode If true, a new access is added to the stack
      * @return The stack distance of the current address and the mark flag.
      */
     std::pair<uint64_t, bool> calcStackDistAndUpdate(const Addr r_address,
@@ -342,66 +281,36 @@ class StackDistCalc
 
   private:
 
+    /** Initial number of slots in the timeline. */
+    static constexpr uint64_t InitialSlots = 1024;
+
     /**
-     * Node which takes form of Leaf, INode or Root
+     * Internal counter for address accesses (unique and non-unique)
+     * This counter increments everytime the calcStackDistAndUpdate()
+     * method adds a new access.
      */
-    struct Node{
-        // Sum of the left children
-        uint64_t sumLeft;
-
-        // Sum of the right children
-        uint64_t sumRight;
-
-        // Flag to indicate that sumLeft has gone from non-zero value to 0
-        bool discardLeft;
-
-        // Flag to indicate that sumRight has gone from non-zero value to 0
-        bool discardRight;
-
-        // Index of the current element in the Map
-        uint64_t nodeIndex;
-
-        // Pointer to the parent
-        Node* parent;
-
-        // Flag to mark the node as the right/left child
-        bool isLeftNode;
+    uint64_t index;
 
-        /**
-         * Flag to indicate if this address is marked. Used in case
-         * where stack distance of a touched address is required.
-         */
-        bool isMarked;
+    /** Next free slot in the timeline. */
+    uint64_t nextSlot;
 
-        /**
-         * The discard flags are false by default they become true if
-         * the node is reached again in a future lookup.
-         */
-        Node() : sumLeft(0), sumRight(0), discardLeft(false),
-                 discardRight(false), nodeIndex(0),
-                 parent(nullptr), isLeftNode(true), isMarked(false)
-        { }
-    };
+    /** Number of valid slots in the timeline. */
+    uint64_t numValidSlots;
 
     /**
-     * Internal counter for address accesses (unique and non-unique)
-     * This counter increments everytime the calcStackDist() method is
-     * called. This counter is used as a key for the hash- map at the
-     * leaf layer. Practically at every call to the calculator this
-     * counter is incremented and a new leaf node is added in the tree
-     * at the leaf layer using this counter value as the key.
+     * Binary indexed tree of partial sums of valid slots. It is
+     * 1-based, so element 0 is unused.
      */
-    uint64_t index;
+    std::vector<uint64_t> partialSums;
 
-    // Binary tree of partial sums
-    TreeType tree;
+    /** Address of the access in each slot of the timeline. */
+    std::vector<Addr> slotAddr;
 
-    // Hash map which returns last seen index of each address
-    AddressIndexMap aiMap;
+    /** Whether each slot of the timeline holds a valid access. */
+    std::vector<bool> slotValid;
 
-    // Keeps count of number of the next unique index for each
-    // level in the tree
-    std::vector<uint64_t> nextIndex;
+    // Hash map which returns the last access to each address
+    AddressInfoMap aiMap;
 
     // Dummy Stack for verification
     std::vector<uint64_t> stack;
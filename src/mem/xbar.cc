@@ -141,6 +141,7 @@ BaseXBar::Layer<SrcType, DstType>::Layer(DstType& _port, BaseXBar& _xbar,
     Stats::Group(&_xbar, _name.c_str()),
     port(_port), xbar(_xbar), _name(xbar.name() + "." + _name), state(IDLE),
     waitingForPeer(NULL), releaseEvent([this]{ releaseLayer(); }, name()),
+    releaseTick(0),
     ADD_STAT(occupancy, "Layer occupancy (ticks)"),
     ADD_STAT(utilization, "Layer utilization (%)")
 {
@@ -165,7 +166,14 @@ void BaseXBar::Layer<SrcType, DstType>::occupyLayer(Tick until)
 
     // until should never be 0 as express snoops never occupy the layer
     assert(until != 0);
-    xbar.schedule(releaseEvent, until);
+    assert(!releaseEvent.scheduled());
+    releaseTick = until;
+
+    // only schedule the release if a port is already waiting for it,
+    // or if it has to signal the end of a drain, otherwise the layer
+    // is released lazily
+    if (!waitingForLayer.empty() || drainState() == DrainState::Draining)
+        scheduleRelease();
 
     // account for the occupied ticks
     occupancy += until - curTick();
@@ -174,10 +182,34 @@ void BaseXBar::Layer<SrcType, DstType>::occupyLayer(Tick until)
             curTick(), until);
 }
 
+template <typename SrcType, typename DstType>
+void
+BaseXBar::Layer<SrcType, DstType>::updateLazyRelease()
+{
+    // if the release event is scheduled, it is responsible for
+    // releasing the layer and retrying the waiting ports
+    if (state == BUSY && !releaseEvent.scheduled() &&
+        curTick() >= releaseTick) {
+        assert(waitingForLayer.empty());
+        state = IDLE;
+    }
+}
+
+template <typename SrcType, typename DstType>
+void
+BaseXBar::Layer<SrcType, DstType>::scheduleRelease()
+{
+    assert(state == BUSY);
+    if (!releaseEvent.scheduled())
+        xbar.schedule(releaseEvent, std::max(releaseTick, curTick()));
+}
+
 template <typename SrcType, typename DstType>
 bool
 BaseXBar::Layer<SrcType, DstType>::tryTiming(SrcType* src_port)
 {
+    updateLazyRelease();
+
     // if we are in the retry state, we will not see anything but the
     // retrying port (or in the case of the snoop ports the snoop
     // response port that mirrors the actual CPU-side port) as we leave
@@ -197,6 +229,11 @@ BaseXBar::Layer<SrcType, DstType>::tryTiming(SrcType* src_port)
         // that transaction to go through, and then the layer to free
         // up)
         waitingForLayer.push_back(src_port);
+
+        // make sure the port gets its retry once the layer is free
+        if (state == BUSY)
+            scheduleRelease();
+
         return false;
     }
 
@@ -306,6 +343,8 @@ BaseXBar::Layer<SrcType, DstType>::recvRetry()
     // something to this port
     assert(waitingForPeer != NULL);
 
+    updateLazyRelease();
+
     // add the port where the failed packet originated to the front of
     // the waiting ports for the layer, this allows us to call retry
     // on the port immediately if the crossbar layer is idle
@@ -320,6 +359,7 @@ BaseXBar::Layer<SrcType, DstType>::recvRetry()
         retryWaiting();
     } else {
         assert(state == BUSY);
+        scheduleRelease();
     }
 }
 
@@ -586,8 +626,12 @@ BaseXBar::Layer<SrcType, DstType>::drain()
     //We should check that we're not "doing" anything, and that noone is
     //waiting. We might be idle but have someone waiting if the device we
     //contacted for a retry didn't actually retry.
+    updateLazyRelease();
     if (state != IDLE) {
         DPRINTF(Drain, "Crossbar not drained\n");
+        // make sure the release signals the end of the drain
+        if (state == BUSY)
+            scheduleRelease();
         return DrainState::Draining;
     } else {
         return DrainState::Drained;
@@ -47,9 +47,9 @@
 #define __MEM_XBAR_HH__
 
 #include <deque>
-#include <unordered_map>
 
 #include "base/addr_range_map.hh"
+#include "base/open_hash_map.hh"
 #include "base/types.hh"
 #include "mem/qport.hh"
 #include "params/BaseXBar.hh"
@@ -221,6 +221,29 @@ class BaseXBar : public ClockedObject
         void releaseLayer();
         EventFunctionWrapper releaseEvent;
 
+        /**
+         * Tick at which the layer stops being occupied. The release
+         * event is only scheduled when there is something to do upon
+         * release, i.e. when a port is waiting for the layer or the
+         * layer is draining. Otherwise, the layer is released lazily
+         * by the next port trying to use it, which saves scheduling
+         * an event for every packet going through an uncontended
+         * layer.
+         */
+        Tick releaseTick;
+
+        /**
+         * Lazily release the layer if it is no longer occupied and
+         * nothing is waiting for it to be released.
+         */
+        void updateLazyRelease();
+
+        /**
+         * Make sure the layer is released on time, as something is
+         * waiting for it to be released.
+         */
+        void scheduleRelease();
+
         /**
          * Stats for occupancy and utilization. These stats capture
          * the time the layer spends in the busy state and are thus only
@@ -319,9 +342,11 @@ class BaseXBar : public ClockedObject
      * Remember where request packets came from so that we can route
      * responses to the appropriate port. This relies on the fact that
      * the underlying Request pointer inside the Packet stays
-     * constant.
+     * constant. The table is updated for every packet crossing the
+     * crossbar, and is therefore kept in an open-addressing hash map
+     * that does not allocate as requests come and go.
      */
-    std::unordered_map<RequestPtr, PortID> routeTo;
+    OpenHashMap<RequestPtr, PortID> routeTo;
 
     /** all contigous ranges seen by this crossbar */
     AddrRangeList xbarRanges;
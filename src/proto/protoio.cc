@@ -37,28 +37,284 @@
 
 #include "proto/protoio.hh"
 
+#include <zlib.h>
+
 #include "base/logging.hh"
 
 using namespace std;
 using namespace google::protobuf;
 
+namespace
+{
+
+void
+putLE(uint8_t *buf, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i)
+        buf[i] = value >> (8 * i);
+}
+
+uint64_t
+getLE(const uint8_t *buf, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i)
+        value |= uint64_t(buf[i]) << (8 * i);
+    return value;
+}
+
+} // anonymous namespace
+
+bool
+ChunkedStream::isChunked(const unsigned char *bytes)
+{
+    return getLE(bytes, 4) == containerMagic;
+}
+
+ChunkedOutputStream::ChunkedOutputStream(ostream *stream, size_t chunk_size)
+    : stream(stream), chunkSize(chunk_size), buffer(chunk_size), used(0),
+      offset(headerSize), bytesWritten(0), numMessages(0), chunkMessage(0),
+      closed(false)
+{
+    uint8_t header[headerSize];
+    putLE(header, containerMagic, 4);
+    putLE(header + 4, containerVersion, 4);
+    putLE(header + 8, chunkSize, 4);
+    stream->write((const char *)header, headerSize);
+}
+
+ChunkedOutputStream::~ChunkedOutputStream()
+{
+    close();
+}
+
+bool
+ChunkedOutputStream::Next(void** data, int* size)
+{
+    // A message larger than a chunk simply makes the chunk grow
+    if (used == buffer.size())
+        buffer.resize(buffer.size() * 2);
+
+    *data = &buffer[used];
+    *size = buffer.size() - used;
+    used = buffer.size();
+    return true;
+}
+
+void
+ChunkedOutputStream::BackUp(int count)
+{
+    assert(count >= 0 && (size_t)count <= used);
+    used -= count;
+}
+
+int64_t
+ChunkedOutputStream::ByteCount() const
+{
+    return bytesWritten + used;
+}
+
+void
+ChunkedOutputStream::endMessage()
+{
+    ++numMessages;
+    if (used >= chunkSize)
+        writeChunk();
+}
+
+void
+ChunkedOutputStream::writeChunk()
+{
+    if (used == 0)
+        return;
+
+    uLongf compressed_size = compressBound(used);
+    compressed.resize(chunkHeaderSize + compressed_size);
+    if (compress2(&compressed[chunkHeaderSize], &compressed_size,
+                  buffer.data(), used, Z_DEFAULT_COMPRESSION) != Z_OK)
+        panic("Failed to compress a trace chunk\n");
+
+    putLE(compressed.data(), compressed_size, 4);
+    putLE(compressed.data() + 4, used, 4);
+    stream->write((const char *)compressed.data(),
+                  chunkHeaderSize + compressed_size);
+
+    index.push_back({offset, chunkMessage});
+    offset += chunkHeaderSize + compressed_size;
+    bytesWritten += used;
+    chunkMessage = numMessages;
+    used = 0;
+}
+
+void
+ChunkedOutputStream::close()
+{
+    if (closed)
+        return;
+    closed = true;
+
+    writeChunk();
+
+    vector<uint8_t> footer(index.size() * indexEntrySize + trailerSize);
+    uint8_t *entry = footer.data();
+    for (const auto &chunk : index) {
+        putLE(entry, chunk.offset, 8);
+        putLE(entry + 8, chunk.firstMessage, 8);
+        entry += indexEntrySize;
+    }
+    putLE(entry, offset, 8);
+    putLE(entry + 8, index.size(), 8);
+    putLE(entry + 16, containerMagic, 4);
+    stream->write((const char *)footer.data(), footer.size());
+}
+
+ChunkedInputStream::ChunkedInputStream(istream *stream, const string &name)
+    : stream(stream), name(name), nextChunk(0), pos(0), bytesBefore(0)
+{
+    uint8_t header[headerSize];
+    stream->seekg(0, ios::beg);
+    if (!stream->read((char *)header, headerSize) ||
+        getLE(header, 4) != containerMagic)
+        panic("%s is not a chunked trace container\n", name);
+    const uint32_t version = getLE(header + 4, 4);
+    if (version != containerVersion)
+        panic("%s uses chunked container version %d, expected %d\n", name,
+              version, (uint32_t)containerVersion);
+
+    uint8_t trailer[trailerSize];
+    stream->seekg(-(streamoff)trailerSize, ios::end);
+    const uint64_t index_end = stream->tellg();
+    if (!stream->read((char *)trailer, trailerSize) ||
+        getLE(trailer + 16, 4) != containerMagic)
+        panic("Chunked trace container %s has no index, it may have "
+              "been truncated\n", name);
+
+    const uint64_t index_offset = getLE(trailer, 8);
+    const uint64_t num_chunks = getLE(trailer + 8, 8);
+    if (index_offset + num_chunks * indexEntrySize != index_end)
+        panic("Chunked trace container %s has a corrupt index\n", name);
+
+    vector<uint8_t> entries(num_chunks * indexEntrySize);
+    stream->seekg(index_offset, ios::beg);
+    if (!stream->read((char *)entries.data(), entries.size()))
+        panic("Failed to read the index of %s\n", name);
+
+    index.resize(num_chunks);
+    for (uint64_t i = 0; i < num_chunks; ++i) {
+        index[i].offset = getLE(&entries[i * indexEntrySize], 8);
+        index[i].firstMessage = getLE(&entries[i * indexEntrySize + 8], 8);
+    }
+
+    seek(0);
+}
+
+void
+ChunkedInputStream::seek(size_t chunk)
+{
+    assert(chunk <= index.size());
+    nextChunk = chunk;
+    buffer.clear();
+    pos = 0;
+    bytesBefore = 0;
+    if (chunk < index.size()) {
+        stream->clear();
+        stream->seekg(index[chunk].offset, ios::beg);
+    }
+}
+
+bool
+ChunkedInputStream::readChunk()
+{
+    if (nextChunk == index.size())
+        return false;
+
+    uint8_t header[chunkHeaderSize];
+    if (!stream->read((char *)header, chunkHeaderSize))
+        panic("Failed to read chunk %d of %s\n", nextChunk, name);
+
+    const uLongf compressed_size = getLE(header, 4);
+    uLongf size = getLE(header + 4, 4);
+    compressed.resize(compressed_size);
+    if (!stream->read((char *)compressed.data(), compressed_size))
+        panic("Failed to read chunk %d of %s\n", nextChunk, name);
+
+    bytesBefore += buffer.size();
+    buffer.resize(size);
+    if (uncompress(buffer.data(), &size, compressed.data(),
+                   compressed_size) != Z_OK || size != buffer.size())
+        panic("Failed to decompress chunk %d of %s\n", nextChunk, name);
+
+    pos = 0;
+    ++nextChunk;
+    return true;
+}
+
+bool
+ChunkedInputStream::Next(const void** data, int* size)
+{
+    while (pos == buffer.size()) {
+        if (!readChunk())
+            return false;
+    }
+
+    *data = &buffer[pos];
+    *size = buffer.size() - pos;
+    pos = buffer.size();
+    return true;
+}
+
+void
+ChunkedInputStream::BackUp(int count)
+{
+    assert(count >= 0 && (size_t)count <= pos);
+    pos -= count;
+}
+
+bool
+ChunkedInputStream::Skip(int count)
+{
+    while (count > 0) {
+        if (pos == buffer.size() && !readChunk())
+            return false;
+        const size_t skipped = min<size_t>(count, buffer.size() - pos);
+        pos += skipped;
+        count -= skipped;
+    }
+    return true;
+}
+
+int64_t
+ChunkedInputStream::ByteCount() const
+{
+    return bytesBefore + pos;
+}
+
 ProtoOutputStream::ProtoOutputStream(const string& filename) :
     fileStream(filename.c_str(), ios::out | ios::binary | ios::trunc),
-    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
+    wrappedFileStream(NULL), gzipStream(NULL), chunkedStream(NULL),
+    zeroCopyStream(NULL)
 {
     if (!fileStream.good())
         panic("Could not open %s for writing\n", filename);
 
     // Wrap the output file in a zero copy stream, that in turn is
     // wrapped in a gzip stream if the filename ends with .gz. The
-    // latter stream is in turn wrapped in a coded stream
-    wrappedFileStream = new io::OstreamOutputStream(&fileStream);
-    if (filename.find_last_of('.') != string::npos &&
-        filename.substr(filename.find_last_of('.') + 1) == "gz") {
-        gzipStream = new io::GzipOutputStream(wrappedFileStream);
-        zeroCopyStream = gzipStream;
+    // latter stream is in turn wrapped in a coded stream. A chunked
+    // container does its own compression and writes to the file
+    // directly.
+    const string extension = filename.find_last_of('.') != string::npos ?
+        filename.substr(filename.find_last_of('.') + 1) : "";
+    if (extension == "pbz") {
+        chunkedStream = new ChunkedOutputStream(&fileStream, chunkSize);
+        zeroCopyStream = chunkedStream;
     } else {
-        zeroCopyStream = wrappedFileStream;
+        wrappedFileStream = new io::OstreamOutputStream(&fileStream);
+        if (extension == "gz") {
+            gzipStream = new io::GzipOutputStream(wrappedFileStream);
+            zeroCopyStream = gzipStream;
+        } else {
+            zeroCopyStream = wrappedFileStream;
+        }
     }
 
     // Write the magic number to the file
@@ -74,6 +330,7 @@ ProtoOutputStream::~ProtoOutputStream()
     // As the compression is optional, see if the stream exists
     if (gzipStream != NULL)
         delete gzipStream;
+    delete chunkedStream;
     delete wrappedFileStream;
     fileStream.close();
 }
@@ -81,35 +338,46 @@ ProtoOutputStream::~ProtoOutputStream()
 void
 ProtoOutputStream::write(const Message& msg)
 {
-    // Due to the byte limit of the coded stream we create it for
-    // every single mesage (based on forum discussions around the size
-    // limitation)
-    io::CodedOutputStream codedStream(zeroCopyStream);
+    {
+        // Due to the byte limit of the coded stream we create it for
+        // every single mesage (based on forum discussions around the
+        // size limitation)
+        io::CodedOutputStream codedStream(zeroCopyStream);
+
+        // Write the size of the message to the stream
+#       if GOOGLE_PROTOBUF_VERSION < 3001000
+            auto msg_size = msg.ByteSize();
+#       else
+            auto msg_size = msg.ByteSizeLong();
+#       endif
+        codedStream.WriteVarint32(msg_size);
 
-    // Write the size of the message to the stream
-#   if GOOGLE_PROTOBUF_VERSION < 3001000
-        auto msg_size = msg.ByteSize();
-#   else
-        auto msg_size = msg.ByteSizeLong();
-#   endif
-    codedStream.WriteVarint32(msg_size);
+        // Write the message itself to the stream
+        msg.SerializeWithCachedSizes(&codedStream);
+    }
 
-    // Write the message itself to the stream
-    msg.SerializeWithCachedSizes(&codedStream);
+    // The coded stream hands back the buffer it did not use when it
+    // is destroyed, so a chunked container can now end its chunk
+    // after this message
+    if (chunkedStream)
+        chunkedStream->endMessage();
 }
 
 ProtoInputStream::ProtoInputStream(const string& filename) :
     fileStream(filename.c_str(), ios::in | ios::binary), fileName(filename),
-    useGzip(false),
-    wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
+    useGzip(false), useChunks(false),
+    wrappedFileStream(NULL), gzipStream(NULL), chunkedStream(NULL),
+    zeroCopyStream(NULL)
 {
     if (!fileStream.good())
         panic("Could not open %s for reading\n", filename);
 
-    // check the magic number to see if this is a gzip stream
-    unsigned char bytes[2];
-    fileStream.read((char*) bytes, 2);
+    // check the magic number to see if this is a gzip stream or a
+    // chunked container
+    unsigned char bytes[4];
+    fileStream.read((char*) bytes, 4);
     useGzip = fileStream.good() && bytes[0] == 0x1f && bytes[1] == 0x8b;
+    useChunks = fileStream.good() && ChunkedStream::isChunked(bytes);
 
     // seek to the start of the input file and clear any flags
     fileStream.clear();
@@ -123,19 +391,31 @@ ProtoInputStream::createStreams()
 {
     // All streams should be NULL at this point
     assert(wrappedFileStream == NULL && gzipStream == NULL &&
-           zeroCopyStream == NULL);
+           chunkedStream == NULL && zeroCopyStream == NULL);
 
     // Wrap the input file in a zero copy stream, that in turn is
-    // wrapped in a gzip stream if the filename ends with .gz. The
-    // latter stream is in turn wrapped in a coded stream
-    wrappedFileStream = new io::IstreamInputStream(&fileStream);
-    if (useGzip) {
-        gzipStream = new io::GzipInputStream(wrappedFileStream);
-        zeroCopyStream = gzipStream;
+    // wrapped in a gzip stream if the file starts with the gzip magic
+    // number. The latter stream is in turn wrapped in a coded
+    // stream. A chunked container reads the file directly.
+    if (useChunks) {
+        chunkedStream = new ChunkedInputStream(&fileStream, fileName);
+        zeroCopyStream = chunkedStream;
     } else {
-        zeroCopyStream = wrappedFileStream;
+        wrappedFileStream = new io::IstreamInputStream(&fileStream);
+        if (useGzip) {
+            gzipStream = new io::GzipInputStream(wrappedFileStream);
+            zeroCopyStream = gzipStream;
+        } else {
+            zeroCopyStream = wrappedFileStream;
+        }
     }
 
+    checkMagic();
+}
+
+void
+ProtoInputStream::checkMagic()
+{
     uint32_t magic_check;
     io::CodedInputStream codedStream(zeroCopyStream);
     if (!codedStream.ReadLittleEndian32(&magic_check) ||
@@ -152,6 +432,8 @@ ProtoInputStream::destroyStreams()
         delete gzipStream;
         gzipStream = NULL;
     }
+    delete chunkedStream;
+    chunkedStream = NULL;
     delete wrappedFileStream;
     wrappedFileStream = NULL;
 
@@ -176,6 +458,32 @@ ProtoInputStream::reset()
     createStreams();
 }
 
+size_t
+ProtoInputStream::numChunks() const
+{
+    return chunkedStream ? chunkedStream->numChunks() : 0;
+}
+
+uint64_t
+ProtoInputStream::chunkFirstMessage(size_t chunk) const
+{
+    assert(chunk < numChunks());
+    return chunkedStream->chunkFirstMessage(chunk);
+}
+
+void
+ProtoInputStream::seekChunk(size_t chunk)
+{
+    if (chunk >= numChunks())
+        panic("Cannot seek to chunk %d of %s, which has %d chunks\n",
+              chunk, fileName, numChunks());
+
+    chunkedStream->seek(chunk);
+    // The magic number is in front of the first message
+    if (chunk == 0)
+        checkMagic();
+}
+
 bool
 ProtoInputStream::read(Message& msg)
 {
@@ -49,7 +49,207 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/message.h>
 
+#include <cstdint>
 #include <fstream>
+#include <vector>
+
+/**
+ * A chunked trace container splits the stream into chunks that are
+ * compressed independently. Each chunk starts at a message boundary,
+ * and an index of the chunks is written as a footer, so that a reader
+ * can start decoding at any chunk, and several readers can decode
+ * different chunks of the same trace in parallel.
+ *
+ * The container starts with a header, containing its own magic number
+ * and the nominal chunk size. Each chunk is stored as the size of the
+ * compressed data, the size of the uncompressed data and the zlib
+ * compressed data itself. The index follows the last chunk, with the
+ * file offset of each chunk and the number of the first message in
+ * it. A trailer at the very end of the file holds the offset of the
+ * index, the number of chunks and the magic number again. All the
+ * fields are little endian.
+ */
+class ChunkedStream
+{
+  protected:
+
+    /// Use the ASCII characters g5ck as the container magic number
+    static const uint32_t containerMagic = 0x6b633567;
+
+    /// Version of the container format
+    static const uint32_t containerVersion = 1;
+
+    /// Size of the container header and trailer in bytes
+    static const size_t headerSize = 12;
+    static const size_t trailerSize = 20;
+
+    /// Size of the chunk header, and of an index entry, in bytes
+    static const size_t chunkHeaderSize = 8;
+    static const size_t indexEntrySize = 16;
+
+    /// Location of a chunk in the container
+    struct ChunkInfo
+    {
+        /// Offset of the chunk header in the file
+        uint64_t offset;
+        /// Number of the first message starting in the chunk
+        uint64_t firstMessage;
+    };
+
+    /// Index of the chunks in the container
+    std::vector<ChunkInfo> index;
+
+  public:
+
+    /**
+     * Check if a file starts with the container magic number.
+     *
+     * @param bytes The first four bytes of the file
+     */
+    static bool isChunked(const unsigned char *bytes);
+};
+
+/**
+ * A zero-copy output stream writing a chunked trace container. The
+ * data written is buffered until the end of a message that fills the
+ * current chunk, and the index is written when the stream is closed.
+ */
+class ChunkedOutputStream : public ChunkedStream,
+                            public google::protobuf::io::ZeroCopyOutputStream
+{
+  public:
+
+    /**
+     * Start a container on an output stream.
+     *
+     * @param stream Stream to write the container to
+     * @param chunk_size Number of uncompressed bytes after which a
+     *                   chunk is ended at the next message boundary
+     */
+    ChunkedOutputStream(std::ostream *stream, size_t chunk_size);
+
+    /**
+     * Close the container, if not done already.
+     */
+    ~ChunkedOutputStream();
+
+    bool Next(void** data, int* size) override;
+    void BackUp(int count) override;
+    int64_t ByteCount() const override;
+
+    /**
+     * Mark the end of a message. The current chunk is compressed and
+     * written out if it is full.
+     */
+    void endMessage();
+
+    /**
+     * Write out the last chunk and the index.
+     */
+    void close();
+
+  private:
+
+    /**
+     * Compress and write out the current chunk, if not empty.
+     */
+    void writeChunk();
+
+    /// Stream the container is written to
+    std::ostream *stream;
+
+    /// Nominal size of the chunks
+    const size_t chunkSize;
+
+    /// Uncompressed data of the current chunk
+    std::vector<uint8_t> buffer;
+    /// Number of bytes of the buffer holding data
+    size_t used;
+
+    /// Buffer for the compressed chunk
+    std::vector<uint8_t> compressed;
+
+    /// Offset of the next chunk in the file
+    uint64_t offset;
+    /// Number of bytes written to chunks so far
+    uint64_t bytesWritten;
+    /// Number of messages ended so far
+    uint64_t numMessages;
+    /// Number of the first message of the current chunk
+    uint64_t chunkMessage;
+
+    /// True once the index has been written
+    bool closed;
+};
+
+/**
+ * A zero-copy input stream reading a chunked trace container, one
+ * chunk at a time.
+ */
+class ChunkedInputStream : public ChunkedStream,
+                           public google::protobuf::io::ZeroCopyInputStream
+{
+  public:
+
+    /**
+     * Open a container and read its index.
+     *
+     * @param stream Stream to read the container from
+     * @param name Name of the file for error messages
+     */
+    ChunkedInputStream(std::istream *stream, const std::string &name);
+
+    bool Next(const void** data, int* size) override;
+    void BackUp(int count) override;
+    bool Skip(int count) override;
+    int64_t ByteCount() const override;
+
+    /** Number of chunks in the container */
+    size_t numChunks() const { return index.size(); }
+
+    /** Number of the first message starting in a chunk */
+    uint64_t
+    chunkFirstMessage(size_t chunk) const
+    {
+        return index[chunk].firstMessage;
+    }
+
+    /**
+     * Continue reading at the start of a chunk.
+     *
+     * @param chunk Number of the chunk
+     */
+    void seek(size_t chunk);
+
+  private:
+
+    /**
+     * Read and decompress the next chunk.
+     *
+     * @return False if there are no more chunks
+     */
+    bool readChunk();
+
+    /// Stream the container is read from
+    std::istream *stream;
+
+    /// Name of the file for error messages
+    const std::string name;
+
+    /// Number of the next chunk to read
+    size_t nextChunk;
+
+    /// Uncompressed data of the current chunk
+    std::vector<uint8_t> buffer;
+    /// Number of bytes of the buffer handed out
+    size_t pos;
+
+    /// Buffer for the compressed chunk
+    std::vector<uint8_t> compressed;
+
+    /// Number of bytes in the chunks before the current one
+    int64_t bytesBefore;
+};
 
 /**
  * A ProtoStream provides the shared functionality of the input and
@@ -86,6 +286,10 @@ class ProtoStream
  * basis to avoid having to deal with huge data structures. The latter
  * is made possible by encoding the length of each message in the
  * stream.
+ *
+ * A file name ending with .gz gives a single gzip stream, and a file
+ * name ending with .pbz gives a chunked container (see ChunkedStream)
+ * that can be read from any chunk.
  */
 class ProtoOutputStream : public ProtoStream
 {
@@ -94,12 +298,16 @@ class ProtoOutputStream : public ProtoStream
 
     /**
      * Create an output stream for a given file name. If the filename
-     * ends with .gz then the file will be compressed accordinly.
+     * ends with .gz or .pbz then the file will be compressed
+     * accordinly.
      *
      * @param filename Path to the file to create or truncate
      */
     ProtoOutputStream(const std::string& filename);
 
+    /// Uncompressed size of the chunks of a chunked container
+    static const size_t chunkSize = 1 << 20;
+
     /**
      * Destruct the output stream, and also flush and close the
      * underlying file streams and coded streams.
@@ -125,6 +333,9 @@ class ProtoOutputStream : public ProtoStream
     /// Optional Gzip stream to wrap the Zero Copy stream
     google::protobuf::io::GzipOutputStream* gzipStream;
 
+    /// Optional chunked container stream to wrap the file stream
+    ChunkedOutputStream* chunkedStream;
+
     /// Top-level zero-copy stream, either with compression or not
     google::protobuf::io::ZeroCopyOutputStream* zeroCopyStream;
 
@@ -132,10 +343,13 @@ class ProtoOutputStream : public ProtoStream
 
 /**
  * A ProtoInputStream wraps a coded stream, potentially with
- * decompression, based on looking at the file name. Reading from the
- * stream is done on a per-message basis to avoid having to deal with
- * huge data structures. The latter assumes the length of each message
- * is encoded in the stream when it is written.
+ * decompression, based on looking at the start of the file. Reading
+ * from the stream is done on a per-message basis to avoid having to
+ * deal with huge data structures. The latter assumes the length of
+ * each message is encoded in the stream when it is written.
+ *
+ * When the file is a chunked container, the stream can also be
+ * positioned at the start of any chunk.
  */
 class ProtoInputStream : public ProtoStream
 {
@@ -169,8 +383,34 @@ class ProtoInputStream : public ProtoStream
      */
     void reset();
 
+    /**
+     * Number of chunks in the file, which is 0 if the file is not a
+     * chunked container and cannot be seeked into.
+     */
+    size_t numChunks() const;
+
+    /**
+     * Number of the first message starting in a chunk, counting the
+     * messages from the start of the file.
+     *
+     * @param chunk Number of the chunk, less than numChunks()
+     */
+    uint64_t chunkFirstMessage(size_t chunk) const;
+
+    /**
+     * Continue reading at the first message of a chunk.
+     *
+     * @param chunk Number of the chunk, less than numChunks()
+     */
+    void seekChunk(size_t chunk);
+
   private:
 
+    /**
+     * Read and check the magic number at the start of the stream.
+     */
+    void checkMagic();
+
     /**
      * Create the internal streams that are wrapping the input file.
      */
@@ -190,12 +430,18 @@ class ProtoInputStream : public ProtoStream
     /// Boolean flag to remember whether we use gzip or not
     bool useGzip;
 
+    /// Boolean flag to remember whether the file is a chunked container
+    bool useChunks;
+
     /// Zero Copy stream wrapping the STL input stream
     google::protobuf::io::IstreamInputStream* wrappedFileStream;
 
     /// Optional Gzip stream to wrap the Zero Copy stream
     google::protobuf::io::GzipInputStream* gzipStream;
 
+    /// Optional chunked container stream to wrap the file stream
+    ChunkedInputStream* chunkedStream;
+
     /// Top-level zero-copy stream, either with compression or not
     google::protobuf::io::ZeroCopyInputStream* zeroCopyStream;
 
@@ -87,6 +87,14 @@ class System(SimObject):
         "use to directly address the backstore from another host-OS process. "
         "Leave this empty to unset the MAP_SHARED flag.")
 
+    # Checkpoint the backing store as an uncompressed, sparse image
+    # rather than a gzip file. When restoring, such an image is mapped
+    # copy-on-write instead of being read in, so that many simulations
+    # restoring from the same checkpoint share the page cache and only
+    # pay for the pages they write to.
+    mmap_memory_image = Param.Bool(False, "Checkpoint the backing store "
+        "as an uncompressed image that is mapped on restore")
+
     cache_line_size = Param.Unsigned(64, "Cache line size in bytes")
 
     byte_order = Param.ByteOrder(default_byte_order,
@@ -112,7 +112,7 @@ EventQueue::insert(Event *event)
 {
     // Deal with the head case
     if (!head || *event <= *head) {
-        head = Event::insertBefore(event, head);
+        setHead(Event::insertBefore(event, head));
         return;
     }
 
@@ -172,7 +172,7 @@ EventQueue::remove(Event *event)
     // deal with an event on the head's 'in bin' list (event has the same
     // time as the head)
     if (*head == *event) {
-        head = Event::removeItem(event, head);
+        setHead(Event::removeItem(event, head));
         return;
     }
 
@@ -206,11 +206,11 @@ EventQueue::serviceOne()
         next->nextBin = head->nextBin;
 
         // pop the stack
-        head = next;
+        setHead(next);
     } else {
         // this was the only element on the 'in bin' list, so get rid of
         // the 'in bin' list and point to the next bin list
-        head = head->nextBin;
+        setHead(head->nextBin);
     }
 
     // handle action
@@ -355,7 +355,7 @@ Event*
 EventQueue::replaceHead(Event* s)
 {
     Event* t = head;
-    head = s;
+    setHead(s);
     return t;
 }
 
@@ -419,28 +419,49 @@ Event::dump() const
 }
 
 EventQueue::EventQueue(const string &n)
-    : objName(n), head(NULL), _curTick(0)
+    : objName(n), head(NULL), _curTick(0), headTick(MaxTick),
+      async_queue(nullptr), asyncInserted(0), asyncBatches(0)
 {
 }
 
 void
 EventQueue::asyncInsert(Event *event)
 {
-    async_queue_mutex.lock();
-    async_queue.push_back(event);
-    async_queue_mutex.unlock();
+    Event *top = async_queue.load(std::memory_order_relaxed);
+    do {
+        event->nextBin = top;
+    } while (!async_queue.compare_exchange_weak(top, event,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
 }
 
 void
 EventQueue::handleAsyncInsertions()
 {
     assert(this == curEventQueue());
-    async_queue_mutex.lock();
 
-    while (!async_queue.empty()) {
-        insert(async_queue.front());
-        async_queue.pop_front();
+    if (!asyncPending())
+        return;
+
+    Event *top = async_queue.exchange(nullptr, std::memory_order_acquire);
+    if (!top)
+        return;
+
+    // The stack holds the newest event first, reverse it so that the
+    // events are inserted in the order they were scheduled in.
+    Event *oldest = nullptr;
+    while (top) {
+        Event *next = top->nextBin;
+        top->nextBin = oldest;
+        oldest = top;
+        top = next;
     }
 
-    async_queue_mutex.unlock();
+    while (oldest) {
+        Event *next = oldest->nextBin;
+        insert(oldest);
+        oldest = next;
+        ++asyncInserted;
+    }
+    ++asyncBatches;
 }
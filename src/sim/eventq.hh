@@ -36,6 +36,7 @@
 #define __SIM_EVENTQ_HH__
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <functional>
@@ -613,6 +614,12 @@ operator!=(const Event &l, const Event &r)
  * events must happen at least one simulation quantum into the future,
  * otherwise they risk being scheduled in the past by
  * handleAsyncInsertions().
+ *
+ * The asynchronous queue is a lock-free stack linked through the
+ * events' own nextBin pointers, which are unused until the event is
+ * inserted in the main queue. Any number of threads may push onto it,
+ * and only the owning thread takes the whole stack off at once and
+ * merges it in the order in which the events were pushed.
  */
 class EventQueue
 {
@@ -621,11 +628,26 @@ class EventQueue
     Event *head;
     Tick _curTick;
 
-    //! Mutex to protect async queue.
-    std::mutex async_queue_mutex;
+    //! Tick of the head event (MaxTick if the queue is empty), published
+    //! for threads that read it without holding the queue's lock.
+    std::atomic<Tick> headTick;
 
-    //! List of events added by other threads to this event queue.
-    std::list<Event*> async_queue;
+    void
+    setHead(Event *event)
+    {
+        head = event;
+        headTick.store(event ? event->when() : MaxTick,
+                       std::memory_order_relaxed);
+    }
+
+    //! Most recent event added by other threads to this event queue,
+    //! the earlier ones follow through their nextBin pointers.
+    std::atomic<Event *> async_queue;
+
+    //! Number of events merged from async_queue, and the number of
+    //! times it was found non-empty. Only updated by the owning thread.
+    uint64_t asyncInserted;
+    uint64_t asyncBatches;
 
     /**
      * Lock protecting event handling.
@@ -769,13 +791,18 @@ class EventQueue
         //    this event belongs to this eventq. This is required to maintain
         //    a total order amongst the global events. See global_event.{cc,hh}
         //    for more explanation.
+        //
+        // The event is marked as scheduled first since, once it is on
+        // the asyncq, it may be picked up by the owning thread at any
+        // time.
+        event->flags.set(Event::Scheduled);
+        event->acquire();
+
         if (inParallelMode && (this != curEventQueue() || global)) {
             asyncInsert(event);
         } else {
             insert(event);
         }
-        event->flags.set(Event::Scheduled);
-        event->acquire();
 
         if (DTRACE(Event))
             event->trace("scheduled");
@@ -834,6 +861,17 @@ class EventQueue
     }
 
     Tick nextTick() const { return head->when(); }
+
+    /**
+     * Tick of the next event, or MaxTick if there is none. Unlike
+     * nextTick(), this may be called without holding the queue's lock,
+     * but it is only a hint when other threads are scheduling events.
+     */
+    Tick
+    nextTickHint() const
+    {
+        return headTick.load(std::memory_order_relaxed);
+    }
     void setCurTick(Tick newVal) { _curTick = newVal; }
 
     /**
@@ -905,6 +943,24 @@ class EventQueue
      */
     void handleAsyncInsertions();
 
+    /**
+     * Check if there are events waiting in the async_queue. This is
+     * only a hint when other threads are still inserting events.
+     */
+    bool
+    asyncPending() const
+    {
+        return async_queue.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    /**
+     * Number of events this queue has received from other threads
+     * (or as global events) since the start of the simulation, and
+     * the number of batches in which they were merged.
+     */
+    uint64_t asyncInsertions() const { return asyncInserted; }
+    uint64_t asyncInsertionBatches() const { return asyncBatches; }
+
     /**
      *  Function to signal that the event loop should be woken up because
      *  an event has been scheduled by an agent outside the gem5 event
@@ -65,7 +65,7 @@ MemState::operator=(const MemState &in)
     _nextThreadStackBase = in._nextThreadStackBase;
     _mmapEnd = in._mmapEnd;
     _endBrkPoint = in._endBrkPoint;
-    _vmaList = in._vmaList; /* This assignment does a deep copy. */
+    _vmas = in._vmas; /* This assignment does a deep copy. */
 
     return *this;
 }
@@ -76,27 +76,36 @@ MemState::resetOwner(Process *owner)
     _ownerProcess = owner;
 }
 
+std::map<Addr, VMA>::iterator
+MemState::firstVma(Addr addr)
+{
+    auto vma = _vmas.upper_bound(addr);
+    if (vma != _vmas.begin()) {
+        auto prev = std::prev(vma);
+        if (prev->second.end() > addr)
+            return prev;
+    }
+    return vma;
+}
+
 bool
 MemState::isUnmapped(Addr start_addr, Addr length)
 {
     Addr end_addr = start_addr + length;
-    const AddrRange range(start_addr, end_addr);
-    for (const auto &vma : _vmaList) {
-        if (vma.intersects(range))
-            return false;
-    }
+    auto vma = firstVma(start_addr);
+    if (vma != _vmas.end() && vma->second.start() < end_addr)
+        return false;
 
     /**
      * In case someone skips the VMA interface and just directly maps memory
      * also consult the page tables to make sure that this memory isnt mapped.
      */
-    for (auto start = start_addr; start < end_addr;
-         start += _pageBytes) {
-        if (_ownerProcess->pTable->lookup(start) != nullptr) {
-            panic("Someone allocated physical memory at VA %p without "
-                  "creating a VMA!\n", start);
-            return false;
-        }
+    Addr page_start = roundDown(start_addr, _pageBytes);
+    if (!_ownerProcess->pTable->isUnmapped(page_start,
+                                           end_addr - page_start)) {
+        panic("Someone allocated physical memory in VA range [%p - %p] "
+              "without creating a VMA!\n", start_addr, end_addr);
+        return false;
     }
     return true;
 }
@@ -174,80 +183,112 @@ MemState::mapRegion(Addr start_addr, Addr length,
     assert(isUnmapped(start_addr, length));
 
     /**
-     * Record the region in our list structure.
+     * Record the region in our map of VMAs.
      */
-    _vmaList.emplace_back(AddrRange(start_addr, start_addr + length),
-                          _pageBytes, region_name, sim_fd, offset);
+    _vmas.emplace(start_addr,
+                  VMA(AddrRange(start_addr, start_addr + length),
+                      _pageBytes, region_name, sim_fd, offset));
 }
 
 void
-MemState::unmapRegion(Addr start_addr, Addr length)
+MemState::carveVmas(Addr start_addr, Addr end_addr,
+                    std::vector<VMA> *removed)
 {
-    Addr end_addr = start_addr + length;
     const AddrRange range(start_addr, end_addr);
 
-    auto vma = std::begin(_vmaList);
-    while (vma != std::end(_vmaList)) {
-        if (vma->isStrictSuperset(range)) {
+    /**
+     * Only the run of VMAs starting at the one that ends after start_addr
+     * and stopping before the first one at or beyond end_addr can
+     * intersect the range.
+     */
+    auto vma_it = firstVma(start_addr);
+    while (vma_it != _vmas.end() && vma_it->second.start() < end_addr) {
+        VMA &vma = vma_it->second;
+
+        if (vma.isStrictSuperset(range)) {
             DPRINTF(Vma, "memstate: split vma [0x%x - 0x%x] into "
                     "[0x%x - 0x%x] and [0x%x - 0x%x]\n",
-                    vma->start(), vma->end(),
-                    vma->start(), start_addr,
-                    end_addr, vma->end());
+                    vma.start(), vma.end(),
+                    vma.start(), start_addr,
+                    end_addr, vma.end());
             /**
              * Need to split into two smaller regions.
-             * Create a clone of the old VMA and slice it to the right.
+             * Create a clone of the old VMA and slice it to the left.
              */
-            _vmaList.push_back(*vma);
-            _vmaList.back().sliceRegionRight(start_addr);
+            VMA right(vma);
+            right.sliceRegionLeft(end_addr);
+
+            if (removed) {
+                removed->push_back(vma);
+                removed->back().sliceRegionLeft(start_addr);
+                removed->back().sliceRegionRight(end_addr);
+            }
 
             /**
-             * Slice old VMA to encapsulate the left region.
+             * Slice old VMA to encapsulate the left region. Its start, and
+             * so its key, does not change.
              */
-            vma->sliceRegionLeft(end_addr);
+            vma.sliceRegionRight(start_addr);
+            _vmas.emplace_hint(std::next(vma_it), end_addr, right);
 
             /**
              * Region cannot be in any more VMA, because it is completely
              * contained in this one!
              */
             break;
-        } else if (vma->isSubset(range)) {
+        } else if (vma.isSubset(range)) {
             DPRINTF(Vma, "memstate: destroying vma [0x%x - 0x%x]\n",
-                    vma->start(), vma->end());
+                    vma.start(), vma.end());
             /**
              * Need to nuke the existing VMA.
              */
-            vma = _vmaList.erase(vma);
+            if (removed)
+                removed->push_back(vma);
+            vma_it = _vmas.erase(vma_it);
 
             continue;
-
-        } else if (vma->intersects(range)) {
+        } else if (vma.start() < start_addr) {
+            DPRINTF(Vma, "memstate: resizing vma [0x%x - 0x%x] "
+                    "into [0x%x - 0x%x]\n",
+                    vma.start(), vma.end(),
+                    vma.start(), start_addr);
             /**
-             * Trim up the existing VMA.
+             * Overlaps from the right.
              */
-            if (vma->start() < start_addr) {
-                DPRINTF(Vma, "memstate: resizing vma [0x%x - 0x%x] "
-                        "into [0x%x - 0x%x]\n",
-                        vma->start(), vma->end(),
-                        vma->start(), start_addr);
-                /**
-                 * Overlaps from the right.
-                 */
-                vma->sliceRegionRight(start_addr);
-            } else {
-                DPRINTF(Vma, "memstate: resizing vma [0x%x - 0x%x] "
-                        "into [0x%x - 0x%x]\n",
-                        vma->start(), vma->end(),
-                        end_addr, vma->end());
-                /**
-                 * Overlaps from the left.
-                 */
-                vma->sliceRegionLeft(end_addr);
+            if (removed) {
+                removed->push_back(vma);
+                removed->back().sliceRegionLeft(start_addr);
             }
+            vma.sliceRegionRight(start_addr);
+        } else {
+            DPRINTF(Vma, "memstate: resizing vma [0x%x - 0x%x] "
+                    "into [0x%x - 0x%x]\n",
+                    vma.start(), vma.end(),
+                    end_addr, vma.end());
+            /**
+             * Overlaps from the left. The start of the VMA moves, so it
+             * has to be reinserted under its new key. Nothing above it
+             * can intersect the range.
+             */
+            if (removed) {
+                removed->push_back(vma);
+                removed->back().sliceRegionRight(end_addr);
+            }
+            VMA right(vma);
+            right.sliceRegionLeft(end_addr);
+            _vmas.erase(vma_it);
+            _vmas.emplace(end_addr, right);
+            break;
         }
 
-        vma++;
+        ++vma_it;
     }
+}
+
+void
+MemState::unmapRegion(Addr start_addr, Addr length)
+{
+    carveVmas(start_addr, start_addr + length);
 
     /**
      * TLBs need to be flushed to remove any stale mappings from regions
@@ -262,93 +303,33 @@ MemState::unmapRegion(Addr start_addr, Addr length)
         tc->getITBPtr()->flushAll();
     }
 
-    do {
-        if (!_ownerProcess->pTable->isUnmapped(start_addr, _pageBytes))
-            _ownerProcess->pTable->unmap(start_addr, _pageBytes);
-
-        start_addr += _pageBytes;
-
-        /**
-         * The regions need to always be page-aligned otherwise the while
-         * condition will loop indefinitely. (The Addr type is currently
-         * defined to be uint64_t in src/base/types.hh; it can underflow
-         * since it is unsigned.)
-         */
-        length -= _pageBytes;
-    } while (length > 0);
+    /**
+     * Only the pages that are actually backed need to be unmapped; the
+     * page table hands back their runs without visiting the holes.
+     */
+    for (const auto &run :
+            _ownerProcess->pTable->mappedRanges(start_addr, length)) {
+        _ownerProcess->pTable->unmap(run.start(), run.size());
+    }
 }
 
 void
 MemState::remapRegion(Addr start_addr, Addr new_start_addr, Addr length)
 {
     Addr end_addr = start_addr + length;
-    const AddrRange range(start_addr, end_addr);
-
-    auto vma = std::begin(_vmaList);
-    while (vma != std::end(_vmaList)) {
-        if (vma->isStrictSuperset(range)) {
-            /**
-             * Create clone of the old VMA and slice right.
-             */
-            _vmaList.push_back(*vma);
-            _vmaList.back().sliceRegionRight(start_addr);
-
-            /**
-             * Create clone of the old VMA and slice it left.
-             */
-            _vmaList.push_back(*vma);
-            _vmaList.back().sliceRegionLeft(end_addr);
-
-            /**
-             * Slice the old VMA left and right to adjust the file backing,
-             * then overwrite the virtual addresses!
-             */
-            vma->sliceRegionLeft(start_addr);
-            vma->sliceRegionRight(end_addr);
-            vma->remap(new_start_addr);
-
-            /**
-             * The region cannot be in any more VMAs, because it is
-             * completely contained in this one!
-             */
-            break;
-        } else if (vma->isSubset(range)) {
-            /**
-             * Just go ahead and remap it!
-             */
-            vma->remap(vma->start() - start_addr + new_start_addr);
-        } else if (vma->intersects(range)) {
-            /**
-             * Create a clone of the old VMA.
-             */
-            _vmaList.push_back(*vma);
-
-            if (vma->start() < start_addr) {
-                /**
-                 * Overlaps from the right.
-                 */
-                _vmaList.back().sliceRegionRight(start_addr);
-
-                /**
-                 * Remap the old region.
-                 */
-                vma->sliceRegionLeft(start_addr);
-                vma->remap(new_start_addr);
-            } else {
-                /**
-                 * Overlaps from the left.
-                 */
-                _vmaList.back().sliceRegionLeft(end_addr);
-
-                /**
-                 * Remap the old region.
-                 */
-                vma->sliceRegionRight(end_addr);
-                vma->remap(new_start_addr + vma->start() - start_addr);
-            }
-        }
 
-        vma++;
+    /**
+     * Pull the pieces of the VMAs in the old range out of the map, clear
+     * out whatever is mapped at the destination (as mremap does with
+     * MREMAP_FIXED), and put the pieces back at their new addresses.
+     */
+    std::vector<VMA> moved;
+    carveVmas(start_addr, end_addr, &moved);
+    carveVmas(new_start_addr, new_start_addr + length);
+    for (auto &vma : moved) {
+        Addr new_vma_start = vma.start() - start_addr + new_start_addr;
+        vma.remap(new_vma_start);
+        _vmas.emplace(new_vma_start, vma);
     }
 
     /**
@@ -364,22 +345,17 @@ MemState::remapRegion(Addr start_addr, Addr new_start_addr, Addr length)
         tc->getITBPtr()->flushAll();
     }
 
-    do {
-        if (!_ownerProcess->pTable->isUnmapped(start_addr, _pageBytes))
-            _ownerProcess->pTable->remap(start_addr, _pageBytes,
-                                         new_start_addr);
-
-        start_addr += _pageBytes;
-        new_start_addr += _pageBytes;
+    for (const auto &run :
+            _ownerProcess->pTable->mappedRanges(new_start_addr, length)) {
+        _ownerProcess->pTable->unmap(run.start(), run.size());
+    }
 
-        /**
-         * The regions need to always be page-aligned otherwise the while
-         * condition will loop indefinitely. (The Addr type is currently
-         * defined to be uint64_t in src/base/types.hh; it can underflow
-         * since it is unsigned.)
-         */
-        length -= _pageBytes;
-    } while (length > 0);
+    for (const auto &run :
+            _ownerProcess->pTable->mappedRanges(start_addr, length)) {
+        _ownerProcess->pTable->remap(run.start(), run.size(),
+                                     run.start() - start_addr +
+                                     new_start_addr);
+    }
 }
 
 bool
@@ -389,31 +365,31 @@ MemState::fixupFault(Addr vaddr)
      * Check if we are accessing a mapped virtual address. If so then we
      * just haven't allocated it a physical page yet and can do so here.
      */
-    for (const auto &vma : _vmaList) {
-        if (vma.contains(vaddr)) {
-            Addr vpage_start = roundDown(vaddr, _pageBytes);
-            _ownerProcess->allocateMem(vpage_start, _pageBytes);
+    auto vma_it = firstVma(vaddr);
+    if (vma_it != _vmas.end() && vma_it->second.contains(vaddr)) {
+        const VMA &vma = vma_it->second;
+        Addr vpage_start = roundDown(vaddr, _pageBytes);
+        _ownerProcess->allocateMem(vpage_start, _pageBytes);
 
+        /**
+         * We are assuming that fresh pages are zero-filled, so there is
+         * no need to zero them out when there is no backing file.
+         * This assumption will not hold true if/when physical pages
+         * are recycled.
+         */
+        if (vma.hasHostBuf()) {
             /**
-             * We are assuming that fresh pages are zero-filled, so there is
-             * no need to zero them out when there is no backing file.
-             * This assumption will not hold true if/when physical pages
-             * are recycled.
+             * Write the memory for the host buffer contents for all
+             * ThreadContexts associated with this process.
              */
-            if (vma.hasHostBuf()) {
-                /**
-                 * Write the memory for the host buffer contents for all
-                 * ThreadContexts associated with this process.
-                 */
-                for (auto &cid : _ownerProcess->contextIds) {
-                    auto *tc = _ownerProcess->system->threads[cid];
-                    SETranslatingPortProxy
-                        virt_mem(tc, SETranslatingPortProxy::Always);
-                    vma.fillMemPages(vpage_start, _pageBytes, virt_mem);
-                }
+            for (auto &cid : _ownerProcess->contextIds) {
+                auto *tc = _ownerProcess->system->threads[cid];
+                SETranslatingPortProxy
+                    virt_mem(tc, SETranslatingPortProxy::Always);
+                vma.fillMemPages(vpage_start, _pageBytes, virt_mem);
             }
-            return true;
         }
+        return true;
     }
 
     /**
@@ -480,7 +456,8 @@ MemState::printVmaList()
 {
     std::stringstream file_content;
 
-    for (auto vma : _vmaList) {
+    for (auto &entry : _vmas) {
+        auto &vma = entry.second;
         std::stringstream line;
         line << std::hex << vma.start() << "-";
         line << std::hex << vma.end() << " ";
@@ -29,7 +29,7 @@
 #ifndef SRC_SIM_MEM_STATE_HH
 #define SRC_SIM_MEM_STATE_HH
 
-#include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -192,9 +192,10 @@ class MemState : public Serializable
         paramOut(cp, "mmapEnd", _mmapEnd);
 
         ScopedCheckpointSection sec(cp, "vmalist");
-        paramOut(cp, "size", _vmaList.size());
+        paramOut(cp, "size", _vmas.size());
         int count = 0;
-        for (auto vma : _vmaList) {
+        for (const auto &entry : _vmas) {
+            auto vma = entry.second;
             ScopedCheckpointSection sec(cp, csprintf("Vma%d", count++));
             paramOut(cp, "name", vma.getName());
             paramOut(cp, "addrRangeStart", vma.start());
@@ -224,7 +225,7 @@ class MemState : public Serializable
             paramIn(cp, "name", name);
             paramIn(cp, "addrRangeStart", start);
             paramIn(cp, "addrRangeEnd", end);
-            _vmaList.emplace_back(AddrRange(start, end), _pageBytes, name);
+            _vmas.emplace(start, VMA(AddrRange(start, end), _pageBytes, name));
         }
     }
 
@@ -254,18 +255,33 @@ class MemState : public Serializable
     Addr _endBrkPoint;
 
     /**
-     * The _vmaList member is a list of virtual memory areas in the target
+     * The _vmas member holds the virtual memory areas in the target
      * application space that have been allocated by the target. In most
      * operating systems, lazy allocation is used and these structures (or
      * equivalent ones) are used to track the valid address ranges.
      *
-     * This could use a more efficient data structure like an interval
-     * tree, but it is unclear whether the vmas will be modified often enough
-     * for the improvement in lookup time to matter. Unmapping VMAs currently
-     * modifies the list while iterating so the STL container must either
-     * support this or the unmapping method must be changed.
+     * The VMAs never overlap, so keeping them ordered by their start
+     * address works as an interval tree: the only VMA that can contain an
+     * address is the last one starting at or below it, and the VMAs that
+     * intersect a range are a contiguous run of the map.
      */
-    std::list<VMA> _vmaList;
+    std::map<Addr, VMA> _vmas;
+
+    /**
+     * Find the first VMA that ends after an address, i.e. the VMA
+     * containing it if there is one, or else the next VMA above it.
+     */
+    std::map<Addr, VMA>::iterator firstVma(Addr addr);
+
+    /**
+     * Remove a range from the VMAs, splitting and trimming the VMAs that
+     * straddle its edges.
+     *
+     * @param removed If not null, collects the parts of the VMAs that were
+     *                in the range, in ascending order.
+     */
+    void carveVmas(Addr start_addr, Addr end_addr,
+                   std::vector<VMA> *removed=nullptr);
 };
 
 #endif
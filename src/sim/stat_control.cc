@@ -54,6 +54,7 @@
 #include "base/statistics.hh"
 #include "base/time.hh"
 #include "cpu/base.hh"
+#include "sim/eventq.hh"
 #include "sim/global_event.hh"
 
 using namespace std;
@@ -67,6 +68,8 @@ namespace Stats {
 
 Time statTime(true);
 Tick startTick;
+uint64_t startAsyncEvents;
+uint64_t startAsyncBatches;
 
 GlobalEvent *dumpEvent;
 
@@ -92,6 +95,36 @@ statFinalTick()
     return curTick();
 }
 
+uint64_t
+totalAsyncEvents()
+{
+    uint64_t total = 0;
+    for (const EventQueue *eq : mainEventQueue)
+        total += eq->asyncInsertions();
+    return total;
+}
+
+uint64_t
+totalAsyncBatches()
+{
+    uint64_t total = 0;
+    for (const EventQueue *eq : mainEventQueue)
+        total += eq->asyncInsertionBatches();
+    return total;
+}
+
+uint64_t
+statAsyncEvents()
+{
+    return totalAsyncEvents() - startAsyncEvents;
+}
+
+uint64_t
+statAsyncBatches()
+{
+    return totalAsyncBatches() - startAsyncBatches;
+}
+
 struct Global
 {
     Stats::Formula hostInstRate;
@@ -103,6 +136,9 @@ struct Global
     Stats::Value simInsts;
     Stats::Value simOps;
 
+    Stats::Value asyncEvents;
+    Stats::Value asyncBatches;
+
     Global();
 };
 
@@ -182,6 +218,21 @@ Global::Global()
         .precision(0)
         ;
 
+    asyncEvents
+        .functor(statAsyncEvents)
+        .name("sim_async_events")
+        .desc("Number of events scheduled across event queues or as "
+              "global events")
+        .prereq(asyncEvents)
+        ;
+
+    asyncBatches
+        .functor(statAsyncBatches)
+        .name("sim_async_event_batches")
+        .desc("Number of batches in which cross-queue events were merged")
+        .prereq(asyncBatches)
+        ;
+
     simSeconds = simTicks / simFreq;
     hostInstRate = simInsts / hostSeconds;
     hostOpRate = simOps / hostSeconds;
@@ -190,6 +241,8 @@ Global::Global()
     registerResetCallback([]() {
         statTime.setTimer();
         startTick = curTick();
+        startAsyncEvents = totalAsyncEvents();
+        startAsyncBatches = totalAsyncBatches();
     });
 }
 
@@ -318,8 +318,9 @@ start_func "switch" $SW_HOST "$ENV_ARGS" $GEM5_EXE -d $RUN_DIR/m5out.switch   \
 SW_PID=$!
 
 # block here till switch process starts
-connected $RUN_DIR/log.switch "tcp_iface listening on port" "switch" $SW_PID
-LINE=$(grep -r "tcp_iface listening on port" $RUN_DIR/log.switch)
+# (tcp_iface or shm_iface, depending on --dist-transport)
+connected $RUN_DIR/log.switch "_iface listening on port" "switch" $SW_PID
+LINE=$(grep -r "_iface listening on port" $RUN_DIR/log.switch)
 
 IFS=' ' read -ra ADDR <<< "$LINE"
 # actual port that switch is listening on may be different
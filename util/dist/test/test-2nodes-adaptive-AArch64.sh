@@ -0,0 +1,115 @@
+#! /bin/bash
+
+#
+# Copyright (c) 2026 The gem-forge contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# This script checks the adaptive dist-gem5 synchronisation
+# (--dist-sync-adaptive). It runs the same two node ping as
+# test-2nodes-AArch64.sh twice, once with the fixed sync quantum and once
+# with the adaptive one. The synchronisation starts early in the boot, so
+# that the processes go through many (stretched) quanta before and while the
+# nodes talk to each other. The test passes if:
+#  - both runs exit normally, and all the gem5 processes of the adaptive run
+#    complete more than one periodic sync,
+#  - the simulated results are identical: sim_ticks and the NIC packet and
+#    byte counts of every gem5 process match between the two runs.
+
+GEM5_DIR=$(pwd)/$(dirname $0)/../../..
+
+IMG=$M5_PATH/disks/aarch64-ubuntu-trusty-headless.img
+VMLINUX=$M5_PATH/binaries/vmlinux.aarch64.20140821
+DTB=$M5_PATH/binaries/vexpress.aarch64.20140821.dtb
+
+FS_CONFIG=$GEM5_DIR/configs/example/fs.py
+SW_CONFIG=$GEM5_DIR/configs/dist/sw.py
+GEM5_EXE=$GEM5_DIR/build/ARM/gem5.opt
+
+BOOT_SCRIPT=$GEM5_DIR/util/dist/test/simple_bootscript.rcS
+GEM5_DIST_SH=$GEM5_DIR/util/dist/gem5-dist.sh
+
+# The DistEthernet flag reports every periodic sync that completed
+DEBUG_FLAGS="--debug-flags=DistEthernet"
+
+NNODES=2
+
+# run_dist RUN_DIR [SYNC_ARGS...]
+run_dist ()
+{
+    local RUN_DIR=$1
+    shift 1
+    $GEM5_DIST_SH -n $NNODES                                                 \
+                  -r $RUN_DIR                                                \
+                  -c $RUN_DIR                                                \
+                  -x $GEM5_EXE                                               \
+                  -s $SW_CONFIG                                              \
+                  -f $FS_CONFIG                                              \
+                  --m5-args                                                  \
+                     $DEBUG_FLAGS                                            \
+                  --fs-args                                                  \
+                      --cpu-type=atomic                                      \
+                      --num-cpus=1                                           \
+                      --machine-type=VExpress_EMM64                          \
+                      --disk-image=$IMG                                      \
+                      --kernel=$VMLINUX                                      \
+                      --dtb-filename=$DTB                                    \
+                      --script=$BOOT_SCRIPT                                  \
+                  --cf-args                                                  \
+                      --dist-sync-start=1000000000t                          \
+                      "$@"                                                   \
+        | tee $RUN_DIR.out
+    grep -q "^EXIT" $RUN_DIR.out ||                                           \
+        { echo "FAILED: dist run in $RUN_DIR aborted"; exit 1; }
+}
+
+# The simulated results of a gem5 process
+results ()
+{
+    awk '$1 == "sim_ticks" || $1 ~ /ethernet\.(tx|rx)(Packets|Bytes)$/ {
+             print $1, $2
+         }' $1/stats.txt
+}
+
+FIXED_DIR=$(pwd)/dist-fixed-run
+ADAPTIVE_DIR=$(pwd)/dist-adaptive-run
+
+run_dist $FIXED_DIR
+run_dist $ADAPTIVE_DIR --dist-sync-adaptive
+
+for m5out in m5out.switch $(seq -f "m5out.%g" 0 $((NNODES - 1)))
+do
+    diff <(results $FIXED_DIR/$m5out) <(results $ADAPTIVE_DIR/$m5out) ||     \
+        { echo "FAILED: $m5out results differ"; exit 1; }
+done
+
+for log in $ADAPTIVE_DIR/log.switch                                           \
+           $(seq -f "$ADAPTIVE_DIR/log.%g" 0 $((NNODES - 1)))
+do
+    NSYNC=$(grep -c "Next dist sync at" $log)
+    ((NSYNC > 1)) || { echo "FAILED: $log completed $NSYNC syncs"; exit 1; }
+done
+
+echo "PASSED"
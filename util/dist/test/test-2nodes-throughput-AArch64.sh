@@ -0,0 +1,84 @@
+#! /bin/bash
+
+#
+# Copyright (c) 2026 The gem-forge contributors
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# This script runs the dist-gem5 network throughput microbenchmark
+# (util/dist/test/throughput_bootscript.rcS) on two AArch64 nodes. Rank 0
+# sends TRANSFER_MB MiB (64 by default, e.g. "TRANSFER_MB=256 $0") to rank 1
+# over TCP. The stats are reset right before the transfer and dumped right
+# after it. The script then reports, for the transfer only:
+#  - host_seconds and host_tick_rate: the host cost of moving the stream
+#    through the Ethernet models, the switch and the dist-gem5 transport,
+#    which is what to compare between gem5 builds,
+#  - sim_ticks and the NIC packet/byte counts: the simulated work, which has
+#    to be the same for the comparison to be meaningful.
+
+GEM5_DIR=$(pwd)/$(dirname $0)/../../..
+
+IMG=$M5_PATH/disks/aarch64-ubuntu-trusty-headless.img
+VMLINUX=$M5_PATH/binaries/vmlinux.aarch64.20140821
+DTB=$M5_PATH/binaries/vexpress.aarch64.20140821.dtb
+
+FS_CONFIG=$GEM5_DIR/configs/example/fs.py
+SW_CONFIG=$GEM5_DIR/configs/dist/sw.py
+GEM5_EXE=$GEM5_DIR/build/ARM/gem5.opt
+
+BOOT_SCRIPT=$GEM5_DIR/util/dist/test/throughput_bootscript.rcS
+GEM5_DIST_SH=$GEM5_DIR/util/dist/gem5-dist.sh
+
+RUN_DIR=$(pwd)/dist-throughput-run
+[ -n "$TRANSFER_MB" ] || TRANSFER_MB=64
+
+NNODES=2
+
+$GEM5_DIST_SH -n $NNODES                                                     \
+              -r $RUN_DIR                                                    \
+              -c $RUN_DIR                                                    \
+              -x $GEM5_EXE                                                   \
+              -s $SW_CONFIG                                                  \
+              -f $FS_CONFIG                                                  \
+              --fs-args                                                      \
+                  --cpu-type=atomic                                          \
+                  --num-cpus=1                                               \
+                  --machine-type=VExpress_EMM64                              \
+                  --disk-image=$IMG                                          \
+                  --kernel=$VMLINUX                                          \
+                  --dtb-filename=$DTB                                        \
+                  --script=$BOOT_SCRIPT                                      \
+                  --init-param=$TRANSFER_MB                                  \
+    | tee $RUN_DIR.out
+
+grep -q "^EXIT" $RUN_DIR.out || { echo "FAILED: dist run aborted"; exit 1; }
+
+# The first dump in stats.txt is the one taken right after the transfer
+STATS=$RUN_DIR/m5out.0/stats.txt
+echo "Transfer of $TRANSFER_MB MiB:"
+awk '/End Simulation Statistics/ { exit }
+     $1 ~ /^(host_seconds|host_tick_rate|sim_ticks)$/ ||
+     $1 ~ /ethernet\.(tx|rx)(Packets|Bytes)$/ { print "    " $1, $2 }' \
+    $STATS